@@ -9,6 +9,36 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/program_options.hpp>
 
+namespace
+{
+/** Prints the single thread hash rate of every work kernel this CPU supports */
+void profile_kernels (chratos::block_hash const & root_a)
+{
+	std::cerr << "Kernel hash rates\n";
+	for (auto kernel : { chratos::work_kernel::scalar, chratos::work_kernel::avx2, chratos::work_kernel::avx512 })
+	{
+		if (chratos::work_kernel_supported (kernel))
+		{
+			std::array<uint64_t, chratos::work_kernel_batch> nonces;
+			std::array<uint64_t, chratos::work_kernel_batch> values;
+			uint64_t const batches (1000000);
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			for (uint64_t t (0); t < batches; ++t)
+			{
+				for (size_t j (0); j < nonces.size (); ++j)
+				{
+					nonces[j] = t * nonces.size () + j;
+				}
+				chratos::work_kernel_values (kernel, root_a, nonces.data (), values.data ());
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			auto us (std::max<uint64_t> (1, std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ()));
+			std::cerr << boost::str (boost::format ("%|1$-8s| %|2$ 12d| hashes/s\n") % chratos::work_kernel_name (kernel) % (batches * chratos::work_kernel_batch * 1000000 / us));
+		}
+	}
+}
+}
+
 int main (int argc, char * const * argv)
 {
 	chratos::set_umask ();
@@ -33,6 +63,9 @@ int main (int argc, char * const * argv)
 		("debug_verify_profile", "Profile signature verification")
 		("debug_verify_profile_batch", "Profile batch signature verification")
 		("debug_profile_sign", "Profile signature generation")
+		("debug_profile_codecs", "Profile hex and account encoding and decoding")
+		("debug_profile_network", "Profile UDP packet throughput over loopback")
+		("debug_profile_udp_buffer", "Profile UDP buffer throughput with concurrent producers and consumers")
 		("debug_profile_process", "Profile active blocks processing (only for chratos_test_network)")
 		("debug_validate_blocks", "Check all blocks for correct hash, signature, work value")
 		("platform", boost::program_options::value<std::string> (), "Defines the <platform> for OpenCL commands")
@@ -180,7 +213,8 @@ int main (int argc, char * const * argv)
 		{
 			chratos::work_pool work (std::numeric_limits<unsigned>::max (), nullptr);
 			chratos::state_block block (0, 0, 0, 0, 0, 0, chratos::keypair ().prv, 0, 0);
-			std::cerr << "Starting generation profiling\n";
+			profile_kernels (block.root ());
+			std::cerr << boost::str (boost::format ("Starting generation profiling with %1% kernel\n") % chratos::work_kernel_name (work.kernel));
 			for (uint64_t i (0); true; ++i)
 			{
 				block.hashables.previous.qwords[0] += 1;
@@ -285,6 +319,7 @@ int main (int argc, char * const * argv)
 		{
 			chratos::work_pool work (std::numeric_limits<unsigned>::max (), nullptr);
 			chratos::state_block block (0, 0, 0, 0, 0, 0, chratos::keypair ().prv, 0, 0);
+			profile_kernels (block.root ());
 			std::cerr << "Starting verification profiling\n";
 			for (uint64_t i (0); true; ++i)
 			{
@@ -349,6 +384,128 @@ int main (int argc, char * const * argv)
 				std::cerr << boost::str (boost::format ("%|1$ 12d|\n") % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ());
 			}
 		}
+		else if (vm.count ("debug_profile_codecs"))
+		{
+			size_t count (1000000);
+			std::vector<chratos::uint256_union> values (count);
+			for (auto & value : values)
+			{
+				chratos::random_pool.GenerateBlock (value.bytes.data (), value.bytes.size ());
+			}
+			std::vector<std::string> hex (count);
+			std::vector<std::string> accounts (count);
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			for (size_t i (0); i < count; ++i)
+			{
+				std::stringstream stream;
+				stream << std::hex << std::noshowbase << std::setw (64) << std::setfill ('0') << values[i].number ();
+				hex[i] = stream.str ();
+			}
+			auto end1 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Multiprecision hex encoding: %1%us\n") % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ());
+			auto begin2 (std::chrono::high_resolution_clock::now ());
+			for (size_t i (0); i < count; ++i)
+			{
+				hex[i].clear ();
+				values[i].encode_hex (hex[i]);
+			}
+			auto end2 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Hex encoding: %1%us\n") % std::chrono::duration_cast<std::chrono::microseconds> (end2 - begin2).count ());
+			auto begin3 (std::chrono::high_resolution_clock::now ());
+			for (size_t i (0); i < count; ++i)
+			{
+				auto error (values[i].decode_hex (hex[i]));
+				assert (!error);
+				(void)error;
+			}
+			auto end3 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Hex decoding: %1%us\n") % std::chrono::duration_cast<std::chrono::microseconds> (end3 - begin3).count ());
+			auto begin4 (std::chrono::high_resolution_clock::now ());
+			for (size_t i (0); i < count; ++i)
+			{
+				values[i].encode_account (accounts[i]);
+			}
+			auto end4 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Account encoding: %1%us\n") % std::chrono::duration_cast<std::chrono::microseconds> (end4 - begin4).count ());
+			auto begin5 (std::chrono::high_resolution_clock::now ());
+			for (size_t i (0); i < count; ++i)
+			{
+				auto error (values[i].decode_account (accounts[i]));
+				assert (!error);
+				(void)error;
+			}
+			auto end5 (std::chrono::high_resolution_clock::now ());
+			std::cerr << boost::str (boost::format ("Account decoding: %1%us\n") % std::chrono::duration_cast<std::chrono::microseconds> (end5 - begin5).count ());
+		}
+		else if (vm.count ("debug_profile_network"))
+		{
+			chratos::system system (24000, 2);
+			auto & node0 (*system.nodes[0]);
+			auto & node1 (*system.nodes[1]);
+			size_t count (200000);
+			std::cerr << "Starting network profiling\n";
+			auto initial (node1.stats.count (chratos::stat::type::message, chratos::stat::detail::keepalive, chratos::stat::dir::in));
+			auto begin1 (std::chrono::high_resolution_clock::now ());
+			for (size_t i (0); i < count; ++i)
+			{
+				node0.network.send_keepalive (node1.network.endpoint ());
+			}
+			// Loopback may drop packets under load, stop once traffic has gone quiet
+			auto received (initial);
+			auto last_change (std::chrono::high_resolution_clock::now ());
+			while (received < initial + count && std::chrono::high_resolution_clock::now () - last_change < std::chrono::seconds (1))
+			{
+				system.poll ();
+				auto current (node1.stats.count (chratos::stat::type::message, chratos::stat::detail::keepalive, chratos::stat::dir::in));
+				if (current != received)
+				{
+					received = current;
+					last_change = std::chrono::high_resolution_clock::now ();
+				}
+			}
+			auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (last_change - begin1).count ());
+			std::cerr << boost::str (boost::format ("Received %1% of %2% packets in %3%us, %4% packets/s\n") % (received - initial) % count % elapsed % ((received - initial) * 1000000 / std::max<decltype (elapsed)> (elapsed, 1)));
+		}
+		else if (vm.count ("debug_profile_udp_buffer"))
+		{
+			for (auto threads (1u); threads <= std::max (1u, std::thread::hardware_concurrency ()); threads *= 2)
+			{
+				chratos::stat stats;
+				chratos::udp_buffer buffer (stats, chratos::network::buffer_size, 4096);
+				std::atomic<uint64_t> serviced (0);
+				std::atomic<bool> producing (true);
+				std::vector<boost::thread> workers;
+				for (auto i (0u); i < threads; ++i)
+				{
+					workers.push_back (boost::thread ([&buffer, &serviced]() {
+						for (auto item (buffer.dequeue ()); item != nullptr; item = buffer.dequeue ())
+						{
+							++serviced;
+							buffer.release (item);
+						}
+					}));
+					workers.push_back (boost::thread ([&buffer, &producing]() {
+						while (producing)
+						{
+							auto item (buffer.allocate ());
+							if (item != nullptr)
+							{
+								buffer.enqueue (item);
+							}
+						}
+					}));
+				}
+				std::this_thread::sleep_for (std::chrono::seconds (1));
+				producing = false;
+				auto serviced_l (serviced.load ());
+				buffer.stop ();
+				for (auto & worker : workers)
+				{
+					worker.join ();
+				}
+				std::cerr << boost::str (boost::format ("%1% producers/consumers: %2% buffers/s serviced, %3% overflows\n") % threads % serviced_l % stats.count (chratos::stat::type::udp, chratos::stat::detail::overflow, chratos::stat::dir::in));
+			}
+		}
 		else if (vm.count ("debug_profile_process"))
 		{
 			if (chratos::chratos_network == chratos::chratos_networks::chratos_test_network)
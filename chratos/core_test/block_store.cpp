@@ -1,11 +1,14 @@
 #include <chratos/lib/utility.hpp>
 #include <chratos/node/common.hpp>
 #include <chratos/node/node.hpp>
+#include <chratos/node/snapshot.hpp>
 #include <chratos/secure/versioning.hpp>
 #include <gtest/gtest.h>
 
 #include <fstream>
 
+using namespace std::chrono_literals;
+
 TEST (block_store, construction)
 {
 	bool init (false);
@@ -328,6 +331,55 @@ TEST (unchecked, multiple_get)
 	ASSERT_EQ (unchecked5.size (), 0);
 }
 
+TEST (unchecked, duplicate_put)
+{
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_TRUE (!init);
+	chratos::keypair key1;
+	auto block1 (std::make_shared<chratos::state_block> (key1.pub, 1, key1.pub, 2, 3, 0, key1.prv, key1.pub, 0));
+	auto transaction (store.tx_begin (true));
+	ASSERT_FALSE (store.unchecked_put (transaction, block1->previous (), block1));
+	ASSERT_TRUE (store.unchecked_put (transaction, block1->previous (), block1));
+	// Same block waiting on a different dependency is a separate entry
+	ASSERT_FALSE (store.unchecked_put (transaction, block1->link (), block1));
+	ASSERT_EQ (2, store.unchecked_count (transaction));
+	store.unchecked_del (transaction, block1->previous (), block1);
+	ASSERT_FALSE (store.unchecked_put (transaction, block1->previous (), block1));
+	auto begin (store.unchecked_begin (transaction, block1->previous ()));
+	ASSERT_NE (store.unchecked_end (), begin);
+	ASSERT_EQ (block1->previous (), begin->first.key ());
+	ASSERT_EQ (block1->hash (), begin->first.hash);
+	ASSERT_EQ (*block1, *begin->second.block);
+	ASSERT_NE (0, begin->second.modified);
+}
+
+TEST (unchecked, trim_oldest)
+{
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_TRUE (!init);
+	chratos::keypair key1;
+	std::vector<std::shared_ptr<chratos::block>> blocks;
+	auto transaction (store.tx_begin (true));
+	for (uint64_t i (0); i < 5; ++i)
+	{
+		auto block (std::make_shared<chratos::state_block> (key1.pub, i + 1, key1.pub, 2, 3, 0, key1.prv, key1.pub, 0));
+		blocks.push_back (block);
+		// Arrival times are written directly so the oldest entries are known
+		chratos::unchecked_info info (block, 100 - i);
+		ASSERT_EQ (0, mdb_put (store.env.tx (transaction), store.unchecked, chratos::mdb_val (chratos::unchecked_key (block->previous (), block->hash ())), chratos::mdb_val (info), 0));
+	}
+	ASSERT_EQ (0, store.unchecked_trim (transaction, 5));
+	ASSERT_EQ (2, store.unchecked_trim (transaction, 3));
+	ASSERT_EQ (3, store.unchecked_count (transaction));
+	ASSERT_EQ (1, store.unchecked_get (transaction, blocks[2]->previous ()).size ());
+	ASSERT_EQ (1, store.unchecked_get (transaction, blocks[3]->previous ()).size ());
+	ASSERT_EQ (1, store.unchecked_get (transaction, blocks[4]->previous ()).size ());
+	ASSERT_TRUE (store.unchecked_get (transaction, blocks[0]->previous ()).empty ());
+	ASSERT_TRUE (store.unchecked_get (transaction, blocks[1]->previous ()).empty ());
+}
+
 TEST (checksum, simple)
 {
 	bool init (false);
@@ -391,9 +443,9 @@ TEST (block_store, one_bootstrap)
 	auto begin (store.unchecked_begin (transaction));
 	auto end (store.unchecked_end ());
 	ASSERT_NE (end, begin);
-	chratos::uint256_union hash1 (begin->first);
+	auto hash1 (begin->first.key ());
 	ASSERT_EQ (block1->hash (), hash1);
-	auto blocks (store.unchecked_get (transaction, chratos::block_hash (begin->first)));
+	auto blocks (store.unchecked_get (transaction, hash1));
 	ASSERT_EQ (1, blocks.size ());
 	auto block2 (blocks[0]);
 	ASSERT_EQ (*block1, *block2);
@@ -883,41 +935,39 @@ TEST (block_store, change_dupsort)
 	bool init (false);
 	chratos::mdb_store store (init, path);
 	auto transaction (store.tx_begin (true));
-	ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), store.unchecked, 1));
-	ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "unchecked", MDB_CREATE, &store.unchecked));
-	auto send1 (std::make_shared<chratos::send_block> (0, 0, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, 0));
-	auto send2 (std::make_shared<chratos::send_block> (1, 0, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, 0));
-	ASSERT_NE (send1->hash (), send2->hash ());
-	store.unchecked_put (transaction, send1->hash (), send1);
-	store.unchecked_put (transaction, send1->hash (), send2);
-	store.flush (transaction);
+	MDB_dbi dupsort;
+	ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "dupsort_test", MDB_CREATE, &dupsort));
+	chratos::block_hash key1 (1);
+	chratos::block_hash value1 (2);
+	chratos::block_hash value2 (3);
+	chratos::store_iterator<chratos::block_hash, chratos::block_hash> end (nullptr);
+	ASSERT_EQ (0, mdb_put (store.env.tx (transaction), dupsort, chratos::mdb_val (key1), chratos::mdb_val (value1), 0));
+	ASSERT_EQ (0, mdb_put (store.env.tx (transaction), dupsort, chratos::mdb_val (key1), chratos::mdb_val (value2), 0));
 	{
-		auto iterator1 (store.unchecked_begin (transaction));
+		chratos::store_iterator<chratos::block_hash, chratos::block_hash> iterator1 (std::make_unique<chratos::mdb_iterator<chratos::block_hash, chratos::block_hash>> (transaction, dupsort));
 		++iterator1;
-		ASSERT_EQ (store.unchecked_end (), iterator1);
+		ASSERT_EQ (end, iterator1);
 	}
-	ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), store.unchecked, 0));
-	mdb_dbi_close (store.env, store.unchecked);
-	ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "unchecked", MDB_CREATE | MDB_DUPSORT, &store.unchecked));
-	store.unchecked_put (transaction, send1->hash (), send1);
-	store.unchecked_put (transaction, send1->hash (), send2);
-	store.flush (transaction);
+	ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), dupsort, 0));
+	mdb_dbi_close (store.env, dupsort);
+	ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "dupsort_test", MDB_CREATE | MDB_DUPSORT, &dupsort));
+	ASSERT_EQ (0, mdb_put (store.env.tx (transaction), dupsort, chratos::mdb_val (key1), chratos::mdb_val (value1), 0));
+	ASSERT_EQ (0, mdb_put (store.env.tx (transaction), dupsort, chratos::mdb_val (key1), chratos::mdb_val (value2), 0));
 	{
-		auto iterator1 (store.unchecked_begin (transaction));
+		chratos::store_iterator<chratos::block_hash, chratos::block_hash> iterator1 (std::make_unique<chratos::mdb_iterator<chratos::block_hash, chratos::block_hash>> (transaction, dupsort));
 		++iterator1;
-		ASSERT_EQ (store.unchecked_end (), iterator1);
+		ASSERT_EQ (end, iterator1);
 	}
-	ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), store.unchecked, 1));
-	ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "unchecked", MDB_CREATE | MDB_DUPSORT, &store.unchecked));
-	store.unchecked_put (transaction, send1->hash (), send1);
-	store.unchecked_put (transaction, send1->hash (), send2);
-	store.flush (transaction);
+	ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), dupsort, 1));
+	ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "dupsort_test", MDB_CREATE | MDB_DUPSORT, &dupsort));
+	ASSERT_EQ (0, mdb_put (store.env.tx (transaction), dupsort, chratos::mdb_val (key1), chratos::mdb_val (value1), 0));
+	ASSERT_EQ (0, mdb_put (store.env.tx (transaction), dupsort, chratos::mdb_val (key1), chratos::mdb_val (value2), 0));
 	{
-		auto iterator1 (store.unchecked_begin (transaction));
+		chratos::store_iterator<chratos::block_hash, chratos::block_hash> iterator1 (std::make_unique<chratos::mdb_iterator<chratos::block_hash, chratos::block_hash>> (transaction, dupsort));
 		++iterator1;
-		ASSERT_NE (store.unchecked_end (), iterator1);
+		ASSERT_NE (end, iterator1);
 		++iterator1;
-		ASSERT_EQ (store.unchecked_end (), iterator1);
+		ASSERT_EQ (end, iterator1);
 	}
 }
 
@@ -950,6 +1000,62 @@ TEST (block_store, upgrade_v7_v8)
 	}
 }
 
+TEST (block_store, bootstrap_pulls)
+{
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_FALSE (init);
+	auto transaction (store.tx_begin (true));
+	ASSERT_EQ (0, store.bootstrap_pull_count (transaction));
+	ASSERT_EQ (store.bootstrap_pull_end (), store.bootstrap_pull_begin (transaction));
+	chratos::block_hash head1 (1);
+	chratos::block_hash head2 (2);
+	chratos::pull_checkpoint checkpoint1 (3, 4);
+	chratos::pull_checkpoint checkpoint2 (5, 0);
+	store.bootstrap_pull_put (transaction, head1, checkpoint1);
+	store.bootstrap_pull_put (transaction, head2, checkpoint2);
+	ASSERT_EQ (2, store.bootstrap_pull_count (transaction));
+	auto i (store.bootstrap_pull_begin (transaction));
+	ASSERT_EQ (head1, i->first);
+	ASSERT_EQ (checkpoint1, i->second);
+	++i;
+	ASSERT_EQ (head2, i->first);
+	ASSERT_EQ (checkpoint2, i->second);
+	++i;
+	ASSERT_EQ (store.bootstrap_pull_end (), i);
+	store.bootstrap_pull_del (transaction, head1);
+	ASSERT_EQ (1, store.bootstrap_pull_count (transaction));
+	store.bootstrap_pull_clear (transaction);
+	ASSERT_EQ (0, store.bootstrap_pull_count (transaction));
+}
+
+TEST (block_store, upgrade_v11_v12)
+{
+	auto path (chratos::unique_path ());
+	chratos::keypair key1;
+	auto block1 (std::make_shared<chratos::state_block> (key1.pub, 1, key1.pub, 2, 3, 0, key1.prv, key1.pub, 0));
+	{
+		bool init (false);
+		chratos::mdb_store store (init, path);
+		ASSERT_FALSE (init);
+		auto transaction (store.tx_begin (true));
+		// Recreate the legacy dupsort layout keyed only by dependency
+		ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), store.unchecked, 1));
+		ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "unchecked", MDB_CREATE | MDB_DUPSORT, &store.unchecked));
+		ASSERT_EQ (0, mdb_put (store.env.tx (transaction), store.unchecked, chratos::mdb_val (block1->previous ()), chratos::mdb_val (std::shared_ptr<chratos::block> (block1)), 0));
+		store.version_put (transaction, 11);
+	}
+	bool init (false);
+	chratos::mdb_store store (init, path);
+	ASSERT_FALSE (init);
+	auto transaction (store.tx_begin (true));
+	ASSERT_LT (11, store.version_get (transaction));
+	ASSERT_EQ (0, store.unchecked_count (transaction));
+	ASSERT_FALSE (store.unchecked_put (transaction, block1->previous (), block1));
+	ASSERT_FALSE (store.unchecked_put (transaction, block1->link (), block1));
+	ASSERT_EQ (2, store.unchecked_count (transaction));
+}
+
 TEST (block_store, sequence_flush)
 {
 	auto path (chratos::unique_path ());
@@ -1082,3 +1188,133 @@ TEST (block_store, state_block)
 	ASSERT_EQ (0, count2.state_v0);
 	ASSERT_EQ (0, count2.state_v1);
 }
+
+TEST (snapshot, export_import)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	system.wallet (0)->insert_adhoc (chratos::test_genesis_key.prv);
+	chratos::keypair key1;
+	chratos::keypair key2;
+	system.wallet (0)->insert_adhoc (key1.prv);
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (chratos::test_genesis_key.pub, key1.pub, 100));
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (chratos::test_genesis_key.pub, key2.pub, 200));
+	system.deadline_set (10s);
+	while (node0->balance (key1.pub) != 100)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	auto path (chratos::unique_path ());
+	ASSERT_FALSE (chratos::snapshot_export (node0->store, path));
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_FALSE (init);
+	ASSERT_FALSE (chratos::snapshot_import (store, path, node0->ledger.epoch_link, node0->ledger.epoch_signer, 4));
+	auto transaction0 (node0->store.tx_begin_read ());
+	auto transaction1 (store.tx_begin_read ());
+	ASSERT_EQ (node0->store.account_count (transaction0), store.account_count (transaction1));
+	ASSERT_EQ (node0->store.block_count (transaction0).sum (), store.block_count (transaction1).sum ());
+	for (auto i (node0->store.latest_begin (transaction0)), n (node0->store.latest_end ()); i != n; ++i)
+	{
+		chratos::account_info info;
+		ASSERT_FALSE (store.account_get (transaction1, i->first, info));
+		ASSERT_EQ (chratos::account_info (i->second), info);
+		for (auto hash (info.open_block); !hash.is_zero (); hash = store.block_successor (transaction1, hash))
+		{
+			ASSERT_EQ (node0->store.block_successor (transaction0, hash), store.block_successor (transaction1, hash));
+		}
+	}
+	ASSERT_TRUE (store.pending_exists (transaction1, chratos::pending_key (key2.pub, node0->latest (chratos::test_genesis_key.pub))));
+	// Received sends are replayed out of the rebuilt pending table
+	for (auto i (store.pending_begin (transaction1)), n (store.pending_end ()); i != n; ++i)
+	{
+		ASSERT_TRUE (node0->store.pending_exists (transaction0, i->first));
+	}
+	ASSERT_EQ (node0->store.representation_get (transaction0, chratos::test_genesis_key.pub), store.representation_get (transaction1, chratos::test_genesis_key.pub));
+	chratos::checksum checksum0;
+	chratos::checksum checksum1;
+	ASSERT_FALSE (node0->store.checksum_get (transaction0, 0, 0, checksum0));
+	ASSERT_FALSE (store.checksum_get (transaction1, 0, 0, checksum1));
+	ASSERT_EQ (checksum0, checksum1);
+}
+
+TEST (snapshot, rejects_corruption)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	auto path (chratos::unique_path ());
+	ASSERT_FALSE (chratos::snapshot_export (node0->store, path));
+	{
+		// Flip a byte in the middle of the genesis block
+		std::fstream file (path.string (), std::ios::in | std::ios::out | std::ios::binary);
+		file.seekg (100);
+		char value;
+		file.read (&value, 1);
+		file.seekp (100);
+		value = ~value;
+		file.write (&value, 1);
+	}
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_FALSE (init);
+	auto error (chratos::snapshot_import (store, path, node0->ledger.epoch_link, node0->ledger.epoch_signer, 1));
+	ASSERT_TRUE (error == chratos::error_snapshot::checksum_mismatch || error == chratos::error_snapshot::invalid_data);
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (0, store.account_count (transaction));
+}
+
+TEST (snapshot, rejects_inconsistent_account)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	{
+		// Signatures still verify but the account claims more than its head block holds
+		auto transaction (node0->store.tx_begin_write ());
+		chratos::account_info info;
+		ASSERT_FALSE (node0->store.account_get (transaction, chratos::test_genesis_key.pub, info));
+		info.balance = info.balance.number () - 1;
+		node0->store.account_put (transaction, chratos::test_genesis_key.pub, info);
+	}
+	auto path (chratos::unique_path ());
+	ASSERT_FALSE (chratos::snapshot_export (node0->store, path));
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_FALSE (init);
+	ASSERT_EQ (chratos::error_snapshot::invalid_data, chratos::snapshot_import (store, path, node0->ledger.epoch_link, node0->ledger.epoch_signer, 1));
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (0, store.account_count (transaction));
+}
+
+TEST (snapshot, rejects_inflated_receive)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	chratos::keypair key1;
+	chratos::genesis genesis;
+	chratos::state_block send (chratos::test_genesis_key.pub, genesis.hash (), chratos::test_genesis_key.pub, chratos::genesis_amount - 100, key1.pub, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, system.work.generate (genesis.hash ()));
+	chratos::state_block open (key1.pub, 0, key1.pub, 200, send.hash (), 0, key1.prv, key1.pub, system.work.generate (key1.pub));
+	{
+		// Both blocks are signed correctly but the open block receives twice what was sent
+		auto transaction (node0->store.tx_begin_write ());
+		ASSERT_EQ (chratos::process_result::progress, node0->ledger.process (transaction, send).code);
+		node0->store.block_put (transaction, open.hash (), open);
+		node0->store.account_put (transaction, key1.pub, chratos::account_info (open.hash (), open.hash (), open.hash (), 0, 200, chratos::seconds_since_epoch (), 1, chratos::epoch::epoch_0));
+	}
+	auto path (chratos::unique_path ());
+	ASSERT_FALSE (chratos::snapshot_export (node0->store, path));
+	bool init (false);
+	chratos::mdb_store store (init, chratos::unique_path ());
+	ASSERT_FALSE (init);
+	ASSERT_EQ (chratos::error_snapshot::invalid_data, chratos::snapshot_import (store, path, node0->ledger.epoch_link, node0->ledger.epoch_signer, 1));
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (0, store.account_count (transaction));
+}
+
+TEST (snapshot, import_not_empty)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	auto path (chratos::unique_path ());
+	ASSERT_FALSE (chratos::snapshot_export (node0->store, path));
+	ASSERT_EQ (chratos::error_snapshot::store_not_empty, chratos::snapshot_import (static_cast<chratos::mdb_store &> (node0->store), path, node0->ledger.epoch_link, node0->ledger.epoch_signer, 1));
+}
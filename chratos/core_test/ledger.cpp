@@ -2428,3 +2428,18 @@ TEST (ledger, could_fit)
 	ASSERT_EQ (chratos::process_result::progress, ledger.process (transaction, epoch1).code);
 	ASSERT_TRUE (ledger.could_fit (transaction, epoch1));
 }
+
+TEST (ledger, dividend_share)
+{
+	ASSERT_EQ (0, chratos::ledger::dividend_share (0, 100, 1000));
+	ASSERT_EQ (0, chratos::ledger::dividend_share (100, 100, 100));
+	ASSERT_EQ (1, chratos::ledger::dividend_share (2, 3, 8));
+	ASSERT_EQ (30, chratos::ledger::dividend_share (26, 7, 13));
+	// Exact quotients keep the rounding of the original floating point formula
+	ASSERT_EQ (1, chratos::ledger::dividend_share (1, 3, 6));
+	ASSERT_EQ (3, chratos::ledger::dividend_share (1, 30, 40));
+	ASSERT_EQ (6, chratos::ledger::dividend_share (7, 13, 26));
+	ASSERT_EQ (14, chratos::ledger::dividend_share (5, 21, 28));
+	chratos::uint128_t supply (std::numeric_limits<chratos::uint128_t>::max ());
+	ASSERT_EQ (supply / 2 - 1, chratos::ledger::dividend_share (supply / 2, supply / 2, supply));
+}
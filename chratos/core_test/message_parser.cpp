@@ -190,3 +190,62 @@ TEST (message_parser, exact_keepalive_size)
 	ASSERT_EQ (1, visitor.keepalive_count);
 	ASSERT_NE (parser.status, chratos::message_parser::parse_status::success);
 }
+
+TEST (message_parser, duplicate_filter)
+{
+	chratos::system system (24000, 1);
+	test_visitor visitor;
+	chratos::stat stats;
+	chratos::message_filter filter (stats, 16);
+	chratos::message_parser parser (visitor, system.work, &filter);
+	chratos::keypair key1;
+	auto block (std::unique_ptr<chratos::state_block> (new chratos::state_block (key1.pub, 1, key1.pub, 2, 3, 0, key1.prv, key1.pub, system.work.generate (1))));
+	chratos::publish message (std::move (block));
+	std::vector<uint8_t> bytes;
+	{
+		chratos::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, chratos::message_parser::parse_status::success);
+	ASSERT_EQ (1, visitor.publish_count);
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, chratos::message_parser::parse_status::duplicate_publish_message);
+	ASSERT_EQ (1, visitor.publish_count);
+	// Relaying peers using a different protocol version send the same payload
+	bytes[3] ^= 1;
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, chratos::message_parser::parse_status::duplicate_publish_message);
+	ASSERT_EQ (1, visitor.publish_count);
+	ASSERT_EQ (1, stats.count (chratos::stat::type::filter, chratos::stat::detail::miss));
+	ASSERT_EQ (2, stats.count (chratos::stat::type::filter, chratos::stat::detail::hit));
+}
+
+TEST (message_parser, filter_rejected)
+{
+	chratos::system system (24000, 1);
+	test_visitor visitor;
+	chratos::stat stats;
+	chratos::message_filter filter (stats, 16);
+	chratos::message_parser parser (visitor, system.work, &filter);
+	chratos::keypair key1;
+	auto block (std::unique_ptr<chratos::state_block> (new chratos::state_block (key1.pub, 1, key1.pub, 2, 3, 0, key1.prv, key1.pub, 0)));
+	while (!chratos::work_validate (*block))
+	{
+		block->block_work_set (block->block_work () + 1);
+	}
+	chratos::publish message (std::move (block));
+	std::vector<uint8_t> bytes;
+	{
+		chratos::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	// Messages failing validation aren't remembered
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, chratos::message_parser::parse_status::insufficient_work);
+	parser.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (parser.status, chratos::message_parser::parse_status::insufficient_work);
+	ASSERT_EQ (0, visitor.publish_count);
+	ASSERT_EQ (2, stats.count (chratos::stat::type::filter, chratos::stat::detail::miss));
+	ASSERT_EQ (0, stats.count (chratos::stat::type::filter, chratos::stat::detail::hit));
+}
@@ -150,6 +150,57 @@ TEST (network, multi_keepalive)
 	node2->stop ();
 }
 
+TEST (network, send_batch)
+{
+	chratos::system system (24000, 2);
+	auto & node0 (*system.nodes[0]);
+	auto & node1 (*system.nodes[1]);
+	auto initial (node1.stats.count (chratos::stat::type::message, chratos::stat::detail::keepalive, chratos::stat::dir::in));
+	// More packets than fit in a single batch in either direction
+	auto count (2 * chratos::network::batch_size + 1);
+	for (size_t i (0); i < count; ++i)
+	{
+		node0.network.send_keepalive (node1.network.endpoint ());
+	}
+	system.deadline_set (10s);
+	while (node1.stats.count (chratos::stat::type::message, chratos::stat::detail::keepalive, chratos::stat::dir::in) < initial + count)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+}
+
+TEST (network, reuse_port)
+{
+	chratos::system system (24000, 2);
+	chratos::node_init init1;
+	chratos::node_config config1 (24002, system.logging);
+	config1.udp_sockets = 4;
+	auto node1 (std::make_shared<chratos::node> (init1, system.service, chratos::unique_path (), system.alarm, config1, system.work));
+	ASSERT_FALSE (init1.error ());
+	node1->start ();
+#if defined(__linux__)
+	ASSERT_EQ (4, node1->network.channels.size ());
+#else
+	ASSERT_EQ (1, node1->network.channels.size ());
+#endif
+	for (auto & channel : node1->network.channels)
+	{
+		ASSERT_EQ (24002, channel->socket.local_endpoint ().port ());
+	}
+	// Whichever socket the kernel picks for each sender, all of their packets arrive
+	auto count (2 * chratos::network::batch_size);
+	for (size_t i (0); i < count; ++i)
+	{
+		system.nodes[i % system.nodes.size ()]->network.send_keepalive (node1->network.endpoint ());
+	}
+	system.deadline_set (10s);
+	while (node1->stats.count (chratos::stat::type::message, chratos::stat::detail::keepalive, chratos::stat::dir::in) < count)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	node1->stop ();
+}
+
 TEST (network, send_discarded_publish)
 {
 	chratos::system system (24000, 2);
@@ -605,6 +656,194 @@ TEST (bootstrap_processor, process_state)
 	node1->stop ();
 }
 
+TEST (bootstrap_processor, lazy_hash)
+{
+	chratos::system system (24000, 1);
+	chratos::genesis genesis;
+	chratos::keypair key1;
+	auto node0 (system.nodes[0]);
+	auto send1 (std::make_shared<chratos::state_block> (chratos::test_genesis_key.pub, genesis.hash (), chratos::test_genesis_key.pub, chratos::genesis_amount - chratos::Gchr_ratio, key1.pub, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	auto open1 (std::make_shared<chratos::state_block> (key1.pub, 0, key1.pub, chratos::Gchr_ratio, send1->hash (), 0, key1.prv, key1.pub, system.work.generate (key1.pub)));
+	auto change1 (std::make_shared<chratos::state_block> (key1.pub, open1->hash (), chratos::test_genesis_key.pub, chratos::Gchr_ratio, 0, 0, key1.prv, key1.pub, system.work.generate (open1->hash ())));
+	ASSERT_EQ (chratos::process_result::progress, node0->process (*send1).code);
+	ASSERT_EQ (chratos::process_result::progress, node0->process (*open1).code);
+	ASSERT_EQ (chratos::process_result::progress, node0->process (*change1).code);
+	chratos::node_init init1;
+	auto node1 (std::make_shared<chratos::node> (init1, system.service, 24001, chratos::unique_path (), system.alarm, system.logging, system.work));
+	node1->peers.insert (node0->network.endpoint (), chratos::protocol_version);
+	// Only the head of key1's chain is requested, the send it receives from is found through the open block's link
+	node1->bootstrap_initiator.bootstrap_lazy (change1->hash ());
+	{
+		auto attempt (node1->bootstrap_initiator.current_attempt ());
+		ASSERT_NE (nullptr, attempt);
+		ASSERT_TRUE (attempt->lazy_mode);
+	}
+	system.deadline_set (10s);
+	while (node1->latest (key1.pub) != change1->hash () || node1->latest (chratos::test_genesis_key.pub) != send1->hash ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (1, node1->stats.count (chratos::stat::type::bootstrap, chratos::stat::detail::initiate_lazy, chratos::stat::dir::out));
+	ASSERT_EQ (0, node1->stats.count (chratos::stat::type::bootstrap, chratos::stat::detail::initiate, chratos::stat::dir::out));
+	node1->stop ();
+}
+
+TEST (bootstrap_processor, resume_checkpoint)
+{
+	chratos::system system (24000, 1);
+	chratos::genesis genesis;
+	chratos::keypair key1;
+	auto node0 (system.nodes[0]);
+	auto send1 (std::make_shared<chratos::state_block> (chratos::test_genesis_key.pub, genesis.hash (), chratos::test_genesis_key.pub, chratos::genesis_amount - chratos::Gchr_ratio, key1.pub, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	ASSERT_EQ (chratos::process_result::progress, node0->process (*send1).code);
+	chratos::node_init init1;
+	auto node1 (std::make_shared<chratos::node> (init1, system.service, 24001, chratos::unique_path (), system.alarm, system.logging, system.work));
+	{
+		// Checkpoint left by an interrupted attempt, the genesis pull has since been reached locally
+		auto transaction (node1->store.tx_begin_write ());
+		node1->store.bootstrap_pull_put (transaction, send1->hash (), chratos::pull_checkpoint (chratos::test_genesis_key.pub, genesis.hash ()));
+		node1->store.bootstrap_pull_put (transaction, genesis.hash (), chratos::pull_checkpoint (chratos::test_genesis_key.pub, 0));
+		// Frontier scan had completed
+		node1->store.bootstrap_pull_put (transaction, 0, chratos::pull_checkpoint ());
+	}
+	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
+	system.deadline_set (10s);
+	while (node1->latest (chratos::test_genesis_key.pub) != send1->hash ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	while (node1->bootstrap_initiator.in_progress ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	// Resuming skips the frontier scan and the checkpoint is cleared once pulls complete
+	ASSERT_EQ (0, node0->stats.count (chratos::stat::type::bootstrap, chratos::stat::detail::frontier_req, chratos::stat::dir::in));
+	auto transaction (node1->store.tx_begin_read ());
+	ASSERT_EQ (0, node1->store.bootstrap_pull_count (transaction));
+	node1->stop ();
+}
+
+TEST (bootstrap_processor, resume_partial_checkpoint)
+{
+	chratos::system system (24000, 1);
+	chratos::genesis genesis;
+	chratos::keypair key1;
+	auto node0 (system.nodes[0]);
+	auto send1 (std::make_shared<chratos::state_block> (chratos::test_genesis_key.pub, genesis.hash (), chratos::test_genesis_key.pub, chratos::genesis_amount - chratos::Gchr_ratio, key1.pub, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	ASSERT_EQ (chratos::process_result::progress, node0->process (*send1).code);
+	chratos::node_init init1;
+	auto node1 (std::make_shared<chratos::node> (init1, system.service, 24001, chratos::unique_path (), system.alarm, system.logging, system.work));
+	{
+		// Interrupted before the frontier scan finished, the pulls found so far can't stand in for it
+		auto transaction (node1->store.tx_begin_write ());
+		node1->store.bootstrap_pull_put (transaction, 1, chratos::pull_checkpoint (key1.pub, 0));
+	}
+	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
+	system.deadline_set (10s);
+	while (node1->latest (chratos::test_genesis_key.pub) != send1->hash ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	while (node1->bootstrap_initiator.in_progress ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_LT (0, node0->stats.count (chratos::stat::type::bootstrap, chratos::stat::detail::frontier_req, chratos::stat::dir::in));
+	auto transaction (node1->store.tx_begin_read ());
+	ASSERT_EQ (0, node1->store.bootstrap_pull_count (transaction));
+	node1->stop ();
+}
+
+TEST (bootstrap_processor, resume_reached_checkpoint)
+{
+	chratos::system system (24000, 1);
+	chratos::genesis genesis;
+	auto node0 (system.nodes[0]);
+	{
+		// A finished scan whose only pull has since been reached locally
+		auto transaction (node0->store.tx_begin_write ());
+		node0->store.bootstrap_pull_put (transaction, genesis.hash (), chratos::pull_checkpoint (chratos::test_genesis_key.pub, 0));
+		node0->store.bootstrap_pull_put (transaction, 0, chratos::pull_checkpoint ());
+	}
+	auto attempt (std::make_shared<chratos::bootstrap_attempt> (node0));
+	ASSERT_FALSE (attempt->checkpoint_resume ());
+	{
+		// If the new scan is interrupted, only the pulls it checkpoints are left, without a marker claiming the scan finished
+		auto transaction (node0->store.tx_begin_read ());
+		ASSERT_EQ (0, node0->store.bootstrap_pull_count (transaction));
+	}
+	chratos::keypair key1;
+	{
+		std::lock_guard<std::mutex> lock (attempt->mutex);
+		attempt->checkpoint_put (chratos::pull_info (key1.pub, 1, 0));
+	}
+	attempt->checkpoint_flush ();
+	auto attempt2 (std::make_shared<chratos::bootstrap_attempt> (node0));
+	ASSERT_FALSE (attempt2->checkpoint_resume ());
+	auto transaction (node0->store.tx_begin_read ());
+	ASSERT_EQ (0, node0->store.bootstrap_pull_count (transaction));
+}
+
+TEST (bootstrap_processor, frontier_ranges)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	system.wallet (0)->insert_adhoc (chratos::test_genesis_key.prv);
+	// Random accounts land across all of the key space ranges
+	std::vector<chratos::keypair> keys (16);
+	for (auto & key : keys)
+	{
+		ASSERT_NE (nullptr, system.wallet (0)->send_action (chratos::test_genesis_key.pub, key.pub, 100));
+	}
+	chratos::node_init init1;
+	chratos::node_config config1 (24001, system.logging);
+	config1.bootstrap_connections = 4;
+	auto node1 (std::make_shared<chratos::node> (init1, system.service, chratos::unique_path (), system.alarm, config1, system.work));
+	ASSERT_FALSE (init1.error ());
+	node1->bootstrap_initiator.bootstrap (node0->network.endpoint ());
+	system.deadline_set (10s);
+	while (node1->latest (chratos::test_genesis_key.pub) != node0->latest (chratos::test_genesis_key.pub))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	while (node1->bootstrap_initiator.in_progress ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	// One frontier request per range, each starting at its own account
+	ASSERT_LE (4, node0->stats.count (chratos::stat::type::bootstrap, chratos::stat::detail::frontier_req, chratos::stat::dir::in));
+	node1->stop ();
+}
+
+TEST (bootstrap, pull_connection)
+{
+	chratos::system system (24000, 1);
+	auto node0 (system.nodes[0]);
+	auto attempt (std::make_shared<chratos::bootstrap_attempt> (node0));
+	auto slow (std::make_shared<chratos::bootstrap_client> (node0, attempt, chratos::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24100)));
+	auto fast (std::make_shared<chratos::bootstrap_client> (node0, attempt, chratos::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24101)));
+	slow->throughput = 10.0;
+	fast->throughput = 1000.0;
+	std::lock_guard<std::mutex> lock (attempt->mutex);
+	attempt->idle.push_back (fast);
+	attempt->idle.push_back (slow);
+	// Short chains take the least recently pooled connection
+	chratos::pull_info small (1, 2, 0);
+	ASSERT_EQ (slow, attempt->pull_connection (small));
+	attempt->idle.push_back (slow);
+	// Long chains go to the fastest peer
+	chratos::pull_info large (1, 2, 0);
+	large.processed = 5000;
+	ASSERT_EQ (fast, attempt->pull_connection (large));
+	attempt->idle.push_back (fast);
+	// Retries avoid the peer that failed them
+	chratos::pull_info retry (1, 2, 0);
+	retry.attempts = 1;
+	retry.failed_peer = slow->endpoint;
+	ASSERT_EQ (fast, attempt->pull_connection (retry));
+	attempt->idle.clear ();
+}
+
 TEST (bootstrap_processor, process_new)
 {
 	chratos::system system (24000, 2);
@@ -1087,6 +1326,79 @@ TEST (udp_buffer, many_buffers_multithreaded)
 	}
 }
 
+TEST (udp_buffer, try_allocate)
+{
+	chratos::stat stats;
+	chratos::udp_buffer buffer (stats, 512, 2);
+	auto buffer1 (buffer.try_allocate ());
+	ASSERT_NE (nullptr, buffer1);
+	buffer.enqueue (buffer1);
+	auto buffer2 (buffer.try_allocate ());
+	ASSERT_NE (nullptr, buffer2);
+	ASSERT_NE (buffer1, buffer2);
+	// Unserviced buffers are never displaced
+	ASSERT_EQ (nullptr, buffer.try_allocate ());
+	ASSERT_EQ (0, stats.count (chratos::stat::type::udp, chratos::stat::detail::overflow));
+	buffer.release (buffer2);
+	ASSERT_EQ (buffer2, buffer.try_allocate ());
+}
+
+TEST (udp_buffer, stress)
+{
+	chratos::stat stats;
+	chratos::udp_buffer buffer (stats, 512, 16);
+	std::atomic<uint64_t> consumed (0);
+	std::atomic<uint64_t> corrupt (0);
+	std::vector<boost::thread> consumers;
+	for (auto i (0); i < 4; ++i)
+	{
+		consumers.push_back (boost::thread ([&buffer, &consumed, &corrupt]() {
+			for (auto item (buffer.dequeue ()); item != nullptr; item = buffer.dequeue ())
+			{
+				// A buffer handed to two owners at once would be overwritten while in use
+				if (item->size != item->buffer[0] + item->buffer[1] * 256u)
+				{
+					++corrupt;
+				}
+				++consumed;
+				buffer.release (item);
+			}
+		}));
+	}
+	std::vector<boost::thread> producers;
+	size_t const count (10000);
+	for (auto i (0); i < 4; ++i)
+	{
+		producers.push_back (boost::thread ([&buffer, i, count]() {
+			for (size_t j (0); j < count; ++j)
+			{
+				auto item (buffer.allocate ());
+				item->buffer[0] = static_cast<uint8_t> (j);
+				item->buffer[1] = static_cast<uint8_t> (i);
+				item->size = item->buffer[0] + item->buffer[1] * 256u;
+				buffer.enqueue (item);
+			}
+		}));
+	}
+	for (auto & i : producers)
+	{
+		i.join ();
+	}
+	auto deadline (std::chrono::steady_clock::now () + std::chrono::seconds (10));
+	while (consumed + stats.count (chratos::stat::type::udp, chratos::stat::detail::overflow) < 4 * count && std::chrono::steady_clock::now () < deadline)
+	{
+		std::this_thread::yield ();
+	}
+	buffer.stop ();
+	for (auto & i : consumers)
+	{
+		i.join ();
+	}
+	ASSERT_EQ (0, corrupt);
+	// Every buffer produced was either serviced or displaced by a newer one
+	ASSERT_EQ (4 * count, consumed + stats.count (chratos::stat::type::udp, chratos::stat::detail::overflow));
+}
+
 TEST (udp_buffer, stats)
 {
 	chratos::stat stats;
@@ -1130,3 +1442,33 @@ TEST (bulk_pull_account, basics)
 	ASSERT_EQ (chratos::genesis_account, block_data.second.get ()->source);
 	ASSERT_EQ (nullptr, request->get_next ().first.get ());
 }
+
+TEST (socket, deadline)
+{
+	chratos::system system (24000, 1);
+	auto node (system.nodes[0]);
+	auto socket1 (std::make_shared<chratos::socket> (node));
+	auto socket2 (std::make_shared<chratos::socket> (node));
+	socket1->socket_m.open (boost::asio::ip::tcp::v6 ());
+	socket2->socket_m.open (boost::asio::ip::tcp::v6 ());
+	auto now (std::chrono::steady_clock::now ());
+	socket1->start (now + std::chrono::seconds (1));
+	socket2->start (now + std::chrono::seconds (1));
+	socket2->stop ();
+	socket1->start (now + std::chrono::seconds (2));
+	ASSERT_EQ (2, node->socket_sweeper.size ());
+	node->socket_sweeper.sweep (now + std::chrono::milliseconds (1500));
+	ASSERT_TRUE (socket1->socket_m.is_open ());
+	node->socket_sweeper.sweep (now + std::chrono::seconds (3));
+	ASSERT_FALSE (socket1->socket_m.is_open ());
+	ASSERT_TRUE (socket2->socket_m.is_open ());
+	socket1.reset ();
+	node->socket_sweeper.sweep (now + std::chrono::seconds (3));
+	ASSERT_EQ (1, node->socket_sweeper.size ());
+	socket2->start (std::chrono::steady_clock::now ());
+	system.deadline_set (5s);
+	while (socket2->socket_m.is_open ())
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+}
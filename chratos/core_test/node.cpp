@@ -424,6 +424,7 @@ TEST (logging, serialization)
 	logging1.bulk_pull_logging_value = !logging1.bulk_pull_logging_value;
 	logging1.work_generation_time_value = !logging1.work_generation_time_value;
 	logging1.log_to_cerr_value = !logging1.log_to_cerr_value;
+	logging1.async = !logging1.async;
 	logging1.max_size = 10;
 	boost::property_tree::ptree tree;
 	logging1.serialize_json (tree);
@@ -446,6 +447,7 @@ TEST (logging, serialization)
 	ASSERT_EQ (logging1.bulk_pull_logging_value, logging2.bulk_pull_logging_value);
 	ASSERT_EQ (logging1.work_generation_time_value, logging2.work_generation_time_value);
 	ASSERT_EQ (logging1.log_to_cerr_value, logging2.log_to_cerr_value);
+	ASSERT_EQ (logging1.async, logging2.async);
 	ASSERT_EQ (logging1.max_size, logging2.max_size);
 }
 
@@ -496,6 +498,10 @@ TEST (node_config, serialization)
 	config1.callback_port = 10;
 	config1.callback_target = "test";
 	config1.lmdb_max_dbs = 256;
+	config1.udp_sockets = 3;
+	config1.unchecked_max = 1000;
+	config1.work_precache_budget = 50;
+	config1.kdf_memory_budget = 64;
 	boost::property_tree::ptree tree;
 	config1.serialize_json (tree);
 	chratos::logging logging2;
@@ -513,6 +519,10 @@ TEST (node_config, serialization)
 	ASSERT_NE (config2.callback_port, config1.callback_port);
 	ASSERT_NE (config2.callback_target, config1.callback_target);
 	ASSERT_NE (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_NE (config2.udp_sockets, config1.udp_sockets);
+	ASSERT_NE (config2.unchecked_max, config1.unchecked_max);
+	ASSERT_NE (config2.work_precache_budget, config1.work_precache_budget);
+	ASSERT_NE (config2.kdf_memory_budget, config1.kdf_memory_budget);
 
 	ASSERT_FALSE (tree.get_optional<std::string> ("epoch_block_link"));
 	ASSERT_FALSE (tree.get_optional<std::string> ("epoch_block_signer"));
@@ -531,6 +541,10 @@ TEST (node_config, serialization)
 	ASSERT_EQ (config2.callback_port, config1.callback_port);
 	ASSERT_EQ (config2.callback_target, config1.callback_target);
 	ASSERT_EQ (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_EQ (config2.udp_sockets, config1.udp_sockets);
+	ASSERT_EQ (config2.unchecked_max, config1.unchecked_max);
+	ASSERT_EQ (config2.work_precache_budget, config1.work_precache_budget);
+	ASSERT_EQ (config2.kdf_memory_budget, config1.kdf_memory_budget);
 }
 
 TEST (node_config, v1_v2_upgrade)
@@ -1914,3 +1928,89 @@ TEST (node, block_processor_reject_state)
 	node.block_processor.flush ();
 	ASSERT_TRUE (node.ledger.block_exists (send2->hash ()));
 }
+
+// Multiple confirm_req for the same block within one generator round are answered with a single vote
+TEST (node, confirm_req_aggregate)
+{
+	chratos::system system (24000, 2);
+	auto & node0 (*system.nodes[0]);
+	auto & node1 (*system.nodes[1]);
+	system.wallet (0)->insert_adhoc (chratos::test_genesis_key.prv);
+	chratos::genesis genesis;
+	std::shared_ptr<chratos::block> open (std::make_shared<chratos::state_block> (*genesis.open));
+	for (auto i (0); i < 4; ++i)
+	{
+		node1.network.send_confirm_req (node0.network.endpoint (), open);
+	}
+	system.deadline_set (10s);
+	while (node1.stats.count (chratos::stat::type::message, chratos::stat::detail::confirm_ack, chratos::stat::dir::in) == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_LT (node0.stats.count (chratos::stat::type::message, chratos::stat::detail::confirm_ack, chratos::stat::dir::out), 4);
+	auto transaction (node0.store.tx_begin_read ());
+	std::lock_guard<std::mutex> lock (boost::polymorphic_downcast<chratos::mdb_store *> (node0.store_impl.get ())->cache_mutex);
+	auto vote (node0.store.vote_current (transaction, chratos::test_genesis_key.pub));
+	ASSERT_NE (nullptr, vote);
+	ASSERT_LT (vote->sequence, 4);
+}
+
+TEST (stats, sharded_counters)
+{
+	chratos::stat stats;
+	std::vector<std::thread> threads;
+	for (auto i (0); i < 8; ++i)
+	{
+		threads.emplace_back ([&stats]() {
+			for (auto j (0); j < 1000; ++j)
+			{
+				stats.inc (chratos::stat::type::message, chratos::stat::detail::publish, chratos::stat::dir::out);
+			}
+		});
+	}
+	for (auto & thread : threads)
+	{
+		thread.join ();
+	}
+	ASSERT_EQ (8000, stats.count (chratos::stat::type::message, chratos::stat::detail::publish, chratos::stat::dir::out));
+	ASSERT_EQ (8000, stats.count (chratos::stat::type::message, chratos::stat::dir::out));
+	ASSERT_EQ (0, stats.count (chratos::stat::type::message, chratos::stat::detail::publish, chratos::stat::dir::in));
+	uint64_t observed (0);
+	stats.observe_count (chratos::stat::type::message, chratos::stat::detail::publish, chratos::stat::dir::out, [&observed](uint64_t old_a, uint64_t new_a) {
+		ASSERT_EQ (old_a + 2, new_a);
+		observed = new_a;
+	});
+	stats.add (chratos::stat::type::message, chratos::stat::detail::publish, chratos::stat::dir::out, 2);
+	ASSERT_EQ (8002, observed);
+	auto text (stats.prometheus ());
+	ASSERT_NE (std::string::npos, text.find ("chratos_stat_counter{type=\"message\",detail=\"publish\",dir=\"out\"} 8002\n"));
+	ASSERT_NE (std::string::npos, text.find ("chratos_stat_counter{type=\"message\",detail=\"all\",dir=\"out\"} 8002\n"));
+	ASSERT_EQ (std::string::npos, text.find ("dir=\"in\""));
+}
+
+TEST (stats, latency_histogram)
+{
+	chratos::stat_histogram histogram;
+	ASSERT_EQ (0, histogram.percentile (0.5));
+	for (uint64_t i (1); i <= 1000; ++i)
+	{
+		histogram.add (i);
+	}
+	ASSERT_EQ (1000, histogram.count ());
+	ASSERT_EQ (500500, histogram.sum ());
+	ASSERT_EQ (1000, histogram.max ());
+	auto p50 (histogram.percentile (0.5));
+	ASSERT_GE (p50, 500);
+	ASSERT_LE (p50, 625);
+	auto p99 (histogram.percentile (0.99));
+	ASSERT_GE (p99, 990);
+	ASSERT_LE (p99, 1000);
+	std::vector<uint64_t> values { 0, 3, 4, 7, 8, 1000, 1ULL << 40, std::numeric_limits<uint64_t>::max () };
+	for (auto value : values)
+	{
+		auto bucket (chratos::stat_histogram::bucket_of (value));
+		ASSERT_LT (bucket, chratos::stat_histogram::bucket_count);
+		ASSERT_GE (chratos::stat_histogram::bucket_upper (bucket), value);
+		ASSERT_LE (chratos::stat_histogram::bucket_upper (bucket) - value, value / 4);
+	}
+}
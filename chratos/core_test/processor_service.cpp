@@ -125,3 +125,87 @@ TEST (alarm, top_execution)
 	service.stop ();
 	thread.join ();
 }
+
+TEST (alarm, cancel)
+{
+	boost::asio::io_service service;
+	chratos::alarm alarm (service);
+	std::atomic<int> count (0);
+	auto handle1 (alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (20), [&count]() { count += 1; }));
+	auto handle2 (alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (20), [&count]() { count += 2; }));
+	ASSERT_EQ (2, alarm.size ());
+	ASSERT_FALSE (alarm.cancel (handle1));
+	ASSERT_TRUE (alarm.cancel (handle1));
+	ASSERT_EQ (1, alarm.size ());
+	boost::asio::io_service::work work (service);
+	boost::thread thread ([&service]() { service.run (); });
+	while (count == 0)
+	{
+		std::this_thread::sleep_for (std::chrono::milliseconds (1));
+	}
+	ASSERT_EQ (2, count);
+	ASSERT_EQ (0, alarm.size ());
+	ASSERT_TRUE (alarm.cancel (handle2));
+	service.stop ();
+	thread.join ();
+}
+
+TEST (timer_wheel, levels)
+{
+	auto origin (std::chrono::steady_clock::now ());
+	chratos::timer_wheel wheel (origin);
+	std::vector<std::chrono::milliseconds> delays { std::chrono::milliseconds (0), std::chrono::milliseconds (5), std::chrono::milliseconds (300), std::chrono::seconds (70), std::chrono::hours (5), std::chrono::hours (24 * 60) };
+	std::vector<std::chrono::milliseconds> fired (delays.size (), std::chrono::milliseconds (-1));
+	std::chrono::milliseconds now (0);
+	for (size_t i (0); i < delays.size (); ++i)
+	{
+		wheel.insert (origin + delays[i], [&fired, &now, i]() { fired[i] = now; });
+	}
+	auto cancelled (wheel.insert (origin + std::chrono::seconds (1), [&fired]() { fired.clear (); }));
+	ASSERT_FALSE (wheel.cancel (cancelled));
+	ASSERT_EQ (delays.size (), wheel.size ());
+	std::vector<std::function<void()>> expired;
+	while (wheel.size () > 0)
+	{
+		auto next (wheel.next ());
+		ASSERT_GE (next, origin + now);
+		now = std::chrono::duration_cast<std::chrono::milliseconds> (next - origin);
+		wheel.expire (origin + now, expired);
+		for (auto & i : expired)
+		{
+			i ();
+		}
+		expired.clear ();
+	}
+	ASSERT_EQ (delays, fired);
+	ASSERT_EQ (std::chrono::steady_clock::time_point::max (), wheel.next ());
+}
+
+TEST (timer_wheel, near_and_far)
+{
+	auto origin (std::chrono::steady_clock::now ());
+	chratos::timer_wheel wheel (origin);
+	std::vector<std::chrono::milliseconds> fired;
+	std::chrono::milliseconds now (0);
+	// Placed in level 1 while level 0 is empty
+	wheel.insert (origin + std::chrono::milliseconds (260), [&fired, &now]() { fired.push_back (now); });
+	std::vector<std::function<void()>> expired;
+	wheel.expire (origin + std::chrono::milliseconds (100), expired);
+	ASSERT_TRUE (expired.empty ());
+	// Placed in level 0 but due after the far operation cascades down
+	wheel.insert (origin + std::chrono::milliseconds (300), [&fired, &now]() { fired.push_back (now); });
+	while (wheel.size () > 0)
+	{
+		auto next (wheel.next ());
+		ASSERT_GE (next, origin + now);
+		now = std::chrono::duration_cast<std::chrono::milliseconds> (next - origin);
+		wheel.expire (origin + now, expired);
+		for (auto & i : expired)
+		{
+			i ();
+		}
+		expired.clear ();
+	}
+	std::vector<std::chrono::milliseconds> expected { std::chrono::milliseconds (260), std::chrono::milliseconds (300) };
+	ASSERT_EQ (expected, fired);
+}
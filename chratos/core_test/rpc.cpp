@@ -75,6 +75,105 @@ public:
 	int status;
 };
 
+/** Stand-in for a remote work server, answers work_generate on keep-alive connections or fails in a chosen way */
+class stand_in_work_server : public std::enable_shared_from_this<stand_in_work_server>
+{
+public:
+	enum class behaviour
+	{
+		good,
+		error,
+		silent
+	};
+	stand_in_work_server (boost::asio::io_service & service_a, chratos::work_pool & pool_a, behaviour behaviour_a) :
+	service (service_a),
+	acceptor (service_a, chratos::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 0)),
+	pool (pool_a),
+	mode (behaviour_a),
+	connections (0),
+	requests (0),
+	disconnections (0)
+	{
+	}
+	uint16_t port ()
+	{
+		return acceptor.local_endpoint ().port ();
+	}
+	void accept ()
+	{
+		auto this_l (shared_from_this ());
+		auto socket (std::make_shared<boost::asio::ip::tcp::socket> (service));
+		acceptor.async_accept (*socket, [this_l, socket](boost::system::error_code const & ec) {
+			if (!ec)
+			{
+				++this_l->connections;
+				this_l->read (socket);
+				this_l->accept ();
+			}
+		});
+	}
+	void read (std::shared_ptr<boost::asio::ip::tcp::socket> socket_a)
+	{
+		auto this_l (shared_from_this ());
+		auto buffer (std::make_shared<boost::beast::flat_buffer> ());
+		auto request (std::make_shared<boost::beast::http::request<boost::beast::http::string_body>> ());
+		boost::beast::http::async_read (*socket_a, *buffer, *request, [this_l, socket_a, buffer, request](boost::system::error_code const & ec, size_t bytes_transferred) {
+			if (!ec)
+			{
+				++this_l->requests;
+				if (this_l->mode != behaviour::silent)
+				{
+					auto response (std::make_shared<boost::beast::http::response<boost::beast::http::string_body>> ());
+					response->version (11);
+					response->keep_alive (true);
+					boost::property_tree::ptree tree;
+					std::stringstream istream (request->body ());
+					boost::property_tree::read_json (istream, tree);
+					boost::property_tree::ptree response_l;
+					if (this_l->mode == behaviour::error)
+					{
+						response->result (boost::beast::http::status::internal_server_error);
+					}
+					else if (tree.get<std::string> ("action") == "work_generate")
+					{
+						chratos::block_hash root;
+						root.decode_hex (tree.get<std::string> ("hash"));
+						response_l.put ("work", chratos::to_string_hex (this_l->pool.generate (root)));
+					}
+					std::stringstream ostream;
+					boost::property_tree::write_json (ostream, response_l);
+					response->body () = ostream.str ();
+					response->prepare_payload ();
+					boost::beast::http::async_write (*socket_a, *response, [this_l, socket_a, response](boost::system::error_code const & ec, size_t bytes_transferred) {
+						if (!ec)
+						{
+							this_l->read (socket_a);
+						}
+					});
+				}
+				else
+				{
+					// Keep the connection open without answering, the next read notices when the client gives up
+					this_l->stalled.push_back (socket_a);
+					this_l->read (socket_a);
+				}
+			}
+			else
+			{
+				++this_l->disconnections;
+			}
+		});
+	}
+	boost::asio::io_service & service;
+	boost::asio::ip::tcp::acceptor acceptor;
+	chratos::work_pool & pool;
+	behaviour mode;
+	std::atomic<unsigned> connections;
+	std::atomic<unsigned> requests;
+	std::atomic<unsigned> disconnections;
+	std::vector<std::shared_ptr<boost::asio::ip::tcp::socket>> stalled;
+};
+
 TEST (rpc, account_balance)
 {
 	chratos::system system (24000, 1);
@@ -1562,6 +1661,40 @@ TEST (rpc, work_generate)
 	ASSERT_FALSE (chratos::work_validate (hash1, work2));
 }
 
+TEST (rpc, work_generate_difficulty)
+{
+	chratos::system system (24000, 1);
+	chratos::rpc rpc (system.service, *system.nodes[0], chratos::rpc_config (true));
+	rpc.start ();
+	chratos::block_hash hash1 (1);
+	uint64_t difficulty (0xfff0000000000000);
+	boost::property_tree::ptree request1;
+	request1.put ("action", "work_generate");
+	request1.put ("hash", hash1.to_string ());
+	request1.put ("difficulty", chratos::to_string_hex (difficulty));
+	test_response response1 (request1, rpc, system.service);
+	system.deadline_set (10s);
+	while (response1.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response1.status);
+	uint64_t work;
+	ASSERT_FALSE (chratos::from_string_hex (response1.json.get<std::string> ("work"), work));
+	ASSERT_GE (chratos::work_value (hash1, work), difficulty);
+	boost::property_tree::ptree request2;
+	request2.put ("action", "stats");
+	request2.put ("type", "work");
+	test_response response2 (request2, rpc, system.service);
+	while (response2.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response2.status);
+	ASSERT_EQ ("0", response2.json.get<std::string> ("queue_depth"));
+	ASSERT_NE ("0", response2.json.get<std::string> ("solved"));
+}
+
 TEST (rpc, work_cancel)
 {
 	chratos::system system (24000, 1);
@@ -1684,6 +1817,102 @@ TEST (rpc, work_peer_many)
 	}
 }
 
+
+TEST (work_peer_client, connection_reuse)
+{
+	chratos::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	auto server (std::make_shared<stand_in_work_server> (system.service, system.work, stand_in_work_server::behaviour::good));
+	server->accept ();
+	node1.config.work_peers.push_back (std::make_pair ("::1", server->port ()));
+	for (auto i (0); i < 3; ++i)
+	{
+		chratos::keypair key1;
+		uint64_t work (0);
+		node1.work_generate (key1.pub, [&work](uint64_t work_a) {
+			work = work_a;
+		});
+		system.deadline_set (10s);
+		while (chratos::work_validate (key1.pub, work))
+		{
+			ASSERT_NO_ERROR (system.poll ());
+		}
+	}
+	ASSERT_EQ (3, server->requests);
+	ASSERT_EQ (1, server->connections);
+	auto peers (node1.work_peers.select ());
+	ASSERT_EQ (1, peers.size ());
+	ASSERT_LT (peers[0]->failure_rate, chratos::work_peer_client::initial_failure_rate);
+	ASSERT_LT (0.0, peers[0]->latency);
+}
+
+TEST (work_peer_client, failing_peer)
+{
+	chratos::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	auto good (std::make_shared<stand_in_work_server> (system.service, system.work, stand_in_work_server::behaviour::good));
+	good->accept ();
+	auto bad (std::make_shared<stand_in_work_server> (system.service, system.work, stand_in_work_server::behaviour::error));
+	bad->accept ();
+	node1.config.work_peers.push_back (std::make_pair ("::1", bad->port ()));
+	node1.config.work_peers.push_back (std::make_pair ("::1", good->port ()));
+	for (auto i (0); i < chratos::work_peer_client::failures_before_backoff; ++i)
+	{
+		chratos::keypair key1;
+		uint64_t work (0);
+		node1.work_generate (key1.pub, [&work](uint64_t work_a) {
+			work = work_a;
+		});
+		system.deadline_set (10s);
+		while (chratos::work_validate (key1.pub, work))
+		{
+			ASSERT_NO_ERROR (system.poll ());
+		}
+	}
+	system.deadline_set (10s);
+	while (bad->requests < chratos::work_peer_client::failures_before_backoff)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	// The failing peer is backed off, leaving only the good one to race
+	auto peers (node1.work_peers.select ());
+	ASSERT_EQ (1, peers.size ());
+	ASSERT_EQ (good->port (), peers[0]->port);
+	ASSERT_EQ (1, node1.work_peers.race_count (peers));
+}
+
+TEST (work_peer_client, deadline)
+{
+	chratos::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	auto server (std::make_shared<stand_in_work_server> (system.service, system.work, stand_in_work_server::behaviour::silent));
+	server->accept ();
+	node1.config.work_peers.push_back (std::make_pair ("::1", server->port ()));
+	node1.work_peers.deadline = std::chrono::milliseconds (100);
+	node1.work_peers.timeout = std::chrono::milliseconds (500);
+	chratos::keypair key1;
+	uint64_t work (0);
+	node1.work_generate (key1.pub, [&work](uint64_t work_a) {
+		work = work_a;
+	});
+	system.deadline_set (10s);
+	while (chratos::work_validate (key1.pub, work))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_LE (1, server->requests);
+	// Missing the deadline counts as a failure
+	auto peers (node1.work_peers.select ());
+	ASSERT_EQ (1, peers.size ());
+	ASSERT_LT (chratos::work_peer_client::initial_failure_rate, peers[0]->failure_rate);
+	// The stalled work_generate is closed once local work wins and the unanswered work_cancel times out
+	while (server->requests < 2 || server->disconnections < 2)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (server->requests, server->disconnections);
+}
+
 TEST (rpc, block_count)
 {
 	chratos::system system (24000, 1);
@@ -2154,6 +2383,22 @@ TEST (rpc, bootstrap_any)
 	ASSERT_TRUE (success.empty ());
 }
 
+TEST (rpc, bootstrap_status)
+{
+	chratos::system system (24000, 1);
+	chratos::rpc rpc (system.service, *system.nodes[0], chratos::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "bootstrap_status");
+	test_response response (request, rpc, system.service);
+	while (response.status == 0)
+	{
+		system.poll ();
+	}
+	ASSERT_EQ (200, response.status);
+	ASSERT_EQ ("0", response.json.get<std::string> ("running"));
+}
+
 TEST (rpc, republish)
 {
 	chratos::system system (24000, 2);
@@ -3802,3 +4047,60 @@ TEST (rpc, node_id_delete)
 	chratos::keypair node_id (system.nodes[0]->store.get_node_id (transaction));
 	ASSERT_NE (node_id.pub.to_string (), system.nodes[0]->node_id.pub.to_string ());
 }
+
+TEST (rpc, metrics)
+{
+	chratos::system system (24000, 1);
+	chratos::rpc rpc (system.service, *system.nodes[0], chratos::rpc_config (true));
+	rpc.start ();
+	system.nodes[0]->stats.inc (chratos::stat::type::ledger, chratos::stat::detail::send);
+	boost::asio::ip::tcp::socket socket (system.service);
+	boost::beast::http::request<boost::beast::http::string_body> request;
+	request.method (boost::beast::http::verb::get);
+	request.target ("/metrics");
+	request.version (11);
+	boost::beast::flat_buffer buffer;
+	boost::beast::http::response<boost::beast::http::string_body> response;
+	auto done (false);
+	socket.async_connect (chratos::tcp_endpoint (boost::asio::ip::address_v6::loopback (), rpc.config.port), [&](boost::system::error_code const & ec) {
+		ASSERT_FALSE (ec);
+		boost::beast::http::async_write (socket, request, [&](boost::system::error_code const & ec, size_t) {
+			ASSERT_FALSE (ec);
+			boost::beast::http::async_read (socket, buffer, response, [&](boost::system::error_code const & ec, size_t) {
+				ASSERT_FALSE (ec);
+				done = true;
+			});
+		});
+	});
+	system.deadline_set (5s);
+	while (!done)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (boost::beast::http::status::ok, response.result ());
+	ASSERT_EQ ("text/plain; version=0.0.4", response[boost::beast::http::field::content_type]);
+	ASSERT_NE (std::string::npos, response.body ().find ("chratos_stat_counter{type=\"ledger\",detail=\"send\",dir=\"in\"} 1\n"));
+}
+
+TEST (rpc, stats_latency)
+{
+	chratos::system system (24000, 1);
+	chratos::keypair key;
+	system.wallet (0)->insert_adhoc (chratos::test_genesis_key.prv);
+	ASSERT_NE (nullptr, system.wallet (0)->send_action (chratos::test_genesis_key.pub, key.pub, 1));
+	chratos::rpc rpc (system.service, *system.nodes[0], chratos::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "stats");
+	request.put ("type", "latency");
+	test_response response (request, rpc, system.service);
+	system.deadline_set (5s);
+	while (response.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response.status);
+	ASSERT_NE ("0", response.json.get<std::string> ("block_process.count"));
+	ASSERT_NO_THROW (response.json.get<std::string> ("block_process.p99"));
+	ASSERT_NO_THROW (response.json.get<std::string> ("vote_queue.count"));
+}
@@ -3,6 +3,8 @@
 #include <chratos/lib/interface.h>
 #include <chratos/secure/common.hpp>
 
+#include <unordered_set>
+
 TEST (uint128_union, decode_dec)
 {
 	chratos::uint128_union value;
@@ -196,6 +198,60 @@ TEST (uint256_union, max_hex)
 	ASSERT_EQ (chratos::uint256_t ("0xffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"), output.number ());
 }
 
+TEST (uint256_union, hex_case)
+{
+	chratos::uint256_union upper;
+	ASSERT_FALSE (upper.decode_hex ("FEDCBA9876543210FEDCBA9876543210FEDCBA9876543210FEDCBA9876543210"));
+	chratos::uint256_union lower;
+	ASSERT_FALSE (lower.decode_hex ("fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210"));
+	ASSERT_EQ (upper, lower);
+	chratos::uint256_union value;
+	ASSERT_FALSE (value.decode_hex ("3e8"));
+	ASSERT_EQ (1000, value.number ());
+	ASSERT_EQ ("00000000000000000000000000000000000000000000000000000000000003E8", value.to_string ());
+	chratos::uint256_union prefixed;
+	ASSERT_FALSE (prefixed.decode_hex ("0x3e8"));
+	ASSERT_EQ (value, prefixed);
+	ASSERT_TRUE (prefixed.decode_hex ("0X3e8"));
+	ASSERT_TRUE (prefixed.decode_hex ("0x0x3e8"));
+}
+
+TEST (uint256_union, operator_less_than)
+{
+	chratos::uint256_union one (1);
+	chratos::uint256_union high;
+	high.clear ();
+	high.bytes[0] = 1;
+	ASSERT_LT (one, high);
+	ASSERT_FALSE (high < one);
+	ASSERT_FALSE (one < one);
+	for (auto i (0); i != 1000; ++i)
+	{
+		chratos::keypair key1;
+		chratos::keypair key2;
+		auto value1 (key1.pub);
+		auto value2 (key1.pub);
+		value2.bytes[i % 32] = key2.pub.bytes[i % 32];
+		ASSERT_EQ (value1.number () < value2.number (), value1 < value2);
+		ASSERT_EQ (value2.number () < value1.number (), value2 < value1);
+		chratos::uint128_union amount1 (value1.owords[i % 2]);
+		chratos::uint128_union amount2 (value2.owords[i % 2]);
+		ASSERT_EQ (amount1.number () < amount2.number (), amount1 < amount2);
+		ASSERT_EQ (amount1.number () > amount2.number (), amount1 > amount2);
+	}
+}
+
+TEST (uint256_union, hash)
+{
+	std::hash<chratos::uint256_union> hash;
+	std::unordered_set<size_t> values;
+	for (auto i (0); i != 1000; ++i)
+	{
+		values.insert (hash (chratos::uint256_union (i)));
+	}
+	ASSERT_EQ (1000, values.size ());
+}
+
 TEST (uint256_union, decode_dec)
 {
 	chratos::uint256_union value;
@@ -348,6 +404,33 @@ TEST (uint256_union, account_transcode)
 	ASSERT_EQ (value, value2);
 }
 
+TEST (uint256_union, account_encode_number)
+{
+	// Compare against the multiprecision reference encoding
+	for (auto i (0); i != 1000; ++i)
+	{
+		chratos::keypair key;
+		std::string expected;
+		uint64_t check (0);
+		blake2b_state hash;
+		blake2b_init (&hash, 5);
+		blake2b_update (&hash, key.pub.bytes.data (), key.pub.bytes.size ());
+		blake2b_final (&hash, reinterpret_cast<uint8_t *> (&check), 5);
+		chratos::uint512_t number_l (key.pub.number ());
+		number_l <<= 40;
+		number_l |= chratos::uint512_t (check);
+		for (auto j (0); j < 60; ++j)
+		{
+			uint8_t r (number_l & static_cast<uint8_t> (0x1f));
+			number_l >>= 5;
+			expected.push_back ("13456789abcdefghijkmnopqrstuwxyz"[r]);
+		}
+		expected.append ("_rhc");
+		std::reverse (expected.begin (), expected.end ());
+		ASSERT_EQ (expected, key.pub.to_account ());
+	}
+}
+
 TEST (uint256_union, account_encode_lex)
 {
 	chratos::uint256_union min ("0000000000000000000000000000000000000000000000000000000000000000");
@@ -377,6 +460,42 @@ TEST (uint256_union, account_encode_lex)
 	}
 }
 
+TEST (uint128_union, number_round_trip)
+{
+	std::vector<chratos::uint128_t> values{ 0, 1, 0xff, 0x100, std::numeric_limits<uint64_t>::max (), chratos::uint128_t (1) << 64, chratos::uint128_t ("0xFEDCBA9876543210FEDCBA9876543210"), chratos::uint128_t ("0x0123456789ABCDEF0123456789ABCDEF"), std::numeric_limits<chratos::uint128_t>::max () };
+	for (auto & value : values)
+	{
+		chratos::uint128_union union_l (value);
+		// Byte-wise big-endian reference for the word-wise conversions
+		auto number_l (value);
+		for (auto i (union_l.bytes.rbegin ()), n (union_l.bytes.rend ()); i != n; ++i)
+		{
+			ASSERT_EQ (static_cast<uint8_t> (number_l & 0xff), *i);
+			number_l >>= 8;
+		}
+		ASSERT_EQ (value, union_l.number ());
+		chratos::uint128_union decoded;
+		ASSERT_FALSE (decoded.decode_dec (value.convert_to<std::string> ()));
+		ASSERT_EQ (union_l, decoded);
+	}
+}
+
+TEST (uint256_union, number_round_trip)
+{
+	std::vector<chratos::uint256_t> values{ 0, 1, 0xff, std::numeric_limits<uint64_t>::max (), chratos::uint256_t (1) << 64, chratos::uint256_t (1) << 128, chratos::uint256_t (1) << 192, chratos::uint256_t ("0x0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF"), std::numeric_limits<chratos::uint256_t>::max () };
+	for (auto & value : values)
+	{
+		chratos::uint256_union union_l (value);
+		auto number_l (value);
+		for (auto i (union_l.bytes.rbegin ()), n (union_l.bytes.rend ()); i != n; ++i)
+		{
+			ASSERT_EQ (static_cast<uint8_t> (number_l & 0xff), *i);
+			number_l >>= 8;
+		}
+		ASSERT_EQ (value, union_l.number ());
+	}
+}
+
 TEST (uint256_union, bounds)
 {
 	chratos::uint256_union key;
@@ -618,6 +618,96 @@ TEST (wallet, work)
 	}
 }
 
+TEST (wallet, work_precache)
+{
+	chratos::system system (24000, 1);
+	auto wallet (system.wallet (0));
+	chratos::keypair key;
+	// No work requested on insert, the precache service has to find it
+	wallet->insert_adhoc (key.prv, false);
+	system.wallet (0)->wallets.precache.trigger ();
+	auto done (false);
+	system.deadline_set (10s);
+	while (!done)
+	{
+		auto transaction (system.nodes[0]->store.tx_begin ());
+		uint64_t work (0);
+		if (!wallet->store.work_get (transaction, key.pub, work))
+		{
+			done = !chratos::work_validate (key.pub, work);
+		}
+		ASSERT_NO_ERROR (system.poll ());
+	}
+}
+
+TEST (wallet, work_precache_urgent)
+{
+	chratos::system system (24000, 1);
+	system.nodes[0]->config.work_precache_budget = 0;
+	auto wallet (system.wallet (0));
+	wallet->insert_adhoc (chratos::test_genesis_key.prv);
+	chratos::keypair key1;
+	chratos::keypair key2;
+	wallet->insert_adhoc (key1.prv, false);
+	wallet->insert_adhoc (key2.prv, false);
+	ASSERT_NE (nullptr, wallet->send_action (chratos::test_genesis_key.pub, key2.pub, 100));
+	auto entries (wallet->wallets.precache.scan ());
+	auto position1 (std::find_if (entries.begin (), entries.end (), [&key1](chratos::work_precache_entry const & entry_a) { return entry_a.account == key1.pub; }));
+	auto position2 (std::find_if (entries.begin (), entries.end (), [&key2](chratos::work_precache_entry const & entry_a) { return entry_a.account == key2.pub; }));
+	ASSERT_NE (entries.end (), position1);
+	ASSERT_NE (entries.end (), position2);
+	ASSERT_FALSE (position1->urgent);
+	ASSERT_TRUE (position2->urgent);
+	ASSERT_LT (position2, position1);
+}
+
+TEST (wallet, kdf_parallel)
+{
+	chratos::kdf serial;
+	chratos::kdf parallel (4);
+	std::vector<chratos::uint256_union> salts (8);
+	for (size_t i (0); i < salts.size (); ++i)
+	{
+		salts[i] = chratos::uint256_union (i + 1);
+	}
+	std::vector<chratos::raw_key> expected (salts.size ());
+	for (size_t i (0); i < salts.size (); ++i)
+	{
+		serial.phs (expected[i], "password", salts[i]);
+	}
+	std::vector<chratos::raw_key> keys (salts.size ());
+	std::vector<std::thread> threads;
+	for (size_t i (0); i < salts.size (); ++i)
+	{
+		threads.emplace_back ([&parallel, &keys, &salts, i]() {
+			parallel.phs (keys[i], "password", salts[i], true);
+		});
+	}
+	for (auto & thread : threads)
+	{
+		thread.join ();
+	}
+	ASSERT_EQ (0u, parallel.active);
+	ASSERT_EQ (salts.size (), parallel.cache.size ());
+	for (size_t i (0); i < salts.size (); ++i)
+	{
+		ASSERT_EQ (expected[i], keys[i]);
+		chratos::raw_key cached;
+		parallel.phs (cached, "password", salts[i]);
+		ASSERT_EQ (expected[i], cached);
+	}
+	chratos::raw_key other;
+	parallel.phs (other, "other", salts[0]);
+	ASSERT_NE (expected[0], other);
+	ASSERT_LE (1, chratos::kdf::parallel_for_budget (0));
+	// Only derivations asked to be kept are cached
+	ASSERT_TRUE (serial.cache.empty ());
+	ASSERT_EQ (salts.size (), parallel.cache.size ());
+	parallel.clear ();
+	ASSERT_TRUE (parallel.cache.empty ());
+	ASSERT_TRUE (parallel.cache_order.empty ());
+}
+
 TEST (wallet, work_generate)
 {
 	chratos::system system (24000, 1);
@@ -72,6 +72,91 @@ TEST (wallets, remove)
 	}
 }
 
+TEST (wallets, representative_cache)
+{
+	chratos::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	auto wallet (system.wallet (0));
+	{
+		// Keys derived for the startup unlocks are dropped once they're done
+		std::lock_guard<std::mutex> lock (node.wallets.kdf.mutex);
+		ASSERT_TRUE (node.wallets.kdf.cache.empty ());
+	}
+	chratos::keypair key1;
+	wallet->insert_adhoc (chratos::test_genesis_key.prv);
+	wallet->insert_adhoc (key1.prv);
+	{
+		std::lock_guard<std::mutex> lock (wallet->representatives_mutex);
+		ASSERT_EQ (1, wallet->representatives.size ());
+		ASSERT_NE (wallet->representatives.end (), wallet->representatives.find (chratos::test_genesis_key.pub));
+		ASSERT_TRUE (wallet->representative_keys.empty ());
+	}
+	auto count (0);
+	{
+		auto transaction (node.store.tx_begin_read ());
+		node.wallets.foreach_representative (transaction, [&count](chratos::public_key const & pub_a, chratos::raw_key const & prv_a) {
+			ASSERT_EQ (chratos::test_genesis_key.pub, pub_a);
+			ASSERT_EQ (chratos::test_genesis_key.prv, prv_a);
+			++count;
+		});
+	}
+	ASSERT_EQ (1, count);
+	{
+		std::lock_guard<std::mutex> lock (wallet->representatives_mutex);
+		ASSERT_EQ (1, wallet->representative_keys.size ());
+	}
+	wallet->lock ();
+	{
+		std::lock_guard<std::mutex> lock (wallet->representatives_mutex);
+		ASSERT_TRUE (wallet->representative_keys.empty ());
+	}
+	{
+		// Derived keys aren't kept around for a locked wallet
+		std::lock_guard<std::mutex> lock (node.wallets.kdf.mutex);
+		ASSERT_TRUE (node.wallets.kdf.cache.empty ());
+	}
+	count = 0;
+	{
+		auto transaction (node.store.tx_begin_read ());
+		node.wallets.foreach_representative (transaction, [&count](chratos::public_key const &, chratos::raw_key const &) {
+			++count;
+		});
+	}
+	ASSERT_EQ (0, count);
+	{
+		auto transaction (node.wallets.tx_begin_write ());
+		ASSERT_FALSE (wallet->enter_password (transaction, ""));
+	}
+	{
+		auto transaction (node.store.tx_begin_read ());
+		node.wallets.foreach_representative (transaction, [&count](chratos::public_key const &, chratos::raw_key const &) {
+			++count;
+		});
+	}
+	ASSERT_EQ (1, count);
+}
+
+TEST (wallets, representative_update)
+{
+	chratos::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	auto wallet (system.wallet (0));
+	chratos::keypair key1;
+	wallet->insert_adhoc (key1.prv);
+	{
+		std::lock_guard<std::mutex> lock (wallet->representatives_mutex);
+		ASSERT_TRUE (wallet->representatives.empty ());
+	}
+	chratos::genesis genesis;
+	auto change (std::make_shared<chratos::state_block> (chratos::test_genesis_key.pub, genesis.hash (), key1.pub, chratos::genesis_amount, 0, 0, chratos::test_genesis_key.prv, chratos::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	node.block_processor.add (change, std::chrono::steady_clock::now ());
+	// Flushing waits for the wallets to be checked after the batch is committed
+	node.block_processor.flush ();
+	ASSERT_EQ (change->hash (), node.latest (chratos::test_genesis_key.pub));
+	std::lock_guard<std::mutex> lock (wallet->representatives_mutex);
+	ASSERT_NE (wallet->representatives.end (), wallet->representatives.find (key1.pub));
+}
+
 // Keeps breaking whenever we add new DBs
 TEST (wallets, DISABLED_wallet_create_max)
 {
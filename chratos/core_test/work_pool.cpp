@@ -3,6 +3,8 @@
 #include <chratos/node/node.hpp>
 #include <chratos/node/wallet.hpp>
 
+#include <future>
+
 TEST (work, one)
 {
 	chratos::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
@@ -55,6 +57,57 @@ TEST (work, cancel_many)
 	pool.cancel (key1);
 }
 
+TEST (work, difficulty)
+{
+	chratos::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	chratos::uint256_union root (1);
+	uint64_t difficulty (0xfff0000000000000);
+	auto work (pool.generate (root, difficulty));
+	ASSERT_GE (chratos::work_value (root, work), difficulty);
+	ASSERT_FALSE (chratos::work_validate (root, work));
+}
+
+TEST (work, priority)
+{
+	chratos::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	chratos::uint256_union root1 (1);
+	chratos::uint256_union root2 (2);
+	std::promise<bool> cancelled;
+	// Effectively unsolvable, must not hold up the higher priority request behind it
+	pool.generate (root1, [&cancelled](boost::optional<uint64_t> work_a) {
+		cancelled.set_value (!work_a);
+	},
+	std::numeric_limits<uint64_t>::max (), chratos::work_priority::background);
+	auto work (pool.generate (root2, chratos::work_pool::publish_threshold, chratos::work_priority::interactive));
+	ASSERT_FALSE (chratos::work_validate (root2, work));
+	ASSERT_EQ (1, pool.stats ().queue_depth);
+	pool.cancel (root1);
+	ASSERT_TRUE (cancelled.get_future ().get ());
+	auto stats (pool.stats ());
+	ASSERT_EQ (0, stats.queue_depth);
+	ASSERT_EQ (1, stats.solved);
+	ASSERT_EQ (1, stats.cancelled);
+	ASSERT_LE (stats.solve_time_max, stats.solve_time_total);
+}
+
+TEST (work, concurrent)
+{
+	chratos::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	std::vector<std::promise<uint64_t>> works (16);
+	for (auto i (0); i < works.size (); ++i)
+	{
+		auto & work (works[i]);
+		pool.generate (chratos::uint256_union (i + 1), [&work](boost::optional<uint64_t> work_a) {
+			work.set_value (work_a.value ());
+		});
+	}
+	for (auto i (0); i < works.size (); ++i)
+	{
+		ASSERT_FALSE (chratos::work_validate (chratos::uint256_union (i + 1), works[i].get_future ().get ()));
+	}
+	ASSERT_EQ (works.size (), pool.stats ().solved);
+}
+
 TEST (work, DISABLED_opencl)
 {
 	chratos::logging logging;
@@ -91,3 +144,28 @@ TEST (work, opencl_config)
 	ASSERT_EQ (2, config2.device);
 	ASSERT_EQ (3, config2.threads);
 }
+
+TEST (work, kernels)
+{
+	for (auto kernel : { chratos::work_kernel::scalar, chratos::work_kernel::avx2, chratos::work_kernel::avx512 })
+	{
+		if (chratos::work_kernel_supported (kernel))
+		{
+			for (auto i (0); i < 16; ++i)
+			{
+				chratos::uint256_union root;
+				chratos::random_pool.GenerateBlock (root.bytes.data (), root.bytes.size ());
+				std::array<uint64_t, chratos::work_kernel_batch> nonces;
+				chratos::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (nonces.data ()), nonces.size () * sizeof (uint64_t));
+				std::array<uint64_t, chratos::work_kernel_batch> values;
+				chratos::work_kernel_values (kernel, root, nonces.data (), values.data ());
+				for (size_t j (0); j < nonces.size (); ++j)
+				{
+					ASSERT_EQ (chratos::work_value (root, nonces[j]), values[j]);
+				}
+			}
+		}
+	}
+	ASSERT_TRUE (chratos::work_kernel_supported (chratos::work_kernel::scalar));
+	ASSERT_TRUE (chratos::work_kernel_supported (chratos::work_pool (1, nullptr).kernel));
+}
@@ -14,6 +14,8 @@ std::string nano::error_common_messages::message (int ev) const
 			return "Account not found in wallet";
 		case nano::error_common::bad_account_number:
 			return "Bad account number";
+		case nano::error_common::bad_difficulty_format:
+			return "Bad difficulty";
 		case nano::error_common::bad_private_key:
 			return "Bad private key";
 		case nano::error_common::bad_public_key:
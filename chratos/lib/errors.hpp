@@ -32,6 +32,7 @@ enum class error_common
 	account_not_found_wallet,
 	account_exists,
 	bad_account_number,
+	bad_difficulty_format,
 	bad_private_key,
 	bad_public_key,
 	bad_seed,
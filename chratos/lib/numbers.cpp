@@ -5,6 +5,8 @@
 
 #include <blake2/blake2.h>
 
+#include <boost/endian/conversion.hpp>
+
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 
@@ -21,46 +23,101 @@ uint8_t base58_decode (char value)
 	return result;
 }
 char const * account_lookup ("13456789abcdefghijkmnopqrstuwxyz");
-char const * account_reverse ("~0~1234567~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~89:;<=>?@AB~CDEFGHIJK~LMNO~~~~~");
-char account_encode (uint8_t value)
-{
-	assert (value < 32);
-	auto result (account_lookup[value]);
+char const * hex_lookup ("0123456789ABCDEF");
+uint8_t const invalid_digit (0xff);
+// Reverse tables cover every byte value so decoding needs no range checks, characters outside the alphabet map to invalid_digit
+std::array<uint8_t, 256> const account_reverse ([]() {
+	std::array<uint8_t, 256> result;
+	result.fill (invalid_digit);
+	for (uint8_t i (0); i < 32; ++i)
+	{
+		result[static_cast<uint8_t> (account_lookup[i])] = i;
+	}
 	return result;
+}());
+std::array<uint8_t, 256> const hex_reverse ([]() {
+	std::array<uint8_t, 256> result;
+	result.fill (invalid_digit);
+	for (uint8_t i (0); i < 16; ++i)
+	{
+		result[static_cast<uint8_t> (hex_lookup[i])] = i;
+		result[static_cast<uint8_t> (std::tolower (hex_lookup[i]))] = i;
+	}
+	return result;
+}());
+// An account is 3 zero bytes, the 32 byte key and the 5 byte checksum; 40 bytes encode to 64 characters of which the first 4 are always zero
+size_t const account_buffer_size (40);
+size_t const account_padding (4);
+
+template <size_t N>
+void encode_hex_bytes (std::array<uint8_t, N> const & bytes_a, std::string & text_a)
+{
+	assert (text_a.empty ());
+	text_a.resize (N * 2);
+	for (size_t i (0); i < N; ++i)
+	{
+		text_a[2 * i] = hex_lookup[bytes_a[i] >> 4];
+		text_a[2 * i + 1] = hex_lookup[bytes_a[i] & 0xf];
+	}
 }
-uint8_t account_decode (char value)
+
+// Text is right aligned, shorter input has implicit leading zeros. A leading "0x" is skipped but counts towards the length
+template <size_t N>
+bool decode_hex_bytes (std::string const & text_a, std::array<uint8_t, N> & bytes_a)
 {
-	assert (value >= '0');
-	assert (value <= '~');
-	auto result (account_reverse[value - 0x30]);
-	if (result != '~')
+	auto error (text_a.size () > N * 2);
+	if (!error)
 	{
-		result -= 0x30;
+		std::array<uint8_t, N> result;
+		result.fill (0);
+		uint8_t invalid (0);
+		size_t prefix (text_a.compare (0, 2, "0x") == 0 ? 2 : 0);
+		auto digit (text_a.rbegin ());
+		for (size_t i (0), n (text_a.size () - prefix); i < n; ++i, ++digit)
+		{
+			auto value (hex_reverse[static_cast<uint8_t> (*digit)]);
+			invalid |= value;
+			result[N - 1 - i / 2] |= (value & 0xf) << (4 * (i & 1));
+		}
+		error = (invalid & 0xf0) != 0;
+		if (!error)
+		{
+			bytes_a = result;
+		}
 	}
-	return result;
+	return error;
 }
 }
 
 void chratos::uint256_union::encode_account (std::string & destination_a) const
 {
 	assert (destination_a.empty ());
-	destination_a.reserve (64);
-	uint64_t check (0);
+	std::array<uint8_t, 5> check;
 	blake2b_state hash;
-	blake2b_init (&hash, 5);
+	blake2b_init (&hash, check.size ());
 	blake2b_update (&hash, bytes.data (), bytes.size ());
-	blake2b_final (&hash, reinterpret_cast<uint8_t *> (&check), 5);
-	chratos::uint512_t number_l (number ());
-	number_l <<= 40;
-	number_l |= chratos::uint512_t (check);
-	for (auto i (0); i < 60; ++i)
+	blake2b_final (&hash, check.data (), check.size ());
+	std::array<uint8_t, account_buffer_size> buffer;
+	buffer.fill (0);
+	std::copy (bytes.begin (), bytes.end (), buffer.begin () + 3);
+	// The checksum is appended as a little endian number
+	std::reverse_copy (check.begin (), check.end (), buffer.end () - check.size ());
+	destination_a.resize (64);
+	// Each 5 byte group is exactly 8 characters
+	for (size_t group (0); group < account_buffer_size / 5; ++group)
 	{
-		uint8_t r (number_l & static_cast<uint8_t> (0x1f));
-		number_l >>= 5;
-		destination_a.push_back (account_encode (r));
+		uint64_t value (0);
+		for (size_t i (0); i < 5; ++i)
+		{
+			value = (value << 8) | buffer[group * 5 + i];
+		}
+		for (size_t i (0); i < 8; ++i)
+		{
+			destination_a[group * 8 + i] = account_lookup[(value >> (35 - 5 * i)) & 0x1f];
+		}
 	}
-	destination_a.append ("_rhc"); // chr_
-	std::reverse (destination_a.begin (), destination_a.end ());
+	// Padding characters are replaced by the prefix
+	destination_a.replace (0, account_padding, "chr_");
 }
 
 std::string chratos::uint256_union::to_account () const
@@ -85,32 +142,37 @@ bool chratos::uint256_union::decode_account (std::string const & source_a)
 				auto i (source_a.begin () + (chr_prefix ? 4 : 5));
 				if (*i == '1' || *i == '3')
 				{
-					chratos::uint512_t number_l;
-					for (auto j (source_a.end ()); !error && i != j; ++i)
+					std::array<uint8_t, 64> digits;
+					digits.fill (0);
+					uint8_t invalid (0);
+					for (auto j (digits.begin () + account_padding), m (digits.end ()); j != m; ++i, ++j)
 					{
-						uint8_t character (*i);
-						error = character < 0x30 || character >= 0x80;
-						if (!error)
+						*j = account_reverse[static_cast<uint8_t> (*i)];
+						invalid |= *j;
+					}
+					error = (invalid & 0xe0) != 0;
+					if (!error)
+					{
+						std::array<uint8_t, account_buffer_size> buffer;
+						for (size_t group (0); group < account_buffer_size / 5; ++group)
 						{
-							uint8_t byte (account_decode (character));
-							error = byte == '~';
-							if (!error)
+							uint64_t value (0);
+							for (size_t j (0); j < 8; ++j)
+							{
+								value = (value << 5) | digits[group * 8 + j];
+							}
+							for (size_t j (0); j < 5; ++j)
 							{
-								number_l <<= 5;
-								number_l += byte;
+								buffer[group * 5 + j] = static_cast<uint8_t> (value >> (32 - 8 * j));
 							}
 						}
-					}
-					if (!error)
-					{
-						*this = (number_l >> 40).convert_to<chratos::uint256_t> ();
-						uint64_t check (number_l & static_cast<uint64_t> (0xffffffffff));
-						uint64_t validation (0);
+						std::copy (buffer.begin () + 3, buffer.begin () + 3 + bytes.size (), bytes.begin ());
+						std::array<uint8_t, 5> validation;
 						blake2b_state hash;
-						blake2b_init (&hash, 5);
+						blake2b_init (&hash, validation.size ());
 						blake2b_update (&hash, bytes.data (), bytes.size ());
-						blake2b_final (&hash, reinterpret_cast<uint8_t *> (&validation), 5);
-						error = check != validation;
+						blake2b_final (&hash, validation.data (), validation.size ());
+						error = !std::equal (validation.rbegin (), validation.rend (), buffer.end () - validation.size ());
 					}
 				}
 				else
@@ -130,16 +192,16 @@ bool chratos::uint256_union::decode_account (std::string const & source_a)
 chratos::uint256_union::uint256_union (chratos::uint256_t const & number_a)
 {
 	chratos::uint256_t number_l (number_a);
-	for (auto i (bytes.rbegin ()), n (bytes.rend ()); i != n; ++i)
+	for (auto i (qwords.rbegin ()), n (qwords.rend ()); i != n; ++i)
 	{
-		*i = static_cast<uint8_t> (number_l & static_cast<uint8_t> (0xff));
-		number_l >>= 8;
+		*i = boost::endian::native_to_big (static_cast<uint64_t> (number_l));
+		number_l >>= 64;
 	}
 }
 
 bool chratos::uint256_union::operator== (chratos::uint256_union const & other_a) const
 {
-	return bytes == other_a.bytes;
+	return qwords[0] == other_a.qwords[0] && qwords[1] == other_a.qwords[1] && qwords[2] == other_a.qwords[2] && qwords[3] == other_a.qwords[3];
 }
 
 // Construct a uint256_union = AES_ENC_CTR (cleartext, key, iv)
@@ -164,7 +226,14 @@ std::string chratos::uint256_union::to_string () const
 
 bool chratos::uint256_union::operator< (chratos::uint256_union const & other_a) const
 {
-	return number () < other_a.number ();
+	// Bytes are stored big endian, the first differing qword decides
+	size_t i (0);
+	size_t n (qwords.size () - 1);
+	while (i < n && qwords[i] == other_a.qwords[i])
+	{
+		++i;
+	}
+	return boost::endian::big_to_native (qwords[i]) < boost::endian::big_to_native (other_a.qwords[i]);
 }
 
 chratos::uint256_union & chratos::uint256_union::operator^= (chratos::uint256_union const & other_a)
@@ -204,50 +273,23 @@ chratos::uint256_t chratos::uint256_union::number () const
 {
 	chratos::uint256_t result;
 	auto shift (0);
-	for (auto i (bytes.begin ()), n (bytes.end ()); i != n; ++i)
+	for (auto i (qwords.begin ()), n (qwords.end ()); i != n; ++i)
 	{
 		result <<= shift;
-		result |= *i;
-		shift = 8;
+		result |= boost::endian::big_to_native (*i);
+		shift = 64;
 	}
 	return result;
 }
 
 void chratos::uint256_union::encode_hex (std::string & text) const
 {
-	assert (text.empty ());
-	std::stringstream stream;
-	stream << std::hex << std::noshowbase << std::setw (64) << std::setfill ('0');
-	stream << number ();
-	text = stream.str ();
+	encode_hex_bytes (bytes, text);
 }
 
 bool chratos::uint256_union::decode_hex (std::string const & text)
 {
-	auto error (false);
-	if (!text.empty () && text.size () <= 64)
-	{
-		std::stringstream stream (text);
-		stream << std::hex << std::noshowbase;
-		chratos::uint256_t number_l;
-		try
-		{
-			stream >> number_l;
-			*this = number_l;
-			if (!stream.eof ())
-			{
-				error = true;
-			}
-		}
-		catch (std::runtime_error &)
-		{
-			error = true;
-		}
-	}
-	else
-	{
-		error = true;
-	}
+	auto error (text.empty () || decode_hex_bytes (text, bytes));
 	return error;
 }
 
@@ -330,35 +372,12 @@ chratos::uint512_t chratos::uint512_union::number () const
 
 void chratos::uint512_union::encode_hex (std::string & text) const
 {
-	assert (text.empty ());
-	std::stringstream stream;
-	stream << std::hex << std::noshowbase << std::setw (128) << std::setfill ('0');
-	stream << number ();
-	text = stream.str ();
+	encode_hex_bytes (bytes, text);
 }
 
 bool chratos::uint512_union::decode_hex (std::string const & text)
 {
-	auto error (text.size () > 128);
-	if (!error)
-	{
-		std::stringstream stream (text);
-		stream << std::hex << std::noshowbase;
-		chratos::uint512_t number_l;
-		try
-		{
-			stream >> number_l;
-			*this = number_l;
-			if (!stream.eof ())
-			{
-				error = true;
-			}
-		}
-		catch (std::runtime_error &)
-		{
-			error = true;
-		}
-	}
+	auto error (decode_hex_bytes (text, bytes));
 	return error;
 }
 
@@ -454,12 +473,8 @@ chratos::uint128_union::uint128_union (uint64_t value_a)
 
 chratos::uint128_union::uint128_union (chratos::uint128_t const & value_a)
 {
-	chratos::uint128_t number_l (value_a);
-	for (auto i (bytes.rbegin ()), n (bytes.rend ()); i != n; ++i)
-	{
-		*i = static_cast<uint8_t> (number_l & static_cast<uint8_t> (0xff));
-		number_l >>= 8;
-	}
+	qwords[0] = boost::endian::native_to_big (static_cast<uint64_t> (value_a >> 64));
+	qwords[1] = boost::endian::native_to_big (static_cast<uint64_t> (value_a));
 }
 
 bool chratos::uint128_union::operator== (chratos::uint128_union const & other_a) const
@@ -474,58 +489,32 @@ bool chratos::uint128_union::operator!= (chratos::uint128_union const & other_a)
 
 bool chratos::uint128_union::operator< (chratos::uint128_union const & other_a) const
 {
-	return number () < other_a.number ();
+	// Bytes are stored big endian, the first differing qword decides
+	size_t i (qwords[0] == other_a.qwords[0] ? 1 : 0);
+	return boost::endian::big_to_native (qwords[i]) < boost::endian::big_to_native (other_a.qwords[i]);
 }
 
 bool chratos::uint128_union::operator> (chratos::uint128_union const & other_a) const
 {
-	return number () > other_a.number ();
+	return other_a < *this;
 }
 
 chratos::uint128_t chratos::uint128_union::number () const
 {
-	chratos::uint128_t result;
-	auto shift (0);
-	for (auto i (bytes.begin ()), n (bytes.end ()); i != n; ++i)
-	{
-		result <<= shift;
-		result |= *i;
-		shift = 8;
-	}
+	chratos::uint128_t result (boost::endian::big_to_native (qwords[0]));
+	result <<= 64;
+	result |= boost::endian::big_to_native (qwords[1]);
 	return result;
 }
 
 void chratos::uint128_union::encode_hex (std::string & text) const
 {
-	assert (text.empty ());
-	std::stringstream stream;
-	stream << std::hex << std::noshowbase << std::setw (32) << std::setfill ('0');
-	stream << number ();
-	text = stream.str ();
+	encode_hex_bytes (bytes, text);
 }
 
 bool chratos::uint128_union::decode_hex (std::string const & text)
 {
-	auto error (text.size () > 32);
-	if (!error)
-	{
-		std::stringstream stream (text);
-		stream << std::hex << std::noshowbase;
-		chratos::uint128_t number_l;
-		try
-		{
-			stream >> number_l;
-			*this = number_l;
-			if (!stream.eof ())
-			{
-				error = true;
-			}
-		}
-		catch (std::runtime_error &)
-		{
-			error = true;
-		}
-	}
+	auto error (decode_hex_bytes (text, bytes));
 	return error;
 }
 
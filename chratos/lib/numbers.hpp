@@ -140,7 +140,8 @@ struct hash<chratos::uint256_union>
 {
 	size_t operator() (chratos::uint256_union const & data_a) const
 	{
-		return *reinterpret_cast<size_t const *> (data_a.bytes.data ());
+		// Folding every word keeps structured keys, such as small numbers, as well spread as hashes and accounts
+		return static_cast<size_t> (data_a.qwords[0] ^ data_a.qwords[1] ^ data_a.qwords[2] ^ data_a.qwords[3]);
 	}
 };
 template <>
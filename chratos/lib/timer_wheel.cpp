@@ -0,0 +1,218 @@
+#include <chratos/lib/timer_wheel.hpp>
+
+#include <algorithm>
+
+size_t constexpr chratos::timer_wheel::levels;
+size_t constexpr chratos::timer_wheel::slot_bits;
+size_t constexpr chratos::timer_wheel::slots;
+std::chrono::milliseconds constexpr chratos::timer_wheel::tick;
+uint32_t constexpr chratos::timer_wheel::none;
+
+chratos::timer_wheel::timer_wheel (std::chrono::steady_clock::time_point origin_a) :
+origin (origin_a),
+current (0)
+{
+	heads.fill (none);
+	tails.fill (none);
+	level_size.fill (0);
+}
+
+uint64_t chratos::timer_wheel::tick_of (std::chrono::steady_clock::time_point const & time_a) const
+{
+	uint64_t result (0);
+	if (time_a > origin)
+	{
+		// Rounded up so nothing runs before its time
+		auto elapsed (time_a - origin);
+		result = std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count () / tick.count ();
+		if (tick * result < elapsed)
+		{
+			++result;
+		}
+	}
+	return result;
+}
+
+chratos::timer_handle chratos::timer_wheel::insert (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & function_a)
+{
+	uint32_t index;
+	if (!free.empty ())
+	{
+		index = free.back ();
+		free.pop_back ();
+	}
+	else
+	{
+		index = static_cast<uint32_t> (nodes.size ());
+		nodes.push_back (chratos::timer_wheel::node ());
+		nodes.back ().generation = 0;
+	}
+	auto & node (nodes[index]);
+	node.function = function_a;
+	node.due = std::max (tick_of (wakeup_a), current);
+	link (index);
+	return chratos::timer_handle { index, node.generation };
+}
+
+bool chratos::timer_wheel::cancel (chratos::timer_handle const & handle_a)
+{
+	auto result (true);
+	if (handle_a.index < nodes.size () && nodes[handle_a.index].generation == handle_a.generation && nodes[handle_a.index].slot != none)
+	{
+		unlink (handle_a.index);
+		release (handle_a.index);
+		result = false;
+	}
+	return result;
+}
+
+void chratos::timer_wheel::expire (std::chrono::steady_clock::time_point const & now_a, std::vector<std::function<void()>> & expired_a)
+{
+	uint64_t target (now_a > origin ? std::chrono::duration_cast<std::chrono::milliseconds> (now_a - origin).count () / tick.count () : 0);
+	while (current <= target)
+	{
+		if ((current & (slots - 1)) == 0)
+		{
+			// Higher levels first so operations can fall through more than one level on the same tick
+			for (auto level (levels - 1); level > 0; --level)
+			{
+				if ((current & ((uint64_t (1) << (slot_bits * level)) - 1)) == 0)
+				{
+					cascade (level);
+				}
+			}
+		}
+		auto slot (current & (slots - 1));
+		while (heads[slot] != none)
+		{
+			auto index (heads[slot]);
+			expired_a.push_back (std::move (nodes[index].function));
+			unlink (index);
+			release (index);
+		}
+		++current;
+		if (level_size[0] == 0)
+		{
+			// Nothing can become due before the next cascade
+			current = std::min (target + 1, next_boundary ());
+		}
+	}
+}
+
+std::chrono::steady_clock::time_point chratos::timer_wheel::next () const
+{
+	auto result (std::chrono::steady_clock::time_point::max ());
+	if (level_size[0] > 0)
+	{
+		auto tick_l (current);
+		while (heads[tick_l & (slots - 1)] == none)
+		{
+			++tick_l;
+		}
+		if (level_size[0] < size ())
+		{
+			// Operations in the upper levels may cascade into a slot ahead of the first occupied one
+			tick_l = std::min (tick_l, next_boundary ());
+		}
+		result = origin + tick * tick_l;
+	}
+	else if (size () > 0)
+	{
+		// Skip level 0 rounds whose level 1 slot is empty, up to the next level 2 cascade
+		auto boundary (next_boundary ());
+		while (heads[slots + (boundary >> slot_bits & (slots - 1))] == none && (boundary & ((uint64_t (1) << (slot_bits * 2)) - 1)) != 0)
+		{
+			boundary += slots;
+		}
+		result = origin + tick * boundary;
+	}
+	return result;
+}
+
+uint64_t chratos::timer_wheel::next_boundary () const
+{
+	return (current + slots - 1) & ~uint64_t (slots - 1);
+}
+
+size_t chratos::timer_wheel::size () const
+{
+	size_t result (0);
+	for (auto i : level_size)
+	{
+		result += i;
+	}
+	return result;
+}
+
+void chratos::timer_wheel::link (uint32_t index_a)
+{
+	auto & node (nodes[index_a]);
+	auto delta (node.due - current);
+	size_t level (0);
+	while (level < levels - 1 && delta >= (uint64_t (1) << (slot_bits * (level + 1))))
+	{
+		++level;
+	}
+	// Beyond the range of the last level the operation waits in its furthest slot and is placed again from there
+	auto due (std::min (node.due, current + (uint64_t (1) << (slot_bits * levels)) - 1));
+	auto slot (static_cast<uint32_t> (level * slots + (due >> (slot_bits * level) & (slots - 1))));
+	node.slot = slot;
+	node.next = none;
+	node.previous = tails[slot];
+	if (tails[slot] != none)
+	{
+		nodes[tails[slot]].next = index_a;
+	}
+	else
+	{
+		heads[slot] = index_a;
+	}
+	tails[slot] = index_a;
+	++level_size[level];
+}
+
+void chratos::timer_wheel::unlink (uint32_t index_a)
+{
+	auto & node (nodes[index_a]);
+	if (node.previous != none)
+	{
+		nodes[node.previous].next = node.next;
+	}
+	else
+	{
+		heads[node.slot] = node.next;
+	}
+	if (node.next != none)
+	{
+		nodes[node.next].previous = node.previous;
+	}
+	else
+	{
+		tails[node.slot] = node.previous;
+	}
+	--level_size[node.slot / slots];
+	node.slot = none;
+}
+
+void chratos::timer_wheel::release (uint32_t index_a)
+{
+	auto & node (nodes[index_a]);
+	node.function = nullptr;
+	++node.generation;
+	free.push_back (index_a);
+}
+
+void chratos::timer_wheel::cascade (size_t level_a)
+{
+	auto slot (level_a * slots + (current >> (slot_bits * level_a) & (slots - 1)));
+	auto index (heads[slot]);
+	heads[slot] = none;
+	tails[slot] = none;
+	while (index != none)
+	{
+		auto next (nodes[index].next);
+		--level_size[level_a];
+		link (index);
+		index = next;
+	}
+}
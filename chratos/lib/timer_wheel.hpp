@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace chratos
+{
+/** Identifies a scheduled operation so it can be cancelled, stale handles are detected by the generation */
+class timer_handle
+{
+public:
+	uint32_t index;
+	uint32_t generation;
+};
+
+/**
+ * Hierarchical timer wheel with millisecond ticks.
+ * Four levels of 256 slots each cover about 49 days, operations further out are parked in the last level and
+ * cascaded again until they come into range. Inserting and cancelling are constant time, and operations are kept in a
+ * pooled intrusive list so neither allocates once the pool has grown. Not thread safe
+ */
+class timer_wheel
+{
+public:
+	timer_wheel (std::chrono::steady_clock::time_point = std::chrono::steady_clock::now ());
+	chratos::timer_handle insert (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	/** Returns true if the operation already ran or was cancelled */
+	bool cancel (chratos::timer_handle const &);
+	/** Appends every operation due at or before the given time to the vector, earliest first */
+	void expire (std::chrono::steady_clock::time_point const &, std::vector<std::function<void()>> &);
+	/** Time at which expire should next be called, time_point::max () when empty */
+	std::chrono::steady_clock::time_point next () const;
+	size_t size () const;
+	static size_t constexpr levels = 4;
+	static size_t constexpr slot_bits = 8;
+	static size_t constexpr slots = 1 << slot_bits;
+	static std::chrono::milliseconds constexpr tick = std::chrono::milliseconds (1);
+
+private:
+	class node
+	{
+	public:
+		std::function<void()> function;
+		uint64_t due;
+		uint32_t previous;
+		uint32_t next;
+		uint32_t generation;
+		uint32_t slot;
+	};
+	void link (uint32_t);
+	void unlink (uint32_t);
+	void release (uint32_t);
+	void cascade (size_t);
+	uint64_t tick_of (std::chrono::steady_clock::time_point const &) const;
+	/** First tick at or after current where the upper levels cascade */
+	uint64_t next_boundary () const;
+	static uint32_t constexpr none = ~uint32_t (0);
+	std::chrono::steady_clock::time_point origin;
+	// Ticks before this one have been expired
+	uint64_t current;
+	std::vector<chratos::timer_wheel::node> nodes;
+	std::vector<uint32_t> free;
+	std::array<uint32_t, levels * slots> heads;
+	std::array<uint32_t, levels * slots> tails;
+	std::array<size_t, levels> level_size;
+};
+}
@@ -55,6 +55,9 @@ namespace thread_role
 			case chratos::thread_role::name::voting:
 				thread_role_name_string = "Voting";
 				break;
+			case chratos::thread_role::name::work_precache:
+				thread_role_name_string = "Work precache";
+				break;
 		}
 
 		/*
@@ -4,6 +4,7 @@
 #include <boost/system/error_code.hpp>
 #include <boost/thread/thread.hpp>
 
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <thread>
@@ -41,6 +42,7 @@ namespace thread_role
 		wallet_actions,
 		bootstrap_initiator,
 		voting,
+		work_precache,
 	};
 	chratos::thread_role::name get (void);
 	void set (chratos::thread_role::name);
@@ -72,6 +74,118 @@ public:
 	std::mutex mutex;
 	std::vector<std::function<void(T...)>> observers;
 };
+
+/**
+ * Bounded lock-free multi-producer/multi-consumer queue of trivially copyable values.
+ * Each cell carries a sequence number which tells producers and consumers whose turn it is, capacity is rounded up to a power of two.
+ */
+template <typename T>
+class mpmc_queue
+{
+public:
+	mpmc_queue (size_t capacity_a) :
+	cells (capacity (capacity_a)),
+	mask (cells.size () - 1),
+	head (0),
+	tail (0)
+	{
+		for (size_t i (0); i < cells.size (); ++i)
+		{
+			cells[i].sequence.store (i, std::memory_order_relaxed);
+		}
+	}
+	// Returns false if the queue is full
+	bool push (T const & value_a)
+	{
+		auto result (false);
+		auto position (tail.load (std::memory_order_relaxed));
+		auto done (false);
+		while (!done)
+		{
+			auto & cell (cells[position & mask]);
+			auto difference (static_cast<intptr_t> (cell.sequence.load (std::memory_order_acquire)) - static_cast<intptr_t> (position));
+			if (difference == 0)
+			{
+				if (tail.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+				{
+					cell.value = value_a;
+					cell.sequence.store (position + 1, std::memory_order_release);
+					result = true;
+					done = true;
+				}
+			}
+			else if (difference < 0)
+			{
+				done = true;
+			}
+			else
+			{
+				position = tail.load (std::memory_order_relaxed);
+			}
+		}
+		return result;
+	}
+	// Returns false if the queue is empty
+	bool pop (T & value_a)
+	{
+		auto result (false);
+		auto position (head.load (std::memory_order_relaxed));
+		auto done (false);
+		while (!done)
+		{
+			auto & cell (cells[position & mask]);
+			auto difference (static_cast<intptr_t> (cell.sequence.load (std::memory_order_acquire)) - static_cast<intptr_t> (position + 1));
+			if (difference == 0)
+			{
+				if (head.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+				{
+					value_a = cell.value;
+					cell.sequence.store (position + mask + 1, std::memory_order_release);
+					result = true;
+					done = true;
+				}
+			}
+			else if (difference < 0)
+			{
+				done = true;
+			}
+			else
+			{
+				position = head.load (std::memory_order_relaxed);
+			}
+		}
+		return result;
+	}
+	// Approximate while other threads are pushing or popping
+	bool empty () const
+	{
+		return head.load () >= tail.load ();
+	}
+
+private:
+	static size_t capacity (size_t capacity_a)
+	{
+		size_t result (2);
+		while (result < capacity_a)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+	class cell
+	{
+	public:
+		std::atomic<size_t> sequence;
+		T value;
+	};
+	std::vector<cell> cells;
+	size_t const mask;
+	// Producers and consumers work on separate cache lines
+	char padding1[64];
+	std::atomic<size_t> head;
+	char padding2[64];
+	std::atomic<size_t> tail;
+};
 }
 
 void release_assert_internal (bool check, const char * check_expr, const char * file, unsigned int line);
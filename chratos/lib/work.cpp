@@ -3,8 +3,17 @@
 #include <chratos/lib/blocks.hpp>
 #include <chratos/node/xorshift.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <future>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHRATOS_WORK_X86 1
+#include <immintrin.h>
+#endif
+
 bool chratos::work_validate (chratos::block_hash const & root_a, uint64_t work_a)
 {
 	return chratos::work_value (root_a, work_a) < chratos::work_pool::publish_threshold;
@@ -26,12 +35,262 @@ uint64_t chratos::work_value (chratos::block_hash const & root_a, uint64_t work_
 	return result;
 }
 
+namespace
+{
+/*
+ * The work hash is an unkeyed 8 byte blake2b of the nonce followed by the root. At 40 bytes the message fits in a
+ * single compression with fixed length and finalization flag, so the initial state is constant, only message word 0
+ * varies per nonce and words 1-4 hold the root for every attempt
+ */
+uint64_t const work_iv[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+// Parameter block for an 8 byte digest with fanout and depth of 1
+uint64_t const work_h0 = work_iv[0] ^ 0x01010008ULL;
+uint64_t const work_message_size = sizeof (uint64_t) + sizeof (chratos::block_hash);
+uint8_t const work_sigma[10][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+	{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+	{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+	{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+	{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+	{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+	{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+	{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+	{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 }
+};
+
+// Kernels share the compression through these macros so each expands inside a function compiled for its instruction set
+#define CHRATOS_WORK_G(ADD, XOR, ROTR, a, b, c, d, x, y) \
+	a = ADD (ADD (a, b), x);                              \
+	d = ROTR (XOR (d, a), 32);                            \
+	c = ADD (c, d);                                       \
+	b = ROTR (XOR (b, c), 24);                            \
+	a = ADD (ADD (a, b), y);                              \
+	d = ROTR (XOR (d, a), 16);                            \
+	c = ADD (c, d);                                       \
+	b = ROTR (XOR (b, c), 63);
+
+#define CHRATOS_WORK_HASH(V, SET1, ADD, XOR, ROTR, nonces, root, output)                                  \
+	{                                                                                                      \
+		V m[16];                                                                                           \
+		m[0] = nonces;                                                                                     \
+		for (auto i (0); i < 4; ++i)                                                                       \
+		{                                                                                                  \
+			m[1 + i] = SET1 (root[i]);                                                                     \
+		}                                                                                                  \
+		for (auto i (5); i < 16; ++i)                                                                      \
+		{                                                                                                  \
+			m[i] = SET1 (0);                                                                               \
+		}                                                                                                  \
+		V v[16];                                                                                           \
+		v[0] = SET1 (work_h0);                                                                             \
+		for (auto i (1); i < 8; ++i)                                                                       \
+		{                                                                                                  \
+			v[i] = SET1 (work_iv[i]);                                                                      \
+		}                                                                                                  \
+		for (auto i (0); i < 4; ++i)                                                                       \
+		{                                                                                                  \
+			v[8 + i] = SET1 (work_iv[i]);                                                                  \
+		}                                                                                                  \
+		v[12] = SET1 (work_iv[4] ^ work_message_size);                                                     \
+		v[13] = SET1 (work_iv[5]);                                                                         \
+		v[14] = SET1 (~work_iv[6]);                                                                        \
+		v[15] = SET1 (work_iv[7]);                                                                         \
+		for (auto r (0); r < 12; ++r)                                                                      \
+		{                                                                                                  \
+			auto const * s (work_sigma[r % 10]);                                                           \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[0], v[4], v[8], v[12], m[s[0]], m[s[1]])                     \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[1], v[5], v[9], v[13], m[s[2]], m[s[3]])                     \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[2], v[6], v[10], v[14], m[s[4]], m[s[5]])                    \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[3], v[7], v[11], v[15], m[s[6]], m[s[7]])                    \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[0], v[5], v[10], v[15], m[s[8]], m[s[9]])                    \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[1], v[6], v[11], v[12], m[s[10]], m[s[11]])                  \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[2], v[7], v[8], v[13], m[s[12]], m[s[13]])                   \
+			CHRATOS_WORK_G (ADD, XOR, ROTR, v[3], v[4], v[9], v[14], m[s[14]], m[s[15]])                   \
+		}                                                                                                  \
+		output = XOR (SET1 (work_h0), XOR (v[0], v[8]));                                                   \
+	}
+
+#define CHRATOS_WORK_SCALAR_SET1(x) static_cast<uint64_t> (x)
+#define CHRATOS_WORK_SCALAR_ADD(a, b) ((a) + (b))
+#define CHRATOS_WORK_SCALAR_XOR(a, b) ((a) ^ (b))
+#define CHRATOS_WORK_SCALAR_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+/** Reads the root as the little endian message words blake2b would load */
+std::array<uint64_t, 4> work_root_words (chratos::block_hash const & root_a)
+{
+	std::array<uint64_t, 4> result;
+	for (auto i (0); i < 4; ++i)
+	{
+		result[i] = 0;
+		for (auto j (0); j < 8; ++j)
+		{
+			result[i] |= static_cast<uint64_t> (root_a.bytes[i * 8 + j]) << (8 * j);
+		}
+	}
+	return result;
+}
+
+void work_values_scalar (std::array<uint64_t, 4> const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	for (size_t lane (0); lane < chratos::work_kernel_batch; ++lane)
+	{
+		uint64_t nonce;
+		// The nonce is hashed in memory order, the same bytes blake2b_update would see
+		uint8_t bytes[sizeof (nonce)];
+		std::memcpy (bytes, &nonces_a[lane], sizeof (bytes));
+		nonce = 0;
+		for (auto j (0); j < 8; ++j)
+		{
+			nonce |= static_cast<uint64_t> (bytes[j]) << (8 * j);
+		}
+		uint64_t output;
+		CHRATOS_WORK_HASH (uint64_t, CHRATOS_WORK_SCALAR_SET1, CHRATOS_WORK_SCALAR_ADD, CHRATOS_WORK_SCALAR_XOR, CHRATOS_WORK_SCALAR_ROTR, nonce, root_a, output)
+		for (auto j (0); j < 8; ++j)
+		{
+			bytes[j] = static_cast<uint8_t> (output >> (8 * j));
+		}
+		std::memcpy (&values_a[lane], bytes, sizeof (bytes));
+	}
+}
+
+#ifdef CHRATOS_WORK_X86
+#define CHRATOS_WORK_AVX2_SET1(x) _mm256_set1_epi64x (static_cast<long long> (x))
+#define CHRATOS_WORK_AVX2_ROTR(x, n) _mm256_or_si256 (_mm256_srli_epi64 ((x), (n)), _mm256_slli_epi64 ((x), 64 - (n)))
+
+__attribute__ ((target ("avx2"))) void work_values_avx2 (std::array<uint64_t, 4> const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	for (size_t lane (0); lane < chratos::work_kernel_batch; lane += 4)
+	{
+		auto nonces (_mm256_loadu_si256 (reinterpret_cast<__m256i const *> (nonces_a + lane)));
+		__m256i output;
+		CHRATOS_WORK_HASH (__m256i, CHRATOS_WORK_AVX2_SET1, _mm256_add_epi64, _mm256_xor_si256, CHRATOS_WORK_AVX2_ROTR, nonces, root_a, output)
+		_mm256_storeu_si256 (reinterpret_cast<__m256i *> (values_a + lane), output);
+	}
+}
+
+#define CHRATOS_WORK_AVX512_SET1(x) _mm512_set1_epi64 (static_cast<long long> (x))
+
+__attribute__ ((target ("avx512f"))) void work_values_avx512 (std::array<uint64_t, 4> const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	static_assert (chratos::work_kernel_batch == 8, "One AVX-512 pass covers the batch");
+	auto nonces (_mm512_loadu_si512 (nonces_a));
+	__m512i output;
+	CHRATOS_WORK_HASH (__m512i, CHRATOS_WORK_AVX512_SET1, _mm512_add_epi64, _mm512_xor_si512, _mm512_ror_epi64, nonces, root_a, output)
+	_mm512_storeu_si512 (values_a, output);
+}
+#endif
+}
+
+bool chratos::work_kernel_supported (chratos::work_kernel kernel_a)
+{
+	auto result (false);
+	switch (kernel_a)
+	{
+		case chratos::work_kernel::scalar:
+			result = true;
+			break;
+#ifdef CHRATOS_WORK_X86
+		case chratos::work_kernel::avx2:
+			__builtin_cpu_init ();
+			result = __builtin_cpu_supports ("avx2");
+			break;
+		case chratos::work_kernel::avx512:
+			__builtin_cpu_init ();
+			result = __builtin_cpu_supports ("avx512f");
+			break;
+#endif
+		default:
+			break;
+	}
+	return result;
+}
+
+chratos::work_kernel chratos::work_kernel_best ()
+{
+	auto result (chratos::work_kernel::scalar);
+	if (work_kernel_supported (chratos::work_kernel::avx512))
+	{
+		result = chratos::work_kernel::avx512;
+	}
+	else if (work_kernel_supported (chratos::work_kernel::avx2))
+	{
+		result = chratos::work_kernel::avx2;
+	}
+	return result;
+}
+
+std::string chratos::work_kernel_name (chratos::work_kernel kernel_a)
+{
+	std::string result;
+	switch (kernel_a)
+	{
+		case chratos::work_kernel::scalar:
+			result = "scalar";
+			break;
+		case chratos::work_kernel::avx2:
+			result = "avx2";
+			break;
+		case chratos::work_kernel::avx512:
+			result = "avx512";
+			break;
+	}
+	return result;
+}
+
+void chratos::work_kernel_values (chratos::work_kernel kernel_a, chratos::block_hash const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	assert (work_kernel_supported (kernel_a));
+	auto root (work_root_words (root_a));
+	switch (kernel_a)
+	{
+#ifdef CHRATOS_WORK_X86
+		case chratos::work_kernel::avx512:
+			work_values_avx512 (root, nonces_a, values_a);
+			break;
+		case chratos::work_kernel::avx2:
+			work_values_avx2 (root, nonces_a, values_a);
+			break;
+#endif
+		default:
+			work_values_scalar (root, nonces_a, values_a);
+			break;
+	}
+}
+
+chratos::work_item::work_item (chratos::uint256_union const & root_a, uint64_t difficulty_a, chratos::work_priority priority_a, uint64_t sequence_a, std::function<void(boost::optional<uint64_t> const &)> callback_a) :
+root (root_a),
+difficulty (difficulty_a),
+priority (priority_a),
+sequence (sequence_a),
+arrival (std::chrono::steady_clock::now ()),
+callback (callback_a),
+threads (0),
+finished (false)
+{
+}
+
+double chratos::work_item::weight () const
+{
+	// 2^64 / (2^64 - difficulty)
+	return std::ldexp (1.0, 64) / (static_cast<double> (~difficulty) + 1.0);
+}
+
 chratos::work_pool::work_pool (unsigned max_threads_a, std::function<boost::optional<uint64_t> (chratos::uint256_union const &)> opencl_a) :
-ticket (0),
+generation (0),
 done (false),
-opencl (opencl_a)
+sequence (0),
+solved (0),
+cancelled (0),
+solve_time_total (0),
+solve_time_max (0),
+opencl (opencl_a),
+kernel (chratos::work_kernel_best ())
 {
-	static_assert (ATOMIC_INT_LOCK_FREE == 2, "Atomic int needed");
+	static_assert (ATOMIC_LLONG_LOCK_FREE == 2, "Atomic 64 bit integer needed");
 	boost::thread::attributes attrs;
 	chratos::thread_attributes::set (attrs);
 	auto count (chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? 1 : std::min (max_threads_a, std::max (1u, boost::thread::hardware_concurrency ())));
@@ -55,6 +314,35 @@ chratos::work_pool::~work_pool ()
 	}
 }
 
+/**
+ * Picks the request the calling thread should search. Only the highest priority class present is considered and
+ * within it threads are spread in proportion to the expected number of attempts, so a burst of equal requests gets
+ * one thread each while a single hard request still gets them all. Equal scores go to the oldest request. Requires mutex to be held
+ */
+std::shared_ptr<chratos::work_item> chratos::work_pool::select ()
+{
+	std::shared_ptr<chratos::work_item> result;
+	double best (0.0);
+	for (auto & i : pending)
+	{
+		if (result == nullptr || i->priority > result->priority)
+		{
+			result = i;
+			best = i->weight () / (i->threads + 1);
+		}
+		else if (i->priority == result->priority)
+		{
+			auto score (i->weight () / (i->threads + 1));
+			if (score > best || (score == best && i->sequence < result->sequence))
+			{
+				result = i;
+				best = score;
+			}
+		}
+	}
+	return result;
+}
+
 void chratos::work_pool::loop (uint64_t thread)
 {
 	// Quick RNG for work attempts.
@@ -62,8 +350,8 @@ void chratos::work_pool::loop (uint64_t thread)
 	chratos::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (rng.s.data ()), rng.s.size () * sizeof (decltype (rng.s)::value_type));
 	uint64_t work;
 	uint64_t output;
-	blake2b_state hash;
-	blake2b_init (&hash, sizeof (output));
+	std::array<uint64_t, chratos::work_kernel_batch> nonces;
+	std::array<uint64_t, chratos::work_kernel_batch> values;
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!done || !pending.empty ())
 	{
@@ -75,44 +363,44 @@ void chratos::work_pool::loop (uint64_t thread)
 		}
 		if (!empty)
 		{
-			auto current_l (pending.front ());
-			int ticket_l (ticket);
+			auto current_l (select ());
+			++current_l->threads;
+			uint64_t generation_l (generation);
 			lock.unlock ();
 			output = 0;
-			// ticket != ticket_l indicates a different thread found a solution and we should stop
-			while (ticket == ticket_l && output < chratos::work_pool::publish_threshold)
+			// A finished item was solved by another thread or cancelled, a new generation means the pending set changed and this thread may be needed elsewhere
+			while (!current_l->finished && generation == generation_l && output < current_l->difficulty)
 			{
 				// Don't query main memory every iteration in order to reduce memory bus traffic
 				// All operations here operate on stack memory
 				// Count iterations down to zero since comparing to zero is easier than comparing to another number
-				unsigned iteration (256);
-				while (iteration && output < chratos::work_pool::publish_threshold)
+				unsigned iteration (256 / chratos::work_kernel_batch);
+				while (iteration && output < current_l->difficulty)
 				{
-					work = rng.next ();
-					blake2b_update (&hash, reinterpret_cast<uint8_t *> (&work), sizeof (work));
-					blake2b_update (&hash, current_l.first.bytes.data (), current_l.first.bytes.size ());
-					blake2b_final (&hash, reinterpret_cast<uint8_t *> (&output), sizeof (output));
-					blake2b_init (&hash, sizeof (output));
+					for (auto & nonce : nonces)
+					{
+						nonce = rng.next ();
+					}
+					work_kernel_values (kernel, current_l->root, nonces.data (), values.data ());
+					for (size_t i (0); i < chratos::work_kernel_batch && output < current_l->difficulty; ++i)
+					{
+						work = nonces[i];
+						output = values[i];
+					}
 					iteration -= 1;
 				}
 			}
 			lock.lock ();
-			if (ticket == ticket_l)
+			--current_l->threads;
+			if (output >= current_l->difficulty && !current_l->finished)
 			{
-				// If the ticket matches what we started with, we're the ones that found the solution
-				assert (output >= chratos::work_pool::publish_threshold);
-				assert (work_value (current_l.first, work) == output);
-				// Signal other threads to stop their work next time they check ticket
-				++ticket;
-				pending.pop_front ();
+				// First thread to reach the difficulty owns the result
+				assert (work_value (current_l->root, work) == output);
+				solve (current_l);
 				lock.unlock ();
-				current_l.second (work);
+				current_l->callback (work);
 				lock.lock ();
 			}
-			else
-			{
-				// A different thread found a solution
-			}
 		}
 		else
 		{
@@ -122,29 +410,46 @@ void chratos::work_pool::loop (uint64_t thread)
 	}
 }
 
+/** Marks the item finished, removes it from pending and records its solve time. Requires mutex to be held */
+void chratos::work_pool::solve (std::shared_ptr<chratos::work_item> const & item_a)
+{
+	item_a->finished = true;
+	pending.erase (std::remove (pending.begin (), pending.end (), item_a), pending.end ());
+	++solved;
+	auto elapsed (std::chrono::steady_clock::now () - item_a->arrival);
+	solve_time_total += elapsed;
+	solve_time_max = std::max (solve_time_max, elapsed);
+	++generation;
+}
+
 void chratos::work_pool::cancel (chratos::uint256_union const & root_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	if (!pending.empty ())
+	std::vector<std::shared_ptr<chratos::work_item>> cancelled_l;
 	{
-		if (pending.front ().first == root_a)
-		{
-			++ticket;
-		}
-	}
-	pending.remove_if ([&root_a](decltype (pending)::value_type const & item_a) {
-		bool result;
-		if (item_a.first == root_a)
+		std::lock_guard<std::mutex> lock (mutex);
+		for (auto & i : pending)
 		{
-			item_a.second (boost::none);
-			result = true;
+			if (i->root == root_a)
+			{
+				i->finished = true;
+				cancelled_l.push_back (i);
+			}
 		}
-		else
+		if (!cancelled_l.empty ())
 		{
-			result = false;
+			pending.erase (std::remove_if (pending.begin (), pending.end (), [](std::shared_ptr<chratos::work_item> const & item_a) {
+				return item_a->finished.load ();
+			}),
+			pending.end ());
+			cancelled += cancelled_l.size ();
+			++generation;
 		}
-		return result;
-	});
+	}
+	// Callbacks run outside the lock so they may queue new requests
+	for (auto & i : cancelled_l)
+	{
+		i->callback (boost::none);
+	}
 }
 
 void chratos::work_pool::stop ()
@@ -154,18 +459,20 @@ void chratos::work_pool::stop ()
 	producer_condition.notify_all ();
 }
 
-void chratos::work_pool::generate (chratos::uint256_union const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a)
+void chratos::work_pool::generate (chratos::uint256_union const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, uint64_t difficulty_a, chratos::work_priority priority_a)
 {
 	assert (!root_a.is_zero ());
 	boost::optional<uint64_t> result;
-	if (opencl)
+	// OpenCL generates against the publish threshold only
+	if (opencl && difficulty_a <= chratos::work_pool::publish_threshold)
 	{
 		result = opencl (root_a);
 	}
 	if (!result)
 	{
 		std::lock_guard<std::mutex> lock (mutex);
-		pending.push_back (std::make_pair (root_a, callback_a));
+		pending.push_back (std::make_shared<chratos::work_item> (root_a, difficulty_a, priority_a, sequence++, callback_a));
+		++generation;
 		producer_condition.notify_all ();
 	}
 	else
@@ -174,12 +481,28 @@ void chratos::work_pool::generate (chratos::uint256_union const & root_a, std::f
 	}
 }
 
-uint64_t chratos::work_pool::generate (chratos::uint256_union const & hash_a)
+uint64_t chratos::work_pool::generate (chratos::uint256_union const & hash_a, uint64_t difficulty_a, chratos::work_priority priority_a)
 {
 	std::promise<boost::optional<uint64_t>> work;
 	generate (hash_a, [&work](boost::optional<uint64_t> work_a) {
 		work.set_value (work_a);
-	});
+	},
+	difficulty_a, priority_a);
 	auto result (work.get_future ().get ());
 	return result.value ();
 }
+
+chratos::work_pool_stats chratos::work_pool::stats ()
+{
+	chratos::work_pool_stats result;
+	std::lock_guard<std::mutex> lock (mutex);
+	result.queue_depth = pending.size ();
+	result.active = std::count_if (pending.begin (), pending.end (), [](std::shared_ptr<chratos::work_item> const & item_a) {
+		return item_a->threads != 0;
+	});
+	result.solved = solved;
+	result.cancelled = cancelled;
+	result.solve_time_total = std::chrono::duration_cast<std::chrono::milliseconds> (solve_time_total);
+	result.solve_time_max = std::chrono::duration_cast<std::chrono::milliseconds> (solve_time_max);
+	return result;
+}
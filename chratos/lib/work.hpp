@@ -7,6 +7,7 @@
 #include <chratos/lib/utility.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <thread>
@@ -17,7 +18,58 @@ class block;
 bool work_validate (chratos::block_hash const &, uint64_t);
 bool work_validate (chratos::block const &);
 uint64_t work_value (chratos::block_hash const &, uint64_t);
+/** Implementations of the work hash, the vector kernels hash several nonces side by side */
+enum class work_kernel
+{
+	scalar,
+	avx2,
+	avx512
+};
+/** Number of nonces hashed by each work_kernel_values call */
+size_t const work_kernel_batch = 8;
+bool work_kernel_supported (chratos::work_kernel);
+/** Fastest kernel this CPU supports, checked at runtime */
+chratos::work_kernel work_kernel_best ();
+std::string work_kernel_name (chratos::work_kernel);
+/** Computes work_value of work_kernel_batch nonces against one root */
+void work_kernel_values (chratos::work_kernel, chratos::block_hash const &, uint64_t const *, uint64_t *);
 class opencl_work;
+/** Scheduling class of a work request, threads go to the highest class with outstanding requests */
+enum class work_priority : uint8_t
+{
+	background,
+	normal,
+	interactive
+};
+/** Outstanding work request, shared by every thread searching its root */
+class work_item
+{
+public:
+	work_item (chratos::uint256_union const &, uint64_t, chratos::work_priority, uint64_t, std::function<void(boost::optional<uint64_t> const &)>);
+	/** Expected number of attempts to reach the difficulty, used to weight thread allocation */
+	double weight () const;
+	chratos::uint256_union root;
+	uint64_t difficulty;
+	chratos::work_priority priority;
+	// Arrival order, older requests win ties
+	uint64_t sequence;
+	std::chrono::steady_clock::time_point arrival;
+	std::function<void(boost::optional<uint64_t> const &)> callback;
+	// Number of threads currently searching this root, guarded by work_pool::mutex
+	unsigned threads;
+	// Set once the request is solved or cancelled so searching threads drop it
+	std::atomic<bool> finished;
+};
+class work_pool_stats
+{
+public:
+	size_t queue_depth;
+	size_t active;
+	uint64_t solved;
+	uint64_t cancelled;
+	std::chrono::milliseconds solve_time_total;
+	std::chrono::milliseconds solve_time_max;
+};
 class work_pool
 {
 public:
@@ -26,19 +78,31 @@ public:
 	void loop (uint64_t);
 	void stop ();
 	void cancel (chratos::uint256_union const &);
-	void generate (chratos::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>);
-	uint64_t generate (chratos::uint256_union const &);
-	std::atomic<int> ticket;
+	void generate (chratos::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>, uint64_t = chratos::work_pool::publish_threshold, chratos::work_priority = chratos::work_priority::normal);
+	uint64_t generate (chratos::uint256_union const &, uint64_t = chratos::work_pool::publish_threshold, chratos::work_priority = chratos::work_priority::normal);
+	chratos::work_pool_stats stats ();
+	// Incremented whenever the set of pending requests changes so searching threads reconsider their assignment
+	std::atomic<uint64_t> generation;
 	bool done;
 	std::vector<boost::thread> threads;
-	std::list<std::pair<chratos::uint256_union, std::function<void(boost::optional<uint64_t> const &)>>> pending;
+	std::vector<std::shared_ptr<chratos::work_item>> pending;
+	uint64_t sequence;
+	uint64_t solved;
+	uint64_t cancelled;
+	std::chrono::steady_clock::duration solve_time_total;
+	std::chrono::steady_clock::duration solve_time_max;
 	std::mutex mutex;
 	std::condition_variable producer_condition;
 	std::function<boost::optional<uint64_t> (chratos::uint256_union const &)> opencl;
+	chratos::work_kernel kernel;
 	chratos::observer_set<bool> work_observers;
 	// Local work threshold for rate-limiting publishing blocks. ~5 seconds of work.
 	static uint64_t const publish_test_threshold = 0xff00000000000000;
 	static uint64_t const publish_full_threshold = 0xffffffc000000000;
 	static uint64_t const publish_threshold = chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? publish_test_threshold : publish_full_threshold;
+
+private:
+	std::shared_ptr<chratos::work_item> select ();
+	void solve (std::shared_ptr<chratos::work_item> const &);
 };
 }
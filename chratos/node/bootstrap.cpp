@@ -13,10 +13,46 @@ constexpr unsigned bootstrap_frontier_retry_limit = 16;
 constexpr double bootstrap_minimum_termination_time_sec = 30.0;
 constexpr unsigned bootstrap_max_new_connections = 10;
 constexpr unsigned bulk_push_cost_limit = 200;
+constexpr double bootstrap_throughput_weight = 0.3;
+constexpr uint64_t bootstrap_large_pull_blocks = 1000;
+constexpr size_t bootstrap_max_queued_blocks = 8192;
+constexpr std::chrono::milliseconds bootstrap_retry_backoff = std::chrono::milliseconds (250);
+constexpr std::chrono::milliseconds bootstrap_retry_backoff_max = std::chrono::seconds (15);
+constexpr unsigned bootstrap_frontier_ranges = 4;
+constexpr std::chrono::seconds bootstrap_checkpoint_interval = std::chrono::seconds (1);
+
+size_t constexpr chratos::bootstrap_attempt::lazy_max_keys;
+std::chrono::milliseconds constexpr chratos::socket_sweeper::interval;
+
+namespace
+{
+class lazy_balance_visitor : public chratos::block_visitor
+{
+public:
+	lazy_balance_visitor () :
+	balance (0)
+	{
+	}
+	void state_block (chratos::state_block const & block_a) override
+	{
+		balance = block_a.hashables.balance.number ();
+	}
+	void dividend_block (chratos::dividend_block const & block_a) override
+	{
+		balance = block_a.hashables.balance.number ();
+	}
+	void claim_block (chratos::claim_block const & block_a) override
+	{
+		balance = block_a.hashables.balance.number ();
+	}
+	chratos::uint128_t balance;
+};
+}
 
 chratos::socket::socket (std::shared_ptr<chratos::node> node_a) :
 socket_m (node_a->service),
-ticket (0),
+deadline (0),
+tracked (false),
 node (node_a)
 {
 }
@@ -54,27 +90,63 @@ void chratos::socket::async_write (std::shared_ptr<std::vector<uint8_t>> buffer_
 
 void chratos::socket::start (std::chrono::steady_clock::time_point timeout_a)
 {
-	auto ticket_l (++ticket);
-	std::weak_ptr<chratos::socket> this_w (shared_from_this ());
-	node->alarm.add (timeout_a, [this_w, ticket_l]() {
-		if (auto this_l = this_w.lock ())
+	deadline = timeout_a.time_since_epoch ().count ();
+	if (!tracked.exchange (true))
+	{
+		node->socket_sweeper.add (shared_from_this ());
+	}
+}
+
+void chratos::socket::stop ()
+{
+	deadline = 0;
+}
+
+void chratos::socket::check_deadline (std::chrono::steady_clock::time_point const & now_a)
+{
+	auto deadline_l (deadline.load ());
+	if (deadline_l != 0 && deadline_l < now_a.time_since_epoch ().count () && deadline.compare_exchange_strong (deadline_l, 0))
+	{
+		if (node->config.logging.bulk_pull_logging ())
 		{
-			if (this_l->ticket == ticket_l)
-			{
-				if (this_l->node->config.logging.bulk_pull_logging ())
-				{
-					BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Disconnecting from %1% due to timeout") % this_l->remote_endpoint ());
-				}
+			BOOST_LOG (node->log) << boost::str (boost::format ("Disconnecting from %1% due to timeout") % remote_endpoint ());
+		}
+		close ();
+	}
+}
 
-				this_l->close ();
+void chratos::socket_sweeper::add (std::shared_ptr<chratos::socket> socket_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	sockets.push_back (socket_a);
+}
+
+void chratos::socket_sweeper::sweep (std::chrono::steady_clock::time_point const & now_a)
+{
+	std::vector<std::shared_ptr<chratos::socket>> live;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		live.reserve (sockets.size ());
+		auto end (std::remove_if (sockets.begin (), sockets.end (), [&live](std::weak_ptr<chratos::socket> const & socket_a) {
+			auto socket_l (socket_a.lock ());
+			if (socket_l != nullptr)
+			{
+				live.push_back (socket_l);
 			}
-		}
-	});
+			return socket_l == nullptr;
+		}));
+		sockets.erase (end, sockets.end ());
+	}
+	for (auto & socket : live)
+	{
+		socket->check_deadline (now_a);
+	}
 }
 
-void chratos::socket::stop ()
+size_t chratos::socket_sweeper::size ()
 {
-	++ticket;
+	std::lock_guard<std::mutex> lock (mutex);
+	return sockets.size ();
 }
 
 void chratos::socket::close ()
@@ -107,6 +179,10 @@ receive_buffer (std::make_shared<std::vector<uint8_t>> ()),
 endpoint (endpoint_a),
 start_time (std::chrono::steady_clock::now ()),
 block_count (0),
+throughput (0.0),
+throughput_blocks (0),
+throughput_sample (std::chrono::steady_clock::now ()),
+pulling (false),
 pending_stop (false),
 hard_stop (false)
 {
@@ -130,6 +206,22 @@ double chratos::bootstrap_client::elapsed_seconds () const
 	return std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - start_time).count ();
 }
 
+void chratos::bootstrap_client::update_throughput ()
+{
+	assert (!attempt->mutex.try_lock ());
+	auto now (std::chrono::steady_clock::now ());
+	auto blocks (block_count.load ());
+	auto elapsed (std::chrono::duration_cast<std::chrono::duration<double>> (now - throughput_sample).count ());
+	// Only sample while a pull is in flight so time spent idle doesn't count against the peer
+	if (pulling && elapsed > 0.0)
+	{
+		auto sample ((blocks - throughput_blocks) / elapsed);
+		throughput = bootstrap_throughput_weight * sample + (1.0 - bootstrap_throughput_weight) * throughput.load ();
+	}
+	throughput_blocks = blocks;
+	throughput_sample = now;
+}
+
 void chratos::bootstrap_client::stop (bool force)
 {
 	pending_stop = true;
@@ -175,7 +267,7 @@ void chratos::bootstrap_client::run ()
 void chratos::frontier_req_client::run ()
 {
 	std::unique_ptr<chratos::frontier_req> request (new chratos::frontier_req);
-	request->start.clear ();
+	request->start = start;
 	request->age = std::numeric_limits<decltype (request->age)>::max ();
 	request->count = std::numeric_limits<decltype (request->count)>::max ();
 	auto send_buffer (std::make_shared<std::vector<uint8_t>> ());
@@ -204,18 +296,23 @@ std::shared_ptr<chratos::bootstrap_client> chratos::bootstrap_client::shared ()
 	return shared_from_this ();
 }
 
-chratos::frontier_req_client::frontier_req_client (std::shared_ptr<chratos::bootstrap_client> connection_a) :
+chratos::frontier_req_client::frontier_req_client (std::shared_ptr<chratos::bootstrap_client> connection_a, chratos::account const & start_a, chratos::account const & end_a) :
 connection (connection_a),
+start (start_a),
+end (end_a),
 current (0),
 count (0),
+complete (false),
 bulk_push_cost (0)
 {
 	auto transaction (connection->node->store.tx_begin_read ());
-	next (transaction);
+	auto iterator (connection->node->store.latest_begin (transaction, start_a));
+	next (iterator);
 }
 
 chratos::frontier_req_client::~frontier_req_client ()
 {
+	connection->attempt->frontier_finished (start, end, complete);
 }
 
 void chratos::frontier_req_client::receive_frontier ()
@@ -279,21 +376,29 @@ void chratos::frontier_req_client::received_frontier (boost::system::error_code
 		if (elapsed_sec > bootstrap_connection_warmup_time_sec && blocks_per_sec < bootstrap_minimum_frontier_blocks_per_sec)
 		{
 			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Aborting frontier req because it was too slow"));
-			promise.set_value (true);
 			return;
 		}
 		if (connection->attempt->should_log ())
 		{
 			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Received %1% frontiers from %2%") % std::to_string (count) % connection->socket->remote_endpoint ());
 		}
+		// Each frontier is compared in its own short read transaction so a slow peer doesn't pin an old ledger snapshot,
+		// the cursor is placed again just past the last local account compared
 		auto transaction (connection->node->store.tx_begin_read ());
-		if (!account.is_zero ())
+		auto iterator (connection->node->store.latest_begin (transaction, current));
+		if (iterator != connection->node->store.latest_end () && chratos::account (iterator->first) == current)
+		{
+			++iterator;
+		}
+		// The server streams to the end of its ledger, anything past our range belongs to another request
+		auto range_end (account.is_zero () || (!end.is_zero () && !(account < end)));
+		if (!range_end)
 		{
 			while (!current.is_zero () && current < account)
 			{
 				// We know about an account they don't.
 				unsynced (info.head, 0);
-				next (transaction);
+				next (iterator);
 			}
 			if (!current.is_zero ())
 			{
@@ -318,7 +423,7 @@ void chratos::frontier_req_client::received_frontier (boost::system::error_code
 							bulk_push_cost += 5;
 						}
 					}
-					next (transaction);
+					next (iterator);
 				}
 				else
 				{
@@ -330,7 +435,17 @@ void chratos::frontier_req_client::received_frontier (boost::system::error_code
 			{
 				connection->attempt->add_pull (chratos::pull_info (account, latest, chratos::block_hash (0)));
 			}
-			receive_frontier ();
+			start = chratos::uint256_union (account.number () + 1);
+			if (!start.is_zero ())
+			{
+				receive_frontier ();
+			}
+			else
+			{
+				// The last possible account was compared
+				complete = true;
+				connection->attempt->pool_connection (connection);
+			}
 		}
 		else
 		{
@@ -338,22 +453,22 @@ void chratos::frontier_req_client::received_frontier (boost::system::error_code
 			{
 				// We know about an account they don't.
 				unsynced (info.head, 0);
-				next (transaction);
+				next (iterator);
 			}
 			if (connection->node->config.logging.bulk_pull_logging ())
 			{
 				BOOST_LOG (connection->node->log) << "Bulk push cost: " << bulk_push_cost;
 			}
+			complete = true;
+			if (account.is_zero ())
 			{
-				try
-				{
-					promise.set_value (false);
-				}
-				catch (std::future_error &)
-				{
-				}
 				connection->attempt->pool_connection (connection);
 			}
+			else
+			{
+				// Frontiers past the range are still streaming, the connection can't be reused
+				connection->socket->close ();
+			}
 		}
 	}
 	else
@@ -365,13 +480,13 @@ void chratos::frontier_req_client::received_frontier (boost::system::error_code
 	}
 }
 
-void chratos::frontier_req_client::next (chratos::transaction const & transaction_a)
+void chratos::frontier_req_client::next (chratos::store_iterator<chratos::account, chratos::account_info> & iterator_a)
 {
-	auto iterator (connection->node->store.latest_begin (transaction_a, chratos::uint256_union (current.number () + 1)));
-	if (iterator != connection->node->store.latest_end ())
+	if (iterator_a != connection->node->store.latest_end () && (end.is_zero () || chratos::account (iterator_a->first) < end))
 	{
-		current = chratos::account (iterator->first);
-		info = chratos::account_info (iterator->second);
+		current = chratos::account (iterator_a->first);
+		info = chratos::account_info (iterator_a->second);
+		++iterator_a;
 	}
 	else
 	{
@@ -385,15 +500,27 @@ pull (pull_a)
 {
 	std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
 	++connection->attempt->pulling;
+	connection->pulling = true;
 	connection->attempt->condition.notify_all ();
 }
 
 chratos::bulk_pull_client::~bulk_pull_client ()
 {
+	{
+		// Either finished or requeued under its new head below
+		std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
+		connection->attempt->checkpoint_del (pull.head);
+	}
 	// If received end block is not expected end block
 	if (expected != pull.end)
 	{
 		pull.head = expected;
+		if (connection->attempt->lazy_mode)
+		{
+			// Lazy pulls start from a block hash, resume from the first block not received
+			pull.account = expected;
+		}
+		pull.failed_peer = connection->endpoint;
 		connection->attempt->requeue_pull (pull);
 		if (connection->node->config.logging.bulk_pull_logging ())
 		{
@@ -402,6 +529,7 @@ chratos::bulk_pull_client::~bulk_pull_client ()
 	}
 	std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
 	--connection->attempt->pulling;
+	connection->pulling = false;
 	connection->attempt->condition.notify_all ();
 }
 
@@ -522,7 +650,8 @@ void chratos::bulk_pull_client::received_block (boost::system::error_code const
 				block->serialize_json (block_l);
 				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
 			}
-			if (hash == expected)
+			auto block_expected (hash == expected);
+			if (block_expected)
 			{
 				expected = block->previous ();
 			}
@@ -531,10 +660,24 @@ void chratos::bulk_pull_client::received_block (boost::system::error_code const
 				connection->start_time = std::chrono::steady_clock::now ();
 			}
 			connection->attempt->total_blocks++;
-			connection->attempt->node->block_processor.add (block, std::chrono::steady_clock::time_point ());
-			if (!connection->hard_stop.load ())
+			++pull.processed;
+			auto stop_pull (false);
+			if (connection->attempt->lazy_mode && block_expected)
 			{
-				receive_block ();
+				stop_pull = connection->attempt->lazy_process_block (block);
+			}
+			if (!stop_pull)
+			{
+				connection->attempt->node->block_processor.add (block, std::chrono::steady_clock::time_point ());
+				if (!connection->hard_stop.load ())
+				{
+					receive_block ();
+				}
+			}
+			else
+			{
+				// The rest of the chain is already in the ledger, drop the connection instead of reading it
+				expected = pull.end;
 			}
 		}
 		else
@@ -682,7 +825,8 @@ void chratos::bulk_push_client::push_block (chratos::block const & block_a)
 chratos::pull_info::pull_info () :
 account (0),
 end (0),
-attempts (0)
+attempts (0),
+processed (0)
 {
 }
 
@@ -690,20 +834,24 @@ chratos::pull_info::pull_info (chratos::account const & account_a, chratos::bloc
 account (account_a),
 head (head_a),
 end (end_a),
-attempts (0)
+attempts (0),
+processed (0)
 {
 }
 
-chratos::bootstrap_attempt::bootstrap_attempt (std::shared_ptr<chratos::node> node_a) :
+chratos::bootstrap_attempt::bootstrap_attempt (std::shared_ptr<chratos::node> node_a, bool lazy_a) :
 next_log (std::chrono::steady_clock::now ()),
+frontier_ranges_active (0),
+frontier_ranges_max (0),
 connections (0),
 pulling (0),
 node (node_a),
 account_count (0),
 total_blocks (0),
-stopped (false)
+stopped (false),
+lazy_mode (lazy_a)
 {
-	BOOST_LOG (node->log) << "Starting bootstrap attempt";
+	BOOST_LOG (node->log) << (lazy_mode ? "Starting lazy bootstrap attempt" : "Starting bootstrap attempt");
 	node->bootstrap_initiator.notify_listeners (true);
 }
 
@@ -726,56 +874,124 @@ bool chratos::bootstrap_attempt::should_log ()
 	return result;
 }
 
-bool chratos::bootstrap_attempt::request_frontier (std::unique_lock<std::mutex> & lock_a)
+/**
+ * Starts comparing the next account range with the frontiers of an idle peer
+ */
+void chratos::bootstrap_attempt::request_frontier (std::unique_lock<std::mutex> & lock_a)
+{
+	assert (!frontier_ranges.empty ());
+	assert (!idle.empty ());
+	auto range (frontier_ranges.front ());
+	frontier_ranges.pop_front ();
+	++frontier_ranges_active;
+	auto connection_l (idle.back ());
+	idle.pop_back ();
+	if (range.second.is_zero ())
+	{
+		// Only the last range reads the frontier stream to its end, its connection stays usable for bulk push
+		connection_frontier_request = connection_l;
+	}
+	// The frontier_req_client destructor reports back with frontier_finished which can cause a deadlock if this is the last reference
+	node->background ([connection_l, range]() {
+		auto client (std::make_shared<chratos::frontier_req_client> (connection_l, range.first, range.second));
+		client->run ();
+	});
+}
+
+/**
+ * Called as each range's client goes away, an incomplete range is queued again from the first account it didn't reach
+ */
+void chratos::bootstrap_attempt::frontier_finished (chratos::account const & start_a, chratos::account const & end_a, bool complete_a)
 {
-	auto result (true);
-	auto connection_l (connection (lock_a));
-	connection_frontier_request = connection_l;
-	if (connection_l)
+	std::lock_guard<std::mutex> lock (mutex);
+	assert (frontier_ranges_active > 0);
+	--frontier_ranges_active;
+	if (!complete_a)
 	{
-		std::future<bool> future;
+		frontier_ranges.push_back (std::make_pair (start_a, end_a));
+		if (node->config.logging.network_logging ())
 		{
-			auto client (std::make_shared<chratos::frontier_req_client> (connection_l));
-			client->run ();
-			frontiers = client;
-			future = client->promise.get_future ();
+			BOOST_LOG (node->log) << boost::str (boost::format ("frontier_req failed, reattempting from %1%") % start_a.to_account ());
 		}
-		lock_a.unlock ();
-		result = consume_future (future);
-		lock_a.lock ();
-		if (result)
+	}
+	else if (!still_comparing ())
+	{
+		// A zero head marks the persisted pulls as covering the whole frontier scan
+		checkpoint_changes.push_back (std::make_pair (chratos::block_hash (0), chratos::pull_checkpoint ()));
+		if (node->config.logging.network_logging ())
 		{
-			pulls.clear ();
+			BOOST_LOG (node->log) << boost::str (boost::format ("Completed frontier request, %1% account pulls outstanding") % (pulls.size () + pulling));
 		}
-		if (node->config.logging.network_logging ())
+	}
+	condition.notify_all ();
+}
+
+void chratos::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock_a)
+{
+	if (idle.empty ())
+	{
+		// Return to the caller once a connection frees up, a pending frontier range may take it first
+		condition.wait (lock_a);
+	}
+	else if (!stopped && !pulls.empty ())
+	{
+		auto now (std::chrono::steady_clock::now ());
+		// Requeued pulls sit at the front until their backoff expires
+		auto ready (std::find_if (pulls.begin (), pulls.end (), [now](chratos::pull_info const & pull_a) { return pull_a.retry_after <= now; }));
+		if (ready != pulls.end ())
 		{
-			if (!result)
+			auto pull (*ready);
+			pulls.erase (ready);
+			auto connection_l (pull_connection (pull));
+			// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
+			// Dispatch request in an external thread in case it needs to be destroyed
+			node->background ([connection_l, pull]() {
+				auto client (std::make_shared<chratos::bulk_pull_client> (connection_l, pull));
+				client->request ();
+			});
+		}
+		else
+		{
+			auto next (std::min_element (pulls.begin (), pulls.end (), [](chratos::pull_info const & lhs, chratos::pull_info const & rhs) { return lhs.retry_after < rhs.retry_after; }));
+			condition.wait_until (lock_a, next->retry_after);
+		}
+	}
+}
+
+/**
+ * Picks the idle connection for a pull, chains known to be long go to the peer with the best throughput
+ * and retries avoid the peer that last failed them when another is available
+ */
+std::shared_ptr<chratos::bootstrap_client> chratos::bootstrap_attempt::pull_connection (chratos::pull_info const & pull_a)
+{
+	assert (!mutex.try_lock ());
+	assert (!idle.empty ());
+	auto result (idle.end ());
+	for (auto i (idle.begin ()), n (idle.end ()); i != n; ++i)
+	{
+		if ((*i)->endpoint != pull_a.failed_peer || pull_a.attempts == 0)
+		{
+			if (pull_a.processed >= bootstrap_large_pull_blocks)
 			{
-				BOOST_LOG (node->log) << boost::str (boost::format ("Completed frontier request, %1% out of sync accounts according to %2%") % pulls.size () % connection_l->endpoint);
+				if (result == idle.end () || (*i)->throughput > (*result)->throughput)
+				{
+					result = i;
+				}
 			}
 			else
 			{
-				BOOST_LOG (node->log) << "frontier_req failed, reattempting";
+				// Same order as before, least recently pooled connection first
+				result = i;
 			}
 		}
 	}
-	return result;
-}
-
-void chratos::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock_a)
-{
-	auto connection_l (connection (lock_a));
-	if (connection_l)
+	if (result == idle.end ())
 	{
-		auto pull (pulls.front ());
-		pulls.pop_front ();
-		// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
-		// Dispatch request in an external thread in case it needs to be destroyed
-		node->background ([connection_l, pull]() {
-			auto client (std::make_shared<chratos::bulk_pull_client> (connection_l, pull));
-			client->request ();
-		});
+		result = std::prev (idle.end ());
 	}
+	auto connection_l (*result);
+	idle.erase (result);
+	return connection_l;
 }
 
 void chratos::bootstrap_attempt::request_push (std::unique_lock<std::mutex> & lock_a)
@@ -807,42 +1023,65 @@ bool chratos::bootstrap_attempt::still_pulling ()
 	auto running (!stopped);
 	auto more_pulls (!pulls.empty ());
 	auto still_pulling (pulling > 0);
-	return running && (more_pulls || still_pulling);
+	return running && (more_pulls || still_pulling || still_comparing ());
+}
+
+bool chratos::bootstrap_attempt::still_comparing ()
+{
+	assert (!mutex.try_lock ());
+	return !frontier_ranges.empty () || frontier_ranges_active > 0;
 }
 
 void chratos::bootstrap_attempt::run ()
 {
 	populate_connections ();
+	auto resumed (!lazy_mode && checkpoint_resume ());
 	std::unique_lock<std::mutex> lock (mutex);
-	auto frontier_failure (true);
-	while (!stopped && frontier_failure)
+	if (!lazy_mode && !resumed)
 	{
-		frontier_failure = request_frontier (lock);
-	}
-	// Shuffle pulls.
-	for (int i = pulls.size () - 1; i > 0; i--)
-	{
-		auto k = chratos::random_pool.GenerateWord32 (0, i);
-		std::swap (pulls[i], pulls[k]);
+		// Account numbers are uniformly distributed so equal slices of the key space hold similar numbers of accounts
+		frontier_ranges_max = std::max (1U, std::min (bootstrap_frontier_ranges, node->config.bootstrap_connections));
+		chratos::uint256_t step (std::numeric_limits<chratos::uint256_t>::max () / frontier_ranges_max);
+		for (unsigned i (0); i < frontier_ranges_max; ++i)
+		{
+			chratos::account start (step * i);
+			chratos::account end (i + 1 < frontier_ranges_max ? chratos::account (step * (i + 1)) : chratos::account (0));
+			frontier_ranges.push_back (std::make_pair (start, end));
+		}
 	}
+	auto checkpointed (std::chrono::steady_clock::now ());
 	while (still_pulling ())
 	{
 		while (still_pulling ())
 		{
-			if (!pulls.empty ())
+			if (!lazy_mode && std::chrono::steady_clock::now () - checkpointed >= bootstrap_checkpoint_interval)
+			{
+				// Written from this thread so the io threads never wait on a store write
+				lock.unlock ();
+				checkpoint_flush ();
+				lock.lock ();
+				checkpointed = std::chrono::steady_clock::now ();
+			}
+			else if (!frontier_ranges.empty () && frontier_ranges_active < frontier_ranges_max && !idle.empty ())
 			{
-				if (!node->block_processor.full ())
+				// Pulls found by ranges already compared are requested while the remaining ranges are still being compared
+				request_frontier (lock);
+			}
+			else if (!pulls.empty ())
+			{
+				// Stop admitting pulls while the block processor has a backlog, pulled blocks would only queue behind it
+				if (node->block_processor.size () < bootstrap_max_queued_blocks)
 				{
 					request_pull (lock);
 				}
 				else
 				{
-					condition.wait_for (lock, std::chrono::seconds (15));
+					condition.wait_for (lock, std::chrono::seconds (1));
 				}
 			}
 			else
 			{
-				condition.wait (lock);
+				condition.wait_for (lock, bootstrap_checkpoint_interval);
 			}
 		}
 		// Flushing may resolve forks which can add more pulls
@@ -856,7 +1095,20 @@ void chratos::bootstrap_attempt::run ()
 	{
 		BOOST_LOG (node->log) << "Completed pulls";
 	}
-	request_push (lock);
+	if (!lazy_mode)
+	{
+		auto completed (!stopped);
+		lock.unlock ();
+		checkpoint_flush ();
+		if (completed)
+		{
+			std::lock_guard<std::mutex> checkpoint_lock (checkpoint_mutex);
+			auto transaction (node->store.tx_begin_write ());
+			node->store.bootstrap_pull_clear (transaction);
+		}
+		lock.lock ();
+		request_push (lock);
+	}
 	stopped = true;
 	condition.notify_all ();
 	idle.clear ();
@@ -895,7 +1147,7 @@ struct block_rate_cmp
 {
 	bool operator() (const std::shared_ptr<chratos::bootstrap_client> & lhs, const std::shared_ptr<chratos::bootstrap_client> & rhs) const
 	{
-		return lhs->block_rate () > rhs->block_rate ();
+		return lhs->throughput > rhs->throughput;
 	}
 };
 
@@ -924,6 +1176,7 @@ void chratos::bootstrap_attempt::populate_connections ()
 		{
 			if (auto client = c.lock ())
 			{
+				client->update_throughput ();
 				double elapsed_sec = client->elapsed_seconds ();
 				auto blocks_per_sec = client->block_rate ();
 				rate_sum += blocks_per_sec;
@@ -966,7 +1219,7 @@ void chratos::bootstrap_attempt::populate_connections ()
 
 			if (node->config.logging.bulk_pull_logging ())
 			{
-				BOOST_LOG (node->log) << boost::str (boost::format ("Dropping peer with block rate %1%, block count %2% (%3%) ") % client->block_rate () % client->block_count % client->endpoint.address ().to_string ());
+				BOOST_LOG (node->log) << boost::str (boost::format ("Dropping peer with block rate %1%, block count %2% (%3%) ") % client->throughput % client->block_count % client->endpoint.address ().to_string ());
 			}
 
 			client->stop (false);
@@ -980,7 +1233,8 @@ void chratos::bootstrap_attempt::populate_connections ()
 		BOOST_LOG (node->log) << boost::str (boost::format ("Bulk pull connections: %1%, rate: %2% blocks/sec, remaining account pulls: %3%, total blocks: %4%") % connections.load () % (int)rate_sum % pulls.size () % (int)total_blocks.load ());
 	}
 
-	if (connections < target)
+	// Pulling faster than the block processor drains only grows its queue
+	if (connections < target && node->block_processor.size () < bootstrap_max_queued_blocks)
 	{
 		auto delta = std::min ((target - connections) * 2, bootstrap_max_new_connections);
 		// TODO - tune this better
@@ -1040,16 +1294,6 @@ void chratos::bootstrap_attempt::stop ()
 			client->socket->close ();
 		}
 	}
-	if (auto i = frontiers.lock ())
-	{
-		try
-		{
-			i->promise.set_value (true);
-		}
-		catch (std::future_error &)
-		{
-		}
-	}
 	if (auto i = push.lock ())
 	{
 		try
@@ -1065,6 +1309,7 @@ void chratos::bootstrap_attempt::stop ()
 void chratos::bootstrap_attempt::add_pull (chratos::pull_info const & pull)
 {
 	std::lock_guard<std::mutex> lock (mutex);
+	checkpoint_put (pull);
 	pulls.push_back (pull);
 	condition.notify_all ();
 }
@@ -1074,7 +1319,9 @@ void chratos::bootstrap_attempt::requeue_pull (chratos::pull_info const & pull_a
 	auto pull (pull_a);
 	if (++pull.attempts < bootstrap_frontier_retry_limit)
 	{
+		pull.retry_after = std::chrono::steady_clock::now () + std::min<std::chrono::milliseconds> (bootstrap_retry_backoff * (1 << std::min (pull.attempts - 1, 6U)), bootstrap_retry_backoff_max);
 		std::lock_guard<std::mutex> lock (mutex);
+		checkpoint_put (pull);
 		pulls.push_front (pull);
 		condition.notify_all ();
 	}
@@ -1084,6 +1331,7 @@ void chratos::bootstrap_attempt::requeue_pull (chratos::pull_info const & pull_a
 		std::lock_guard<std::mutex> lock (mutex);
 		if (auto connection_shared = connection_frontier_request.lock ())
 		{
+			checkpoint_put (pull);
 			node->background ([connection_shared, pull]() {
 				auto client (std::make_shared<chratos::bulk_pull_client> (connection_shared, pull));
 				client->request ();
@@ -1109,6 +1357,186 @@ void chratos::bootstrap_attempt::add_bulk_push_target (chratos::block_hash const
 	bulk_push_targets.push_back (std::make_pair (head, end));
 }
 
+/**
+ * Loads pulls persisted by an interrupted attempt, dropping those whose head is already in the ledger.
+ * Pulls persisted before the frontier scan finished are discarded since the scan can't be resumed
+ * @return true if any pulls were resumed and the frontier scan can be skipped
+ */
+bool chratos::bootstrap_attempt::checkpoint_resume ()
+{
+	auto result (false);
+	auto scanned (false);
+	std::vector<chratos::pull_info> resumed;
+	std::vector<chratos::block_hash> reached;
+	{
+		auto transaction (node->store.tx_begin_read ());
+		for (auto i (node->store.bootstrap_pull_begin (transaction)), n (node->store.bootstrap_pull_end ()); i != n; ++i)
+		{
+			chratos::block_hash head (i->first);
+			if (head.is_zero ())
+			{
+				scanned = true;
+			}
+			else if (node->store.block_exists (transaction, head))
+			{
+				reached.push_back (head);
+			}
+			else
+			{
+				resumed.push_back (chratos::pull_info (i->second.account, head, i->second.end));
+			}
+		}
+	}
+	if (!scanned || resumed.empty ())
+	{
+		// A fresh scan starts from nothing stored, a leftover marker would pass its checkpoints off as a finished scan
+		if (scanned || !reached.empty () || !resumed.empty ())
+		{
+			std::lock_guard<std::mutex> checkpoint_lock (checkpoint_mutex);
+			auto transaction (node->store.tx_begin_write ());
+			node->store.bootstrap_pull_clear (transaction);
+		}
+		resumed.clear ();
+	}
+	else if (!reached.empty ())
+	{
+		std::lock_guard<std::mutex> checkpoint_lock (checkpoint_mutex);
+		auto transaction (node->store.tx_begin_write ());
+		for (auto & head : reached)
+		{
+			node->store.bootstrap_pull_del (transaction, head);
+		}
+	}
+	if (!resumed.empty ())
+	{
+		BOOST_LOG (node->log) << boost::str (boost::format ("Resuming bootstrap with %1% checkpointed pulls, %2% already reached") % resumed.size () % reached.size ());
+		std::lock_guard<std::mutex> lock (mutex);
+		pulls.insert (pulls.end (), resumed.begin (), resumed.end ());
+		condition.notify_all ();
+		result = true;
+	}
+	return result;
+}
+
+void chratos::bootstrap_attempt::checkpoint_put (chratos::pull_info const & pull_a)
+{
+	assert (!mutex.try_lock ());
+	if (!lazy_mode)
+	{
+		checkpoint_changes.push_back (std::make_pair (pull_a.head, chratos::pull_checkpoint (pull_a.account, pull_a.end)));
+	}
+}
+
+void chratos::bootstrap_attempt::checkpoint_del (chratos::block_hash const & head_a)
+{
+	assert (!mutex.try_lock ());
+	if (!lazy_mode)
+	{
+		checkpoint_changes.push_back (std::make_pair (head_a, boost::none));
+	}
+}
+
+void chratos::bootstrap_attempt::checkpoint_flush ()
+{
+	std::lock_guard<std::mutex> checkpoint_lock (checkpoint_mutex);
+	decltype (checkpoint_changes) changes;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		changes.swap (checkpoint_changes);
+	}
+	if (!changes.empty ())
+	{
+		auto transaction (node->store.tx_begin_write ());
+		for (auto & i : changes)
+		{
+			if (i.second)
+			{
+				node->store.bootstrap_pull_put (transaction, i.first, *i.second);
+			}
+			else
+			{
+				node->store.bootstrap_pull_del (transaction, i.first);
+			}
+		}
+	}
+}
+
+void chratos::bootstrap_attempt::lazy_start (chratos::block_hash const & hash_a)
+{
+	assert (lazy_mode);
+	auto transaction (node->store.tx_begin_read ());
+	std::lock_guard<std::mutex> lock (lazy_mutex);
+	lazy_add (transaction, hash_a);
+}
+
+void chratos::bootstrap_attempt::lazy_add (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a)
+{
+	assert (!lazy_mutex.try_lock ());
+	if (!hash_a.is_zero () && lazy_keys.size () < lazy_max_keys && !node->store.block_exists (transaction_a, hash_a) && lazy_keys.insert (hash_a).second)
+	{
+		// bulk_pull starting at a block hash sends that block and its predecessors
+		add_pull (chratos::pull_info (hash_a, hash_a, 0));
+	}
+}
+
+/**
+ * Queues the dependencies of a block pulled in lazy mode
+ * @return true if the block is already in the ledger and the rest of its chain needn't be pulled
+ */
+bool chratos::bootstrap_attempt::lazy_process_block (std::shared_ptr<chratos::block> block_a)
+{
+	auto result (false);
+	auto hash (block_a->hash ());
+	auto transaction (node->store.tx_begin_read ());
+	if (!node->store.block_exists (transaction, hash))
+	{
+		std::lock_guard<std::mutex> lock (lazy_mutex);
+		lazy_add (transaction, block_a->dividend ());
+		if (block_a->type () == chratos::block_type::state)
+		{
+			auto const & state (static_cast<chratos::state_block const &> (*block_a));
+			auto link (state.hashables.link);
+			if (!link.is_zero () && !node->ledger.is_epoch_link (link))
+			{
+				// The link is a source block only if the balance went up
+				auto previous (state.hashables.previous);
+				if (previous.is_zero ())
+				{
+					lazy_add (transaction, link);
+				}
+				else if (node->store.block_exists (transaction, previous))
+				{
+					if (state.hashables.balance.number () > node->ledger.balance (transaction, previous))
+					{
+						lazy_add (transaction, link);
+					}
+				}
+				else
+				{
+					lazy_state_unknown[previous] = std::make_pair (link, state.hashables.balance.number ());
+				}
+			}
+		}
+		// Chains arrive newest first so this may be the previous of a block already seen
+		auto unknown (lazy_state_unknown.find (hash));
+		if (unknown != lazy_state_unknown.end ())
+		{
+			lazy_balance_visitor balance;
+			block_a->visit (balance);
+			if (unknown->second.second > balance.balance)
+			{
+				lazy_add (transaction, unknown->second.first);
+			}
+			lazy_state_unknown.erase (unknown);
+		}
+	}
+	else
+	{
+		result = true;
+	}
+	return result;
+}
+
 chratos::bootstrap_initiator::bootstrap_initiator (chratos::node & node_a) :
 node (node_a),
 stopped (false),
@@ -1136,6 +1564,25 @@ void chratos::bootstrap_initiator::bootstrap ()
 	}
 }
 
+void chratos::bootstrap_initiator::bootstrap_lazy (chratos::block_hash const & hash_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	if (!stopped)
+	{
+		if (attempt == nullptr)
+		{
+			node.stats.inc (chratos::stat::type::bootstrap, chratos::stat::detail::initiate_lazy, chratos::stat::dir::out);
+			attempt = std::make_shared<chratos::bootstrap_attempt> (node.shared (), true);
+			condition.notify_all ();
+		}
+		// A running full bootstrap will reach this block with its frontier scan
+		if (attempt->lazy_mode)
+		{
+			attempt->lazy_start (hash_a);
+		}
+	}
+}
+
 void chratos::bootstrap_initiator::bootstrap (chratos::endpoint const & endpoint_a, bool add_to_peers)
 {
 	if (add_to_peers)
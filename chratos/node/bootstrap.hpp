@@ -11,6 +11,7 @@
 #include <unordered_set>
 
 #include <boost/log/sources/logger.hpp>
+#include <boost/optional.hpp>
 #include <boost/thread/thread.hpp>
 
 namespace chratos
@@ -34,14 +35,34 @@ public:
 	void start (std::chrono::steady_clock::time_point = std::chrono::steady_clock::now () + std::chrono::seconds (5));
 	void stop ();
 	void close ();
+	/** Closes the socket if the operation in flight has passed its deadline */
+	void check_deadline (std::chrono::steady_clock::time_point const &);
 	chratos::tcp_endpoint remote_endpoint ();
 	boost::asio::ip::tcp::socket socket_m;
 
 private:
-	std::atomic<unsigned> ticket;
+	// Time since the steady clock epoch the current operation must finish by, 0 when no operation is in flight
+	std::atomic<std::chrono::steady_clock::rep> deadline;
+	std::atomic<bool> tracked;
 	std::shared_ptr<chratos::node> node;
 };
 
+/**
+ * Bootstrap sockets checked against their deadlines by one periodic sweep.
+ * Arming a deadline is a store to the socket, sockets are registered here once on their first operation
+ */
+class socket_sweeper
+{
+public:
+	void add (std::shared_ptr<chratos::socket>);
+	/** Closes expired sockets and forgets destroyed ones */
+	void sweep (std::chrono::steady_clock::time_point const &);
+	size_t size ();
+	std::mutex mutex;
+	std::vector<std::weak_ptr<chratos::socket>> sockets;
+	static std::chrono::milliseconds constexpr interval = chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? std::chrono::milliseconds (50) : std::chrono::milliseconds (1000);
+};
+
 /**
  * The length of every message header, parsed by chratos::message::read_header ()
  * The 2 here represents the size of a std::bitset<16>, which is 2 chars long normally
@@ -58,20 +79,27 @@ public:
 	chratos::block_hash head;
 	chratos::block_hash end;
 	unsigned attempts;
+	// Blocks received for this pull over previous attempts, a lower bound on the chain length
+	uint64_t processed;
+	// Requeued pulls back off before being retried and avoid the peer that last failed them
+	std::chrono::steady_clock::time_point retry_after;
+	chratos::tcp_endpoint failed_peer;
 };
 class frontier_req_client;
 class bulk_push_client;
 class bootstrap_attempt : public std::enable_shared_from_this<bootstrap_attempt>
 {
 public:
-	bootstrap_attempt (std::shared_ptr<chratos::node> node_a);
+	bootstrap_attempt (std::shared_ptr<chratos::node> node_a, bool = false);
 	~bootstrap_attempt ();
 	void run ();
 	std::shared_ptr<chratos::bootstrap_client> connection (std::unique_lock<std::mutex> &);
 	bool consume_future (std::future<bool> &);
 	void populate_connections ();
-	bool request_frontier (std::unique_lock<std::mutex> &);
+	void request_frontier (std::unique_lock<std::mutex> &);
+	void frontier_finished (chratos::account const &, chratos::account const &, bool);
 	void request_pull (std::unique_lock<std::mutex> &);
+	std::shared_ptr<chratos::bootstrap_client> pull_connection (chratos::pull_info const &);
 	void request_push (std::unique_lock<std::mutex> &);
 	void add_connection (chratos::endpoint const &);
 	void pool_connection (std::shared_ptr<chratos::bootstrap_client>);
@@ -79,13 +107,23 @@ public:
 	void requeue_pull (chratos::pull_info const &);
 	void add_pull (chratos::pull_info const &);
 	bool still_pulling ();
+	bool still_comparing ();
 	unsigned target_connections (size_t pulls_remaining);
 	bool should_log ();
 	void add_bulk_push_target (chratos::block_hash const &, chratos::block_hash const &);
+	bool checkpoint_resume ();
+	void checkpoint_put (chratos::pull_info const &);
+	void checkpoint_del (chratos::block_hash const &);
+	void checkpoint_flush ();
+	void lazy_start (chratos::block_hash const &);
+	bool lazy_process_block (std::shared_ptr<chratos::block>);
 	std::chrono::steady_clock::time_point next_log;
 	std::deque<std::weak_ptr<chratos::bootstrap_client>> clients;
 	std::weak_ptr<chratos::bootstrap_client> connection_frontier_request;
-	std::weak_ptr<chratos::frontier_req_client> frontiers;
+	// Account ranges [first, second) still to be compared with a peer's frontiers, a zero end is unbounded
+	std::deque<std::pair<chratos::account, chratos::account>> frontier_ranges;
+	unsigned frontier_ranges_active;
+	unsigned frontier_ranges_max;
 	std::weak_ptr<chratos::bulk_push_client> push;
 	std::deque<chratos::pull_info> pulls;
 	std::deque<std::shared_ptr<chratos::bootstrap_client>> idle;
@@ -98,27 +136,46 @@ public:
 	bool stopped;
 	std::mutex mutex;
 	std::condition_variable condition;
+	// Lazy attempts skip the frontier scan, pulling chains backward from block hashes and following their dependencies
+	bool lazy_mode;
+	std::unordered_set<chratos::block_hash> lazy_keys;
+	// State blocks whose previous hasn't arrived yet, so whether their link is a source is unknown. Keyed by previous, holds link and balance
+	std::unordered_map<chratos::block_hash, std::pair<chratos::block_hash, chratos::uint128_t>> lazy_state_unknown;
+	std::mutex lazy_mutex;
+	static size_t constexpr lazy_max_keys = 64 * 1024;
+	// Changes to the persisted pull set not yet written by the bootstrap thread, applied in order. A null checkpoint is a delete
+	std::vector<std::pair<chratos::block_hash, boost::optional<chratos::pull_checkpoint>>> checkpoint_changes;
+	// Serializes writers of the persisted pull set so batches land in order
+	std::mutex checkpoint_mutex;
+
+private:
+	void lazy_add (chratos::transaction const &, chratos::block_hash const &);
 };
 class frontier_req_client : public std::enable_shared_from_this<chratos::frontier_req_client>
 {
 public:
-	frontier_req_client (std::shared_ptr<chratos::bootstrap_client>);
+	frontier_req_client (std::shared_ptr<chratos::bootstrap_client>, chratos::account const &, chratos::account const &);
 	~frontier_req_client ();
 	void run ();
 	void receive_frontier ();
 	void received_frontier (boost::system::error_code const &, size_t);
 	void request_account (chratos::account const &, chratos::block_hash const &);
 	void unsynced (chratos::block_hash const &, chratos::block_hash const &);
-	void next (chratos::transaction const &);
+	void next (chratos::store_iterator<chratos::account, chratos::account_info> &);
 	void insert_pull (chratos::pull_info const &);
 	std::shared_ptr<chratos::bootstrap_client> connection;
+	// First account not yet compared, advances as frontiers arrive so an interrupted range resumes from here
+	chratos::account start;
+	// Exclusive end of the range, zero runs to the end of the account space
+	chratos::account end;
+	// Next local account of the range not yet compared, zero once they're exhausted
 	chratos::account current;
 	chratos::account_info info;
 	unsigned count;
 	chratos::account landing;
 	chratos::account faucet;
 	std::chrono::steady_clock::time_point start_time;
-	std::promise<bool> promise;
+	bool complete;
 	/** A very rough estimate of the cost of `bulk_push`ing missing blocks */
 	uint64_t bulk_push_cost;
 };
@@ -146,6 +203,7 @@ public:
 	void stop (bool force);
 	double block_rate () const;
 	double elapsed_seconds () const;
+	void update_throughput ();
 	std::shared_ptr<chratos::node> node;
 	std::shared_ptr<chratos::bootstrap_attempt> attempt;
 	std::shared_ptr<chratos::socket> socket;
@@ -153,6 +211,11 @@ public:
 	chratos::tcp_endpoint endpoint;
 	std::chrono::steady_clock::time_point start_time;
 	std::atomic<uint64_t> block_count;
+	// Moving average of blocks per second while pulling, sampled under the attempt mutex
+	std::atomic<double> throughput;
+	uint64_t throughput_blocks;
+	std::chrono::steady_clock::time_point throughput_sample;
+	std::atomic<bool> pulling;
 	std::atomic<bool> pending_stop;
 	std::atomic<bool> hard_stop;
 };
@@ -176,6 +239,7 @@ public:
 	~bootstrap_initiator ();
 	void bootstrap (chratos::endpoint const &, bool add_to_peers = true);
 	void bootstrap ();
+	void bootstrap_lazy (chratos::block_hash const &);
 	void run_bootstrap ();
 	void notify_listeners (bool);
 	void add_observer (std::function<void(bool)> const &);
@@ -2,6 +2,7 @@
 #include <chratos/node/cli.hpp>
 #include <chratos/node/common.hpp>
 #include <chratos/node/node.hpp>
+#include <chratos/node/snapshot.hpp>
 
 std::string chratos::error_cli_messages::message (int ev) const
 {
@@ -29,6 +30,8 @@ void chratos::add_node_options (boost::program_options::options_description & de
 	("account_key", "Get the public key for <account>")
 	("vacuum", "Compact database. If data_path is missing, the database in data directory is compacted.")
 	("snapshot", "Compact database and create snapshot, functions similar to vacuum but does not replace the existing database")
+	("snapshot_export", "Export the ledger to <file> as a portable, checksummed ledger snapshot")
+	("snapshot_import", "Create the ledger in the data directory from the ledger snapshot <file>, verifying its checksum and block signatures and rebuilding balances owed and voting weights from the blocks. Only import snapshots from a trusted source, a valid snapshot may still omit or include unconfirmed blocks")
 	("unchecked_clear", "Clear unchecked blocks")
 	("data_path", boost::program_options::value<std::string> (), "Use the supplied path as the data directory")
 	("delete_node_id", "Delete the node ID in the database")
@@ -241,6 +244,74 @@ std::error_code chratos::handle_node_options (boost::program_options::variables_
 			std::cerr << "Snapshot Failed (unknown reason)" << std::endl;
 		}
 	}
+	else if (vm.count ("snapshot_export"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			boost::filesystem::path snapshot_path (vm["file"].as<std::string> ());
+			std::cout << "Exporting ledger snapshot to " << snapshot_path << std::endl;
+			std::cout << "This may take a while..." << std::endl;
+			inactive_node node (data_path);
+			auto error (chratos::snapshot_export (node.node->store, snapshot_path));
+			if (!error)
+			{
+				std::cout << "Snapshot export completed" << std::endl;
+			}
+			else
+			{
+				std::cerr << "Snapshot export failed: " << error.message () << std::endl;
+				ec = chratos::error_cli::generic;
+			}
+		}
+		else
+		{
+			std::cerr << "snapshot_export command requires one <file> option\n";
+			ec = chratos::error_cli::invalid_arguments;
+		}
+	}
+	else if (vm.count ("snapshot_import"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			boost::filesystem::path snapshot_path (vm["file"].as<std::string> ());
+			auto ledger_path (data_path / "data.ldb");
+			if (!boost::filesystem::exists (ledger_path))
+			{
+				std::cout << "Importing ledger snapshot " << snapshot_path << " in to " << ledger_path << std::endl;
+				std::cout << "This may take a while..." << std::endl;
+				boost::filesystem::create_directories (data_path);
+				std::error_code error;
+				{
+					auto store_error (false);
+					chratos::mdb_store store (store_error, ledger_path);
+					chratos::node_config config;
+					error = store_error ? chratos::error_snapshot::generic : chratos::snapshot_import (store, snapshot_path, config.epoch_block_link, config.epoch_block_signer, std::max (1U, boost::thread::hardware_concurrency ()));
+				}
+				if (!error)
+				{
+					std::cout << "Snapshot import completed" << std::endl;
+				}
+				else
+				{
+					// Don't leave a partial ledger behind for the node to start on
+					boost::filesystem::remove (ledger_path);
+					boost::filesystem::remove (data_path / "data.ldb-lock");
+					std::cerr << "Snapshot import failed: " << error.message () << std::endl;
+					ec = chratos::error_cli::generic;
+				}
+			}
+			else
+			{
+				std::cerr << "A ledger already exists at " << ledger_path << ", snapshots can only be imported in to a new data directory\n";
+				ec = chratos::error_cli::invalid_arguments;
+			}
+		}
+		else
+		{
+			std::cerr << "snapshot_import command requires one <file> option\n";
+			ec = chratos::error_cli::invalid_arguments;
+		}
+	}
 	else if (vm.count ("unchecked_clear"))
 	{
 		boost::filesystem::path data_path = vm.count ("data_path") ? boost::filesystem::path (vm["data_path"].as<std::string> ()) : chratos::working_path ();
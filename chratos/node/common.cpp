@@ -2,6 +2,7 @@
 #include <chratos/node/common.hpp>
 
 #include <chratos/lib/work.hpp>
+#include <chratos/node/stats.hpp>
 #include <chratos/node/wallet.hpp>
 
 std::array<uint8_t, 2> constexpr chratos::message_header::magic_number;
@@ -139,6 +140,14 @@ std::string chratos::message_parser::status_string ()
 		{
 			return "invalid_network";
 		}
+		case chratos::message_parser::parse_status::duplicate_publish_message:
+		{
+			return "duplicate_publish_message";
+		}
+		case chratos::message_parser::parse_status::duplicate_confirm_ack_message:
+		{
+			return "duplicate_confirm_ack_message";
+		}
 	}
 
 	assert (false);
@@ -146,9 +155,51 @@ std::string chratos::message_parser::status_string ()
 	return "[unknown parse_status]";
 }
 
-chratos::message_parser::message_parser (chratos::message_visitor & visitor_a, chratos::work_pool & pool_a) :
+namespace
+{
+// The magic number and version fields differ between relaying peers, digests start at the message type
+size_t constexpr digest_offset = 5;
+}
+
+chratos::message_filter::message_filter (chratos::stat & stats_a, size_t size_a) :
+stats (stats_a),
+digests (size_a, 0)
+{
+	assert (size_a > 0);
+	chratos::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (&seed), sizeof (seed));
+}
+
+bool chratos::message_filter::check (uint8_t const * buffer_a, size_t size_a)
+{
+	auto digest_l (digest (buffer_a, size_a));
+	bool result;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		result = digests[digest_l % digests.size ()] == digest_l;
+	}
+	stats.inc (chratos::stat::type::filter, result ? chratos::stat::detail::hit : chratos::stat::detail::miss);
+	return result;
+}
+
+void chratos::message_filter::insert (uint8_t const * buffer_a, size_t size_a)
+{
+	auto digest_l (digest (buffer_a, size_a));
+	std::lock_guard<std::mutex> lock (mutex);
+	digests[digest_l % digests.size ()] = digest_l;
+}
+
+uint64_t chratos::message_filter::digest (uint8_t const * buffer_a, size_t size_a) const
+{
+	assert (size_a >= digest_offset);
+	auto result (XXH64 (buffer_a + digest_offset, size_a - digest_offset, seed));
+	// Zero marks an empty slot
+	return result != 0 ? result : 1;
+}
+
+chratos::message_parser::message_parser (chratos::message_visitor & visitor_a, chratos::work_pool & pool_a, chratos::message_filter * filter_a) :
 visitor (visitor_a),
 pool (pool_a),
+filter (filter_a),
 status (parse_status::success)
 {
 }
@@ -187,7 +238,19 @@ void chratos::message_parser::deserialize_buffer (uint8_t const * buffer_a, size
 					}
 					case chratos::message_type::publish:
 					{
-						deserialize_publish (stream, header);
+						if (filter == nullptr || !filter->check (buffer_a, size_a))
+						{
+							deserialize_publish (stream, header);
+							// Only messages that passed validation and reached the visitor suppress later copies
+							if (filter != nullptr && status == parse_status::success)
+							{
+								filter->insert (buffer_a, size_a);
+							}
+						}
+						else
+						{
+							status = parse_status::duplicate_publish_message;
+						}
 						break;
 					}
 					case chratos::message_type::confirm_req:
@@ -197,7 +260,19 @@ void chratos::message_parser::deserialize_buffer (uint8_t const * buffer_a, size
 					}
 					case chratos::message_type::confirm_ack:
 					{
-						deserialize_confirm_ack (stream, header);
+						if (filter == nullptr || !filter->check (buffer_a, size_a))
+						{
+							deserialize_confirm_ack (stream, header);
+							// Only messages that passed validation and reached the visitor suppress later copies
+							if (filter != nullptr && status == parse_status::success)
+							{
+								filter->insert (buffer_a, size_a);
+							}
+						}
+						else
+						{
+							status = parse_status::duplicate_confirm_ack_message;
+						}
 						break;
 					}
 					case chratos::message_type::node_id_handshake:
@@ -6,6 +6,7 @@
 #include <boost/asio.hpp>
 
 #include <bitset>
+#include <mutex>
 
 #include <xxhash/xxhash.h>
 
@@ -195,6 +196,28 @@ public:
 	virtual void visit (chratos::message_visitor &) const = 0;
 	chratos::message_header header;
 };
+class stat;
+/**
+ * Direct mapped table of digests of recently received publish and confirm_ack payloads.
+ * Peers relay the same blocks and votes many times, matching the raw bytes lets rebroadcasts be dropped before they're deserialized and validated.
+ */
+class message_filter
+{
+public:
+	message_filter (chratos::stat &, size_t);
+	/** Returns true if an identical message was accepted recently */
+	bool check (uint8_t const *, size_t);
+	/** Remembers a message once it has been validated and handed off, so identical copies are dropped */
+	void insert (uint8_t const *, size_t);
+
+private:
+	uint64_t digest (uint8_t const *, size_t) const;
+	chratos::stat & stats;
+	// Random per node so colliding payloads can't be crafted to suppress messages network wide
+	uint64_t seed;
+	std::mutex mutex;
+	std::vector<uint64_t> digests;
+};
 class work_pool;
 class message_parser
 {
@@ -212,9 +235,11 @@ public:
 		invalid_node_id_handshake_message,
 		outdated_version,
 		invalid_magic,
-		invalid_network
+		invalid_network,
+		duplicate_publish_message,
+		duplicate_confirm_ack_message
 	};
-	message_parser (chratos::message_visitor &, chratos::work_pool &);
+	message_parser (chratos::message_visitor &, chratos::work_pool &, chratos::message_filter * = nullptr);
 	void deserialize_buffer (uint8_t const *, size_t);
 	void deserialize_keepalive (chratos::stream &, chratos::message_header const &);
 	void deserialize_publish (chratos::stream &, chratos::message_header const &);
@@ -224,6 +249,7 @@ public:
 	bool at_end (chratos::stream &);
 	chratos::message_visitor & visitor;
 	chratos::work_pool & pool;
+	chratos::message_filter * filter;
 	parse_status status;
 	std::string status_string ();
 	static const size_t max_safe_udp_message_size;
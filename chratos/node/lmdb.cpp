@@ -6,8 +6,11 @@
 
 #include <boost/polymorphic_cast.hpp>
 
+#include <algorithm>
 #include <queue>
 
+size_t constexpr chratos::mdb_store::unchecked_hot_max;
+
 chratos::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs)
 {
 	boost::system::error_code error_mkdir, error_chmod;
@@ -113,6 +116,26 @@ mdb_val (sizeof (val_a), const_cast<chratos::pending_key *> (&val_a))
 {
 }
 
+chratos::mdb_val::mdb_val (chratos::unchecked_key const & val_a) :
+mdb_val (sizeof (val_a), const_cast<chratos::unchecked_key *> (&val_a))
+{
+}
+
+chratos::mdb_val::mdb_val (chratos::unchecked_info const & val_a) :
+buffer (std::make_shared<std::vector<uint8_t>> ())
+{
+	{
+		chratos::vectorstream stream (*buffer);
+		val_a.serialize (stream);
+	}
+	value = { buffer->size (), const_cast<uint8_t *> (buffer->data ()) };
+}
+
+chratos::mdb_val::mdb_val (chratos::pull_checkpoint const & val_a) :
+mdb_val (sizeof (val_a), const_cast<chratos::pull_checkpoint *> (&val_a))
+{
+}
+
 chratos::mdb_val::mdb_val (chratos::block_info const & val_a) :
 mdb_val (sizeof (val_a), const_cast<chratos::block_info *> (&val_a))
 {
@@ -182,6 +205,33 @@ chratos::mdb_val::operator chratos::pending_key () const
 	return result;
 }
 
+chratos::mdb_val::operator chratos::unchecked_key () const
+{
+	chratos::unchecked_key result;
+	assert (value.mv_size == sizeof (result));
+	static_assert (sizeof (chratos::unchecked_key::previous) + sizeof (chratos::unchecked_key::hash) == sizeof (result), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	return result;
+}
+
+chratos::mdb_val::operator chratos::unchecked_info () const
+{
+	chratos::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+	chratos::unchecked_info result;
+	auto error (result.deserialize (stream));
+	assert (!error);
+	return result;
+}
+
+chratos::mdb_val::operator chratos::pull_checkpoint () const
+{
+	chratos::pull_checkpoint result;
+	assert (value.mv_size == sizeof (result));
+	static_assert (sizeof (chratos::pull_checkpoint::account) + sizeof (chratos::pull_checkpoint::end) == sizeof (result), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	return result;
+}
+
 chratos::mdb_val::operator chratos::uint128_union () const
 {
 	chratos::uint128_union result;
@@ -643,7 +693,9 @@ chratos::mdb_val chratos::wallet_value::val () const
 }
 
 template class chratos::mdb_iterator<chratos::pending_key, chratos::pending_info>;
+template class chratos::mdb_iterator<chratos::unchecked_key, chratos::unchecked_info>;
 template class chratos::mdb_iterator<chratos::uint256_union, chratos::block_info>;
+template class chratos::mdb_iterator<chratos::uint256_union, chratos::pull_checkpoint>;
 template class chratos::mdb_iterator<chratos::uint256_union, chratos::uint128_union>;
 template class chratos::mdb_iterator<chratos::uint256_union, chratos::uint256_union>;
 template class chratos::mdb_iterator<chratos::uint256_union, std::shared_ptr<chratos::block>>;
@@ -681,21 +733,21 @@ chratos::store_iterator<chratos::account, chratos::uint128_union> chratos::mdb_s
 	return result;
 }
 
-chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> chratos::mdb_store::unchecked_begin (chratos::transaction const & transaction_a)
+chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> chratos::mdb_store::unchecked_begin (chratos::transaction const & transaction_a)
 {
-	chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> result (std::make_unique<chratos::mdb_iterator<chratos::account, std::shared_ptr<chratos::block>>> (transaction_a, unchecked));
+	chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> result (std::make_unique<chratos::mdb_iterator<chratos::unchecked_key, chratos::unchecked_info>> (transaction_a, unchecked));
 	return result;
 }
 
-chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> chratos::mdb_store::unchecked_begin (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a)
+chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> chratos::mdb_store::unchecked_begin (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a)
 {
-	chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> result (std::make_unique<chratos::mdb_iterator<chratos::block_hash, std::shared_ptr<chratos::block>>> (transaction_a, unchecked, chratos::mdb_val (hash_a)));
+	chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> result (std::make_unique<chratos::mdb_iterator<chratos::unchecked_key, chratos::unchecked_info>> (transaction_a, unchecked, chratos::mdb_val (chratos::unchecked_key (hash_a, 0))));
 	return result;
 }
 
-chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> chratos::mdb_store::unchecked_end ()
+chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> chratos::mdb_store::unchecked_end ()
 {
-	chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> result (nullptr);
+	chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> result (nullptr);
 	return result;
 }
 
@@ -724,6 +776,7 @@ pending_v1 (0),
 blocks_info (0),
 representation (0),
 unchecked (0),
+bootstrap_pulls (0),
 checksum (0),
 vote (0),
 meta (0)
@@ -743,7 +796,8 @@ meta (0)
 		error_a |= mdb_dbi_open (env.tx (transaction), "pending_v1", MDB_CREATE, &pending_v1) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "blocks_info", MDB_CREATE, &blocks_info) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "representation", MDB_CREATE, &representation) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "unchecked", MDB_CREATE | MDB_DUPSORT, &unchecked) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "unchecked", MDB_CREATE, &unchecked) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "bootstrap_pulls", MDB_CREATE, &bootstrap_pulls) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "checksum", MDB_CREATE, &checksum) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "vote", MDB_CREATE, &vote) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "meta", MDB_CREATE, &meta) != 0;
@@ -859,6 +913,8 @@ void chratos::mdb_store::do_upgrades (chratos::transaction const & transaction_a
 		case 10:
 			upgrade_v10_to_v11 (transaction_a);
 		case 11:
+			upgrade_v11_to_v12 (transaction_a);
+		case 12:
 			break;
 		default:
 			assert (false);
@@ -1060,6 +1116,14 @@ void chratos::mdb_store::upgrade_v10_to_v11 (chratos::transaction const & transa
 	mdb_drop (env.tx (transaction_a), unsynced, 1);
 }
 
+void chratos::mdb_store::upgrade_v11_to_v12 (chratos::transaction const & transaction_a)
+{
+	version_put (transaction_a, 12);
+	// Unchecked entries moved from a dupsort table keyed by dependency to a plain table keyed by (dependency, hash), the cache is rebuilt by bootstrapping
+	mdb_drop (env.tx (transaction_a), unchecked, 1);
+	mdb_dbi_open (env.tx (transaction_a), "unchecked", MDB_CREATE, &unchecked);
+}
+
 void chratos::mdb_store::clear (MDB_dbi db_a)
 {
 	auto transaction (tx_begin_write ());
@@ -1151,6 +1215,18 @@ void chratos::mdb_store::block_put (chratos::transaction const & transaction_a,
 	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
 }
 
+void chratos::mdb_store::block_append (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a, chratos::block const & block_a, chratos::block_hash const & successor_a, chratos::epoch epoch_a)
+{
+	std::vector<uint8_t> vector;
+	{
+		chratos::vectorstream stream (vector);
+		block_a.serialize (stream);
+		chratos::write (stream, successor_a.bytes);
+	}
+	auto status (mdb_put (env.tx (transaction_a), block_database (block_a.type (), epoch_a), chratos::mdb_val (hash_a), chratos::mdb_val (vector.size (), vector.data ()), MDB_APPEND));
+	release_assert (status == 0);
+}
+
 MDB_val chratos::mdb_store::block_raw_get (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a, chratos::block_type & type_a)
 {
 	chratos::mdb_val result;
@@ -1675,27 +1751,47 @@ void chratos::mdb_store::unchecked_clear (chratos::transaction const & transacti
 {
 	auto status (mdb_drop (env.tx (transaction_a), unchecked, 0));
 	release_assert (status == 0);
+	std::lock_guard<std::mutex> lock (unchecked_hot_mutex);
+	unchecked_hot.clear ();
+	unchecked_hot_order.clear ();
 }
 
-void chratos::mdb_store::unchecked_put (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a, std::shared_ptr<chratos::block> const & block_a)
+bool chratos::mdb_store::unchecked_put (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a, std::shared_ptr<chratos::block> const & block_a)
 {
-	// Checking if same unchecked block is already in database
-	bool exists (false);
-	auto block_hash (block_a->hash ());
-	auto cached (unchecked_get (transaction_a, hash_a));
-	for (auto i (cached.begin ()), n (cached.end ()); i != n && !exists; ++i)
+	chratos::unchecked_key key (hash_a, block_a->hash ());
+	bool exists;
+	{
+		std::lock_guard<std::mutex> lock (unchecked_hot_mutex);
+		exists = unchecked_hot.find (key) != unchecked_hot.end ();
+	}
+	if (!exists)
 	{
-		if ((*i)->hash () == block_hash)
+		chratos::mdb_val junk;
+		auto status1 (mdb_get (env.tx (transaction_a), unchecked, chratos::mdb_val (key), junk));
+		release_assert (status1 == 0 || status1 == MDB_NOTFOUND);
+		exists = status1 == 0;
+		if (!exists)
 		{
-			exists = true;
+			chratos::unchecked_info info (block_a, chratos::seconds_since_epoch ());
+			auto status2 (mdb_put (env.tx (transaction_a), unchecked, chratos::mdb_val (key), chratos::mdb_val (info), 0));
+			release_assert (status2 == 0);
 		}
+		unchecked_hot_add (key);
 	}
-	// Inserting block if it wasn't found in database
-	if (!exists)
+	return exists;
+}
+
+void chratos::mdb_store::unchecked_hot_add (chratos::unchecked_key const & key_a)
+{
+	std::lock_guard<std::mutex> lock (unchecked_hot_mutex);
+	if (unchecked_hot.insert (key_a).second)
 	{
-		mdb_val block (block_a);
-		auto status (mdb_put (env.tx (transaction_a), unchecked, chratos::mdb_val (hash_a), block, 0));
-		release_assert (status == 0);
+		unchecked_hot_order.push_back (key_a);
+		while (unchecked_hot_order.size () > unchecked_hot_max)
+		{
+			unchecked_hot.erase (unchecked_hot_order.front ());
+			unchecked_hot_order.pop_front ();
+		}
 	}
 }
 
@@ -1717,19 +1813,21 @@ std::shared_ptr<chratos::vote> chratos::mdb_store::vote_get (chratos::transactio
 std::vector<std::shared_ptr<chratos::block>> chratos::mdb_store::unchecked_get (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a)
 {
 	std::vector<std::shared_ptr<chratos::block>> result;
-	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && chratos::block_hash (i->first) == hash_a; ++i)
+	for (auto i (unchecked_begin (transaction_a, hash_a)), n (unchecked_end ()); i != n && i->first.key () == hash_a; ++i)
 	{
-		std::shared_ptr<chratos::block> block (i->second);
-		result.push_back (block);
+		result.push_back (i->second.block);
 	}
 	return result;
 }
 
 void chratos::mdb_store::unchecked_del (chratos::transaction const & transaction_a, chratos::block_hash const & hash_a, std::shared_ptr<chratos::block> block_a)
 {
-	chratos::mdb_val block (block_a);
-	auto status (mdb_del (env.tx (transaction_a), unchecked, chratos::mdb_val (hash_a), block));
+	chratos::unchecked_key key (hash_a, block_a->hash ());
+	auto status (mdb_del (env.tx (transaction_a), unchecked, chratos::mdb_val (key), nullptr));
 	release_assert (status == 0 || status == MDB_NOTFOUND);
+	std::lock_guard<std::mutex> lock (unchecked_hot_mutex);
+	// The stale entry in unchecked_hot_order is dropped when it reaches the front
+	unchecked_hot.erase (key);
 }
 
 size_t chratos::mdb_store::unchecked_count (chratos::transaction const & transaction_a)
@@ -1741,6 +1839,99 @@ size_t chratos::mdb_store::unchecked_count (chratos::transaction const & transac
 	return result;
 }
 
+size_t chratos::mdb_store::unchecked_trim (chratos::transaction const & transaction_a, size_t max_a)
+{
+	size_t result (0);
+	auto count (unchecked_count (transaction_a));
+	if (count > max_a)
+	{
+		auto excess (count - max_a);
+		// Arrival time is the leading field of each value so it's read without deserializing blocks
+		std::vector<uint64_t> arrivals;
+		arrivals.reserve (count);
+		for (chratos::mdb_iterator<chratos::unchecked_key, chratos::unchecked_info> i (transaction_a, unchecked), n (nullptr); i != n; ++i)
+		{
+			chratos::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+			uint64_t modified (0);
+			auto error (chratos::read (stream, modified));
+			assert (!error);
+			arrivals.push_back (modified);
+		}
+		std::nth_element (arrivals.begin (), arrivals.begin () + (excess - 1), arrivals.end ());
+		auto cutoff (arrivals[excess - 1]);
+		size_t older (std::count_if (arrivals.begin (), arrivals.end (), [cutoff](uint64_t arrival_a) { return arrival_a < cutoff; }));
+		// Entries arriving in the cutoff second are only partially evicted
+		auto at_cutoff (excess - older);
+		std::vector<chratos::unchecked_key> evict;
+		evict.reserve (excess);
+		for (chratos::mdb_iterator<chratos::unchecked_key, chratos::unchecked_info> i (transaction_a, unchecked), n (nullptr); i != n && evict.size () < excess; ++i)
+		{
+			chratos::bufferstream stream (reinterpret_cast<uint8_t const *> (i->second.data ()), i->second.size ());
+			uint64_t modified (0);
+			auto error (chratos::read (stream, modified));
+			assert (!error);
+			if (modified < cutoff || (modified == cutoff && at_cutoff > 0))
+			{
+				if (modified == cutoff)
+				{
+					--at_cutoff;
+				}
+				evict.push_back (chratos::unchecked_key (i->first));
+			}
+		}
+		for (auto & key : evict)
+		{
+			auto status (mdb_del (env.tx (transaction_a), unchecked, chratos::mdb_val (key), nullptr));
+			release_assert (status == 0);
+		}
+		std::lock_guard<std::mutex> lock (unchecked_hot_mutex);
+		for (auto & key : evict)
+		{
+			unchecked_hot.erase (key);
+		}
+		result = evict.size ();
+	}
+	return result;
+}
+
+void chratos::mdb_store::bootstrap_pull_put (chratos::transaction const & transaction_a, chratos::block_hash const & head_a, chratos::pull_checkpoint const & checkpoint_a)
+{
+	auto status (mdb_put (env.tx (transaction_a), bootstrap_pulls, chratos::mdb_val (head_a), chratos::mdb_val (checkpoint_a), 0));
+	release_assert (status == 0);
+}
+
+void chratos::mdb_store::bootstrap_pull_del (chratos::transaction const & transaction_a, chratos::block_hash const & head_a)
+{
+	auto status (mdb_del (env.tx (transaction_a), bootstrap_pulls, chratos::mdb_val (head_a), nullptr));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+}
+
+void chratos::mdb_store::bootstrap_pull_clear (chratos::transaction const & transaction_a)
+{
+	auto status (mdb_drop (env.tx (transaction_a), bootstrap_pulls, 0));
+	release_assert (status == 0);
+}
+
+size_t chratos::mdb_store::bootstrap_pull_count (chratos::transaction const & transaction_a)
+{
+	MDB_stat bootstrap_pulls_stats;
+	auto status (mdb_stat (env.tx (transaction_a), bootstrap_pulls, &bootstrap_pulls_stats));
+	release_assert (status == 0);
+	return bootstrap_pulls_stats.ms_entries;
+}
+
+chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> chratos::mdb_store::bootstrap_pull_begin (chratos::transaction const & transaction_a)
+{
+	chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> result (std::make_unique<chratos::mdb_iterator<chratos::block_hash, chratos::pull_checkpoint>> (transaction_a, bootstrap_pulls));
+	return result;
+}
+
+chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> chratos::mdb_store::bootstrap_pull_end ()
+{
+	chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> result (nullptr);
+	return result;
+}
+
 void chratos::mdb_store::checksum_put (chratos::transaction const & transaction_a, uint64_t prefix, uint8_t mask, chratos::uint256_union const & hash_a)
 {
 	assert ((prefix & 0xff) == 0);
@@ -8,6 +8,9 @@
 #include <chratos/secure/blockstore.hpp>
 #include <chratos/secure/common.hpp>
 
+#include <deque>
+#include <unordered_set>
+
 namespace chratos
 {
 class mdb_env;
@@ -54,6 +57,9 @@ public:
 	mdb_val (MDB_val const &, chratos::epoch = chratos::epoch::unspecified);
 	mdb_val (chratos::pending_info const &);
 	mdb_val (chratos::pending_key const &);
+	mdb_val (chratos::unchecked_key const &);
+	mdb_val (chratos::unchecked_info const &);
+	mdb_val (chratos::pull_checkpoint const &);
 	mdb_val (size_t, void *);
 	mdb_val (chratos::uint128_union const &);
 	mdb_val (chratos::uint256_union const &);
@@ -66,6 +72,9 @@ public:
 	explicit operator chratos::block_info () const;
 	explicit operator chratos::pending_info () const;
 	explicit operator chratos::pending_key () const;
+	explicit operator chratos::unchecked_key () const;
+	explicit operator chratos::unchecked_info () const;
+	explicit operator chratos::pull_checkpoint () const;
 	explicit operator chratos::uint128_union () const;
 	explicit operator chratos::uint256_union () const;
 	explicit operator std::array<char, 64> () const;
@@ -153,6 +162,8 @@ public:
 
 	void initialize (chratos::transaction const &, chratos::genesis const &) override;
 	void block_put (chratos::transaction const &, chratos::block_hash const &, chratos::block const &, chratos::block_hash const & = chratos::block_hash (0), chratos::epoch version = chratos::epoch::epoch_0) override;
+	// Bulk load variant of block_put for a store being filled in hash order, the successor is written as given
+	void block_append (chratos::transaction const &, chratos::block_hash const &, chratos::block const &, chratos::block_hash const &, chratos::epoch);
 	chratos::block_hash block_successor (chratos::transaction const &, chratos::block_hash const &) override;
 	void block_successor_clear (chratos::transaction const &, chratos::block_hash const &) override;
 	std::unique_ptr<chratos::block> block_get (chratos::transaction const &, chratos::block_hash const &) override;
@@ -215,13 +226,21 @@ public:
 	chratos::store_iterator<chratos::account, chratos::uint128_union> representation_end () override;
 
 	void unchecked_clear (chratos::transaction const &) override;
-	void unchecked_put (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block> const &) override;
+	bool unchecked_put (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block> const &) override;
 	std::vector<std::shared_ptr<chratos::block>> unchecked_get (chratos::transaction const &, chratos::block_hash const &) override;
 	void unchecked_del (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block>) override;
-	chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> unchecked_begin (chratos::transaction const &) override;
-	chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> unchecked_begin (chratos::transaction const &, chratos::block_hash const &) override;
-	chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> unchecked_end () override;
+	chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> unchecked_begin (chratos::transaction const &) override;
+	chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> unchecked_begin (chratos::transaction const &, chratos::block_hash const &) override;
+	chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> unchecked_end () override;
 	size_t unchecked_count (chratos::transaction const &) override;
+	size_t unchecked_trim (chratos::transaction const &, size_t) override;
+
+	void bootstrap_pull_put (chratos::transaction const &, chratos::block_hash const &, chratos::pull_checkpoint const &) override;
+	void bootstrap_pull_del (chratos::transaction const &, chratos::block_hash const &) override;
+	void bootstrap_pull_clear (chratos::transaction const &) override;
+	size_t bootstrap_pull_count (chratos::transaction const &) override;
+	chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> bootstrap_pull_begin (chratos::transaction const &) override;
+	chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> bootstrap_pull_end () override;
 
 	void checksum_put (chratos::transaction const &, uint64_t, uint8_t, chratos::checksum const &) override;
 	bool checksum_get (chratos::transaction const &, uint64_t, uint8_t, chratos::checksum &) override;
@@ -337,11 +356,18 @@ public:
 	MDB_dbi representation;
 
 	/**
-	 * Unchecked bootstrap blocks.
-	 * chratos::block_hash -> chratos::block
+	 * Unchecked bootstrap blocks keyed by the dependency they're waiting on and their own hash.
+	 * (chratos::block_hash, chratos::block_hash) -> uint64_t, chratos::block
 	 */
 	MDB_dbi unchecked;
 
+	/**
+	 * Outstanding pulls of the current bootstrap attempt, kept so a restarted node resumes instead of redoing the frontier scan.
+	 * A zero head marks that the frontier scan completed, without it the pulls are incomplete and discarded.
+	 * chratos::block_hash -> chratos::account, chratos::block_hash
+	 */
+	MDB_dbi bootstrap_pulls;
+
 	/**
 	 * Mapping of region to checksum.
 	 * (uint56_t, uint8_t) -> chratos::block_hash
@@ -367,6 +393,12 @@ private:
 	MDB_val block_raw_get (chratos::transaction const &, chratos::block_hash const &, chratos::block_type &);
 	void block_raw_put (chratos::transaction const &, MDB_dbi, chratos::block_hash const &, MDB_val);
 	void clear (MDB_dbi);
+	void unchecked_hot_add (chratos::unchecked_key const &);
+	// Recently inserted unchecked keys, lets repeated puts of a block skip the database lookup
+	std::mutex unchecked_hot_mutex;
+	std::unordered_set<chratos::unchecked_key> unchecked_hot;
+	std::deque<chratos::unchecked_key> unchecked_hot_order;
+	static size_t constexpr unchecked_hot_max = 64 * 1024;
 };
 class wallet_value
 {
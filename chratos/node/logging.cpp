@@ -1,9 +1,115 @@
+#include <boost/format.hpp>
 #include <boost/log/expressions.hpp>
+#include <boost/log/sinks/async_frontend.hpp>
+#include <boost/log/sinks/bounded_fifo_queue.hpp>
+#include <boost/log/sinks/text_file_backend.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/utility/setup/file.hpp>
+#include <boost/log/utility/setup/formatter_parser.hpp>
+#include <boost/make_shared.hpp>
 #include <chratos/node/logging.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+size_t constexpr chratos::logging::queue_max;
+std::chrono::milliseconds constexpr chratos::logging::flush_interval;
+
+namespace
+{
+std::atomic<uint64_t> log_dropped (0);
+
+/** Overflow strategy for the file sink queue, records that don't fit are discarded rather than blocking the logging thread */
+class log_drop_counter
+{
+public:
+	template <typename LockT>
+	static bool on_overflow (boost::log::record_view const &, LockT &)
+	{
+		++log_dropped;
+		return false;
+	}
+	static void on_queue_space_available ()
+	{
+	}
+	static void interrupt ()
+	{
+	}
+};
+
+using log_file_sink = boost::log::sinks::asynchronous_sink<boost::log::sinks::text_file_backend, boost::log::sinks::bounded_fifo_queue<chratos::logging::queue_max, log_drop_counter>>;
+
+/**
+ * Drains the file sink queue on its own thread.
+ * Records are written in batches every flush_interval and the file is flushed once per batch instead of once per record
+ */
+class log_writer
+{
+public:
+	log_writer (boost::shared_ptr<log_file_sink> sink_a, bool flush_a) :
+	sink (sink_a),
+	flush (flush_a),
+	stopped (false),
+	reported (0),
+	thread ([this]() { run (); })
+	{
+	}
+	~log_writer ()
+	{
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			stopped = true;
+		}
+		condition.notify_all ();
+		thread.join ();
+		write (true);
+	}
+	void run ()
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		while (!stopped)
+		{
+			lock.unlock ();
+			write (flush);
+			lock.lock ();
+			condition.wait_for (lock, chratos::logging::flush_interval);
+		}
+	}
+	void write (bool flush_a)
+	{
+		std::lock_guard<std::mutex> lock (write_mutex);
+		auto dropped_l (log_dropped.load ());
+		if (dropped_l != reported)
+		{
+			BOOST_LOG (log) << boost::str (boost::format ("Log queue full, dropped %1% records") % (dropped_l - reported));
+			reported = dropped_l;
+		}
+		if (flush_a)
+		{
+			sink->flush ();
+		}
+		else
+		{
+			sink->feed_records ();
+		}
+	}
+	boost::shared_ptr<log_file_sink> sink;
+	bool flush;
+	bool stopped;
+	uint64_t reported;
+	std::mutex mutex;
+	std::mutex write_mutex;
+	std::condition_variable condition;
+	boost::log::sources::logger_mt log;
+	std::thread thread;
+};
+
+std::unique_ptr<log_writer> writer;
+}
+
 chratos::logging::logging () :
 ledger_logging_value (false),
 ledger_duplicate_logging_value (false),
@@ -21,6 +127,7 @@ bulk_pull_logging_value (false),
 work_generation_time_value (true),
 log_to_cerr_value (false),
 flush (true),
+async (true),
 max_size (16 * 1024 * 1024),
 rotation_size (4 * 1024 * 1024)
 {
@@ -36,13 +143,41 @@ void chratos::logging::init (boost::filesystem::path const & application_path_a)
 		{
 			boost::log::add_console_log (std::cerr, boost::log::keywords::format = "[%TimeStamp%]: %Message%");
 		}
-		boost::log::add_file_log (boost::log::keywords::target = application_path_a / "log", boost::log::keywords::file_name = application_path_a / "log" / "log_%Y-%m-%d_%H-%M-%S.%N.log", boost::log::keywords::rotation_size = rotation_size, boost::log::keywords::auto_flush = flush, boost::log::keywords::scan_method = boost::log::sinks::file::scan_method::scan_matching, boost::log::keywords::max_size = max_size, boost::log::keywords::format = "[%TimeStamp%]: %Message%");
+		if (async)
+		{
+			auto backend (boost::make_shared<boost::log::sinks::text_file_backend> (boost::log::keywords::file_name = application_path_a / "log" / "log_%Y-%m-%d_%H-%M-%S.%N.log", boost::log::keywords::rotation_size = rotation_size, boost::log::keywords::auto_flush = false));
+			backend->set_file_collector (boost::log::sinks::file::make_collector (boost::log::keywords::target = application_path_a / "log", boost::log::keywords::max_size = max_size));
+			backend->scan_for_files (boost::log::sinks::file::scan_method::scan_matching);
+			auto sink (boost::make_shared<log_file_sink> (backend, false));
+			// Only the message is formatted by the caller, the record layout is applied on the writer thread
+			sink->set_formatter (boost::log::parse_formatter ("[%TimeStamp%]: %Message%"));
+			boost::log::core::get ()->add_sink (sink);
+			writer.reset (new log_writer (sink, flush));
+		}
+		else
+		{
+			boost::log::add_file_log (boost::log::keywords::target = application_path_a / "log", boost::log::keywords::file_name = application_path_a / "log" / "log_%Y-%m-%d_%H-%M-%S.%N.log", boost::log::keywords::rotation_size = rotation_size, boost::log::keywords::auto_flush = flush, boost::log::keywords::scan_method = boost::log::sinks::file::scan_method::scan_matching, boost::log::keywords::max_size = max_size, boost::log::keywords::format = "[%TimeStamp%]: %Message%");
+		}
+	}
+}
+
+uint64_t chratos::logging::dropped ()
+{
+	return log_dropped.load ();
+}
+
+void chratos::logging::flush_sinks ()
+{
+	if (writer != nullptr)
+	{
+		writer->write (true);
 	}
+	boost::log::core::get ()->flush ();
 }
 
 void chratos::logging::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "4");
+	tree_a.put ("version", "5");
 	tree_a.put ("ledger", ledger_logging_value);
 	tree_a.put ("ledger_duplicate", ledger_duplicate_logging_value);
 	tree_a.put ("vote", vote_logging_value);
@@ -61,6 +196,7 @@ void chratos::logging::serialize_json (boost::property_tree::ptree & tree_a) con
 	tree_a.put ("max_size", max_size);
 	tree_a.put ("rotation_size", rotation_size);
 	tree_a.put ("flush", flush);
+	tree_a.put ("async", async);
 }
 
 bool chratos::logging::upgrade_json (unsigned version_a, boost::property_tree::ptree & tree_a)
@@ -82,6 +218,10 @@ bool chratos::logging::upgrade_json (unsigned version_a, boost::property_tree::p
 			tree_a.put ("version", "4");
 			result = true;
 		case 4:
+			tree_a.put ("async", "true");
+			tree_a.put ("version", "5");
+			result = true;
+		case 5:
 			break;
 		default:
 			throw std::runtime_error ("Unknown logging_config version");
@@ -126,6 +266,7 @@ bool chratos::logging::deserialize_json (bool & upgraded_a, boost::property_tree
 		max_size = tree_a.get<uintmax_t> ("max_size");
 		rotation_size = tree_a.get<uintmax_t> ("rotation_size", 4194304);
 		flush = tree_a.get<bool> ("flush", true);
+		async = tree_a.get<bool> ("async", true);
 	}
 	catch (std::runtime_error const &)
 	{
@@ -4,6 +4,8 @@
 #include <boost/log/sources/logger.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/property_tree/ptree.hpp>
+
+#include <chrono>
 #include <cstdint>
 
 #define FATAL_LOG_PREFIX "FATAL ERROR: "
@@ -34,6 +36,10 @@ public:
 	bool work_generation_time () const;
 	bool log_to_cerr () const;
 	void init (boost::filesystem::path const &);
+	/** Number of log records discarded because the asynchronous file sink's queue was full */
+	static uint64_t dropped ();
+	/** Writes out everything queued for the file sink */
+	static void flush_sinks ();
 
 	bool ledger_logging_value;
 	bool ledger_duplicate_logging_value;
@@ -51,8 +57,13 @@ public:
 	bool work_generation_time_value;
 	bool log_to_cerr_value;
 	bool flush;
+	// Hand records to a writer thread instead of writing the log file on the logging thread
+	bool async;
 	uintmax_t max_size;
 	uintmax_t rotation_size;
 	boost::log::sources::logger_mt log;
+	// Records queued for the file writer beyond this are dropped and counted
+	static size_t constexpr queue_max = 64 * 1024;
+	static std::chrono::milliseconds constexpr flush_interval = std::chrono::milliseconds (100);
 };
 }
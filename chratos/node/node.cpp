@@ -13,6 +13,10 @@
 #include <boost/polymorphic_cast.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#if defined(__linux__)
+#include <sys/socket.h>
+#endif
+
 double constexpr chratos::node::price_max;
 double constexpr chratos::node::free_cutoff;
 std::chrono::seconds constexpr chratos::node::period;
@@ -32,41 +36,94 @@ extern unsigned char chratos_bootstrap_weights[];
 extern size_t chratos_bootstrap_weights_size;
 }
 
+chratos::udp_channel::udp_channel (chratos::node & node_a, uint16_t port_a, bool reuse_port_a, size_t buffer_count_a) :
+socket (node_a.service),
+buffer_container (node_a.stats, chratos::network::buffer_size, buffer_count_a)
+{
+	chratos::endpoint endpoint (boost::asio::ip::address_v6::any (), port_a);
+	socket.open (endpoint.protocol ());
+#if defined(__linux__)
+	if (reuse_port_a)
+	{
+		int enable (1);
+		if (setsockopt (socket.native_handle (), SOL_SOCKET, SO_REUSEPORT, &enable, sizeof (enable)) != 0)
+		{
+			throw boost::system::system_error (boost::system::error_code (errno, boost::system::system_category ()), "SO_REUSEPORT");
+		}
+	}
+#endif
+	socket.bind (endpoint);
+}
+
+namespace
+{
+std::vector<std::unique_ptr<chratos::udp_channel>> open_channels (chratos::node & node_a, uint16_t port_a)
+{
+#if defined(__linux__)
+	size_t count (node_a.config.udp_sockets);
+#else
+	// Only Linux load balances datagrams across sockets sharing a port
+	size_t count (1);
+#endif
+	// 2Mb of receive buffers split between the channels
+	auto buffer_count (std::max<size_t> (512, 4096 / count));
+	std::vector<std::unique_ptr<chratos::udp_channel>> result;
+	result.push_back (std::make_unique<chratos::udp_channel> (node_a, port_a, count > 1, buffer_count));
+	// Bind the rest to the port actually assigned so an ephemeral port is shared too
+	auto port_l (result.front ()->socket.local_endpoint ().port ());
+	while (result.size () < count)
+	{
+		result.push_back (std::make_unique<chratos::udp_channel> (node_a, port_l, true, buffer_count));
+	}
+	return result;
+}
+}
+
 chratos::network::network (chratos::node & node_a, uint16_t port) :
-buffer_container (node_a.stats, chratos::network::buffer_size, 4096), // 2Mb receive buffer
-socket (node_a.service, chratos::endpoint (boost::asio::ip::address_v6::any (), port)),
+channels (open_channels (node_a, port)),
+socket (channels.front ()->socket),
+socket_mutex (channels.front ()->socket_mutex),
+send_flushing (false),
+filter (node_a.stats, filter_size),
 resolver (node_a.service),
 node (node_a),
 on (true)
 {
 	boost::thread::attributes attrs;
 	chratos::thread_attributes::set (attrs);
-	for (size_t i = 0; i < node.config.network_threads; ++i)
+	// Every channel needs at least one thread servicing its buffers
+	auto threads (std::max<size_t> (node.config.network_threads, channels.size ()));
+	for (size_t i = 0; i < threads; ++i)
 	{
-		packet_processing_threads.push_back (boost::thread (attrs, [this]() {
+		auto & channel (*channels[i % channels.size ()]);
+		packet_processing_threads.push_back (boost::thread (attrs, [this, &channel]() {
 			chratos::thread_role::set (chratos::thread_role::name::packet_processing);
 			try
 			{
-				process_packets ();
+				process_packets (channel);
 			}
 			catch (boost::system::error_code & ec)
 			{
 				BOOST_LOG (this->node.log) << FATAL_LOG_PREFIX << ec.message ();
+				chratos::logging::flush_sinks ();
 				release_assert (false);
 			}
 			catch (std::error_code & ec)
 			{
 				BOOST_LOG (this->node.log) << FATAL_LOG_PREFIX << ec.message ();
+				chratos::logging::flush_sinks ();
 				release_assert (false);
 			}
 			catch (std::runtime_error & err)
 			{
 				BOOST_LOG (this->node.log) << FATAL_LOG_PREFIX << err.what ();
+				chratos::logging::flush_sinks ();
 				release_assert (false);
 			}
 			catch (...)
 			{
 				BOOST_LOG (this->node.log) << FATAL_LOG_PREFIX << "Unknown exception";
+				chratos::logging::flush_sinks ();
 				release_assert (false);
 			}
 			if (this->node.config.logging.network_packet_logging ())
@@ -87,30 +144,59 @@ chratos::network::~network ()
 
 void chratos::network::start ()
 {
-	for (size_t i = 0; i < node.config.io_threads; ++i)
+	auto receivers (std::max<size_t> (1, node.config.io_threads / channels.size ()));
+	for (auto & channel : channels)
 	{
-		receive ();
+		for (size_t i = 0; i < receivers; ++i)
+		{
+			receive (*channel);
+		}
 	}
 }
 
-void chratos::network::receive ()
+void chratos::network::receive (chratos::udp_channel & channel_a)
 {
 	if (node.config.logging.network_packet_logging ())
 	{
 		BOOST_LOG (node.log) << "Receiving packet";
 	}
-	std::unique_lock<std::mutex> lock (socket_mutex);
-	auto data (buffer_container.allocate ());
-	socket.async_receive_from (boost::asio::buffer (data->buffer, chratos::network::buffer_size), data->endpoint, [this, data](boost::system::error_code const & error, size_t size_a) {
+#if defined(__linux__)
+	// Wait for readability and drain as many datagrams as are queued with one recvmmsg call
+	std::unique_lock<std::mutex> lock (channel_a.socket_mutex);
+	channel_a.socket.async_wait (boost::asio::ip::udp::socket::wait_read, [this, &channel_a](boost::system::error_code const & error) {
+		if (!error && this->on)
+		{
+			this->receive_batch (channel_a);
+			this->receive (channel_a);
+		}
+		else
+		{
+			if (error)
+			{
+				if (this->node.config.logging.network_logging ())
+				{
+					BOOST_LOG (this->node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+				}
+			}
+			if (this->on)
+			{
+				this->node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this, &channel_a]() { this->receive (channel_a); });
+			}
+		}
+	});
+#else
+	std::unique_lock<std::mutex> lock (channel_a.socket_mutex);
+	auto data (channel_a.buffer_container.allocate ());
+	channel_a.socket.async_receive_from (boost::asio::buffer (data->buffer, chratos::network::buffer_size), data->endpoint, [this, &channel_a, data](boost::system::error_code const & error, size_t size_a) {
 		if (!error && this->on)
 		{
 			data->size = size_a;
-			this->buffer_container.enqueue (data);
-			this->receive ();
+			channel_a.buffer_container.enqueue (data);
+			this->receive (channel_a);
 		}
 		else
 		{
-			this->buffer_container.release (data);
+			channel_a.buffer_container.release (data);
 			if (error)
 			{
 				if (this->node.config.logging.network_logging ())
@@ -120,33 +206,90 @@ void chratos::network::receive ()
 			}
 			if (this->on)
 			{
-				this->node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { this->receive (); });
+				this->node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this, &channel_a]() { this->receive (channel_a); });
 			}
 		}
 	});
+#endif
 }
 
-void chratos::network::process_packets ()
+void chratos::network::receive_batch (chratos::udp_channel & channel_a)
+{
+#if defined(__linux__)
+	std::array<chratos::udp_data *, batch_size> data;
+	std::array<mmsghdr, batch_size> messages;
+	std::array<iovec, batch_size> vectors;
+	size_t count (0);
+	// Only the first buffer may displace an unserviced one, the rest of the batch uses free buffers
+	data[0] = channel_a.buffer_container.allocate ();
+	if (data[0] != nullptr)
+	{
+		++count;
+		while (count < batch_size && (data[count] = channel_a.buffer_container.try_allocate ()) != nullptr)
+		{
+			++count;
+		}
+	}
+	for (size_t i (0); i < count; ++i)
+	{
+		vectors[i].iov_base = data[i]->buffer;
+		vectors[i].iov_len = chratos::network::buffer_size;
+		messages[i] = mmsghdr ();
+		messages[i].msg_hdr.msg_name = data[i]->endpoint.data ();
+		messages[i].msg_hdr.msg_namelen = data[i]->endpoint.capacity ();
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	auto received (count > 0 ? recvmmsg (channel_a.socket.native_handle (), messages.data (), count, MSG_DONTWAIT, nullptr) : 0);
+	auto error (errno);
+	size_t i (0);
+	for (; received > 0 && i < static_cast<size_t> (received); ++i)
+	{
+		data[i]->size = messages[i].msg_len;
+		data[i]->endpoint.resize (messages[i].msg_hdr.msg_namelen);
+		channel_a.buffer_container.enqueue (data[i]);
+	}
+	for (; i < count; ++i)
+	{
+		channel_a.buffer_container.release (data[i]);
+	}
+	if (received < 0 && error != EAGAIN && error != EWOULDBLOCK)
+	{
+		if (node.config.logging.network_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("UDP Receive error: %1%") % std::strerror (error));
+		}
+	}
+#endif
+}
+
+void chratos::network::process_packets (chratos::udp_channel & channel_a)
 {
 	while (on)
 	{
-		auto data (buffer_container.dequeue ());
+		auto data (channel_a.buffer_container.dequeue ());
 		if (data == nullptr)
 		{
 			break;
 		}
 		//std::cerr << data->endpoint.address ().to_string ();
 		receive_action (data);
-		buffer_container.release (data);
+		channel_a.buffer_container.release (data);
 	}
 }
 
 void chratos::network::stop ()
 {
 	on = false;
-	socket.close ();
+	for (auto & channel : channels)
+	{
+		channel->socket.close ();
+	}
 	resolver.cancel ();
-	buffer_container.stop ();
+	for (auto & channel : channels)
+	{
+		channel->buffer_container.stop ();
+	}
 }
 
 void chratos::network::send_keepalive (chratos::endpoint const & endpoint_a)
@@ -507,7 +650,16 @@ public:
 			auto successor (node.ledger.successor (transaction, message_a.block->root ()));
 			if (successor != nullptr)
 			{
-				confirm_block (transaction, node, sender, std::move (successor));
+				if (successor->hash () == message_a.block->hash ())
+				{
+					// The requester already has this block, answer with an aggregated vote by hash
+					node.block_processor.generator.add (successor->hash (), sender);
+				}
+				else
+				{
+					// Our successor is a fork the requester may not know about, send the full block
+					confirm_block (transaction, node, sender, std::move (successor));
+				}
 			}
 		}
 	}
@@ -599,9 +751,14 @@ void chratos::network::receive_action (chratos::udp_data * data_a)
 	if (!chratos::reserved_address (data_a->endpoint, false) && data_a->endpoint != endpoint ())
 	{
 		network_message_visitor visitor (node, data_a->endpoint);
-		chratos::message_parser parser (visitor, node.work);
+		chratos::message_parser parser (visitor, node.work, &filter);
 		parser.deserialize_buffer (data_a->buffer, data_a->size);
-		if (parser.status != chratos::message_parser::parse_status::success)
+		if (parser.status == chratos::message_parser::parse_status::duplicate_publish_message || parser.status == chratos::message_parser::parse_status::duplicate_confirm_ack_message)
+		{
+			// Rebroadcast of a message already processed, the filter counts these
+			node.stats.add (chratos::stat::type::traffic, chratos::stat::dir::in, data_a->size);
+		}
+		else if (parser.status != chratos::message_parser::parse_status::success)
 		{
 			node.stats.inc (chratos::stat::type::error);
 
@@ -642,6 +799,8 @@ void chratos::network::receive_action (chratos::udp_data * data_a)
 					node.stats.inc (chratos::stat::type::udp, chratos::stat::detail::outdated_version);
 					break;
 				case chratos::message_parser::parse_status::success:
+				case chratos::message_parser::parse_status::duplicate_publish_message:
+				case chratos::message_parser::parse_status::duplicate_confirm_ack_message:
 					/* Already checked, unreachable */
 					break;
 			}
@@ -679,13 +838,9 @@ void chratos::network::merge_peers (std::array<chratos::endpoint, 8> const & pee
 	}
 }
 
-bool chratos::operation::operator> (chratos::operation const & other_a) const
-{
-	return wakeup > other_a.wakeup;
-}
-
 chratos::alarm::alarm (boost::asio::io_service & service_a) :
 service (service_a),
+stopped (false),
 thread ([this]() {
 	chratos::thread_role::set (chratos::thread_role::name::alarm);
 	run ();
@@ -695,49 +850,67 @@ thread ([this]() {
 
 chratos::alarm::~alarm ()
 {
-	add (std::chrono::steady_clock::now (), nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
 	thread.join ();
 }
 
 void chratos::alarm::run ()
 {
+	std::vector<std::function<void()>> expired;
 	std::unique_lock<std::mutex> lock (mutex);
-	auto done (false);
-	while (!done)
+	while (!stopped)
 	{
-		if (!operations.empty ())
+		operations.expire (std::chrono::steady_clock::now (), expired);
+		if (!expired.empty ())
 		{
-			auto & operation (operations.top ());
-			if (operation.function)
-			{
-				if (operation.wakeup <= std::chrono::steady_clock::now ())
-				{
-					service.post (operation.function);
-					operations.pop ();
-				}
-				else
-				{
-					auto wakeup (operation.wakeup);
-					condition.wait_until (lock, wakeup);
-				}
-			}
-			else
+			lock.unlock ();
+			for (auto & i : expired)
 			{
-				done = true;
+				service.post (std::move (i));
 			}
+			expired.clear ();
+			lock.lock ();
 		}
 		else
 		{
-			condition.wait (lock);
+			auto next (operations.next ());
+			if (next == std::chrono::steady_clock::time_point::max ())
+			{
+				condition.wait (lock);
+			}
+			else
+			{
+				condition.wait_until (lock, next);
+			}
 		}
 	}
 }
 
-void chratos::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation)
+chratos::timer_handle chratos::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	operations.push (chratos::operation ({ wakeup_a, operation }));
+	chratos::timer_handle result;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		result = operations.insert (wakeup_a, operation);
+	}
 	condition.notify_all ();
+	return result;
+}
+
+bool chratos::alarm::cancel (chratos::timer_handle const & handle_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return operations.cancel (handle_a);
+}
+
+size_t chratos::alarm::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return operations.size ();
 }
 
 chratos::node_init::node_init () :
@@ -777,7 +950,7 @@ void chratos::vote_processor::process_loop ()
 	{
 		if (!votes.empty ())
 		{
-			std::deque<std::pair<std::shared_ptr<chratos::vote>, chratos::endpoint>> votes_l;
+			std::deque<std::tuple<std::shared_ptr<chratos::vote>, chratos::endpoint, std::chrono::steady_clock::time_point>> votes_l;
 			votes_l.swap (votes);
 			active = true;
 			lock.unlock ();
@@ -785,7 +958,10 @@ void chratos::vote_processor::process_loop ()
 				auto transaction (node.store.tx_begin_read ());
 				for (auto & i : votes_l)
 				{
-					vote_blocking (transaction, i.first, i.second);
+					auto start (std::chrono::steady_clock::now ());
+					node.stats.latency (chratos::stat::stage::vote_queue, start - std::get<2> (i));
+					vote_blocking (transaction, std::get<0> (i), std::get<1> (i));
+					node.stats.latency (chratos::stat::stage::vote_process, std::chrono::steady_clock::now () - start);
 				}
 			}
 			lock.lock ();
@@ -805,7 +981,7 @@ void chratos::vote_processor::vote (std::shared_ptr<chratos::vote> vote_a, chrat
 	std::lock_guard<std::mutex> lock (mutex);
 	if (!stopped)
 	{
-		votes.push_back (std::make_pair (vote_a, endpoint_a));
+		votes.push_back (std::make_tuple (vote_a, endpoint_a, std::chrono::steady_clock::now ()));
 		condition.notify_all ();
 	}
 }
@@ -910,11 +1086,11 @@ bool chratos::rep_crawler::exists (chratos::block_hash const & hash_a)
 }
 
 chratos::block_processor::block_processor (chratos::node & node_a) :
+generator (node_a, chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? std::chrono::milliseconds (10) : std::chrono::milliseconds (500)),
 stopped (false),
 active (false),
 next_log (std::chrono::steady_clock::now ()),
-node (node_a),
-generator (node_a, chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? std::chrono::milliseconds (10) : std::chrono::milliseconds (500))
+node (node_a)
 {
 }
 
@@ -934,16 +1110,21 @@ void chratos::block_processor::stop ()
 void chratos::block_processor::flush ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && (have_blocks () || active))
+	while (!stopped && (have_blocks () || active || !representatives.empty ()))
 	{
 		condition.wait (lock);
 	}
 }
 
 bool chratos::block_processor::full ()
+{
+	return size () > 16384;
+}
+
+size_t chratos::block_processor::size ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	return blocks.size () > 16384;
+	return blocks.size () + state_blocks.size () + forced.size ();
 }
 
 void chratos::block_processor::add (std::shared_ptr<chratos::block> block_a, std::chrono::steady_clock::time_point origination)
@@ -989,8 +1170,14 @@ void chratos::block_processor::process_blocks ()
 			lock.unlock ();
 			process_receive_many (lock);
 			lock.lock ();
+			update_representatives (lock);
 			active = false;
 		}
+		else if (!representatives.empty ())
+		{
+			// Left by blocks processed in another thread's transaction
+			update_representatives (lock);
+		}
 		else
 		{
 			condition.notify_all ();
@@ -999,6 +1186,18 @@ void chratos::block_processor::process_blocks ()
 	}
 }
 
+void chratos::block_processor::update_representatives (std::unique_lock<std::mutex> & lock_a)
+{
+	decltype (representatives) representatives_l;
+	representatives_l.swap (representatives);
+	lock_a.unlock ();
+	for (auto & representative : representatives_l)
+	{
+		node.wallets.representative_update (representative);
+	}
+	lock_a.lock ();
+}
+
 bool chratos::block_processor::should_log ()
 {
 	auto result (false);
@@ -1047,8 +1246,13 @@ void chratos::block_processor::verify_state_blocks (std::unique_lock<std::mutex>
 	}
 	/* Verifications is vector if signatures check results
 	validate_message_batch returing "true" if there are at least 1 invalid signature */
+	auto verify_start (std::chrono::steady_clock::now ());
 	auto code (chratos::validate_message_batch (messages.data (), lengths.data (), pub_keys.data (), signatures.data (), size, verifications.data ()));
 	(void)code;
+	if (size > 0)
+	{
+		node.stats.latency (chratos::stat::stage::block_verify, std::chrono::steady_clock::now () - verify_start, size);
+	}
 	lock_a.lock ();
 	for (auto i (0); i < size; ++i)
 	{
@@ -1082,6 +1286,11 @@ void chratos::block_processor::process_receive_many (std::unique_lock<std::mutex
 			block = blocks.front ();
 			blocks.pop_front ();
 			blocks_hashes.erase (block.first->hash ());
+			// Bootstrapped blocks carry no origination time
+			if (block.second != std::chrono::steady_clock::time_point ())
+			{
+				node.stats.latency (chratos::stat::stage::block_queue, std::chrono::steady_clock::now () - block.second);
+			}
 		}
 		else
 		{
@@ -1115,7 +1324,9 @@ chratos::process_return chratos::block_processor::process_receive_one (chratos::
 {
 	chratos::process_return result;
 	auto hash (block_a->hash ());
+	auto process_start (std::chrono::steady_clock::now ());
 	result = node.ledger.process (transaction_a, *block_a, validated_state_block);
+	node.stats.latency (chratos::stat::stage::block_process, std::chrono::steady_clock::now () - process_start);
 	switch (result.code)
 	{
 		case chratos::process_result::progress:
@@ -1126,6 +1337,13 @@ chratos::process_return chratos::block_processor::process_receive_one (chratos::
 				block_a->serialize_json (block);
 				BOOST_LOG (node.log) << boost::str (boost::format ("Processing block %1%: %2%") % hash.to_string () % block);
 			}
+			if (!block_a->representative ().is_zero ())
+			{
+				// Checking the wallets is left until the write transaction is committed
+				std::lock_guard<std::mutex> lock (mutex);
+				representatives.insert (block_a->representative ());
+				condition.notify_all ();
+			}
 			if (node.block_arrival.recent (hash))
 			{
 				node.active.start (block_a);
@@ -1143,7 +1361,7 @@ chratos::process_return chratos::block_processor::process_receive_one (chratos::
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("Gap previous for: %1%") % hash.to_string ());
 			}
-			node.store.unchecked_put (transaction_a, block_a->previous (), block_a);
+			unchecked_put (transaction_a, block_a->previous (), block_a);
 			node.gap_cache.add (transaction_a, block_a);
 			break;
 		}
@@ -1153,7 +1371,7 @@ chratos::process_return chratos::block_processor::process_receive_one (chratos::
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("Gap source for: %1%") % hash.to_string ());
 			}
-			node.store.unchecked_put (transaction_a, node.ledger.block_source (transaction_a, *block_a), block_a);
+			unchecked_put (transaction_a, node.ledger.block_source (transaction_a, *block_a), block_a);
 			node.gap_cache.add (transaction_a, block_a);
 			break;
 		}
@@ -1254,7 +1472,7 @@ chratos::process_return chratos::block_processor::process_receive_one (chratos::
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("Block %1% cannot be sent without the account claiming for the dividend first") % hash.to_string ());
 			}
-			node.store.unchecked_put (transaction_a, block_a->dividend (), block_a);
+			unchecked_put (transaction_a, block_a->dividend (), block_a);
 			break;
 		}
 		case chratos::process_result::dividend_fork:
@@ -1294,6 +1512,28 @@ void chratos::block_processor::queue_unchecked (chratos::transaction const & tra
 	node.gap_cache.blocks.get<1> ().erase (hash_a);
 }
 
+void chratos::block_processor::unchecked_put (chratos::transaction const & transaction_a, chratos::block_hash const & dependency_a, std::shared_ptr<chratos::block> block_a)
+{
+	if (!node.store.unchecked_put (transaction_a, dependency_a, block_a))
+	{
+		node.stats.inc (chratos::stat::type::unchecked, chratos::stat::detail::put);
+		if (node.store.unchecked_count (transaction_a) > node.config.unchecked_max)
+		{
+			// Trim below the cap so the full scan isn't repeated on every following put
+			auto evicted (node.store.unchecked_trim (transaction_a, node.config.unchecked_max - node.config.unchecked_max / 10));
+			node.stats.add (chratos::stat::type::unchecked, chratos::stat::detail::evicted, chratos::stat::dir::in, evicted);
+			if (node.config.logging.ledger_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Evicted %1% unchecked blocks") % evicted);
+			}
+		}
+	}
+	else
+	{
+		node.stats.inc (chratos::stat::type::unchecked, chratos::stat::detail::duplicate);
+	}
+}
+
 chratos::node::node (chratos::node_init & init_a, boost::asio::io_service & service_a, uint16_t peering_port_a, boost::filesystem::path const & application_path_a, chratos::alarm & alarm_a, chratos::logging const & logging_a, chratos::work_pool & work_a) :
 node (init_a, service_a, application_path_a, alarm_a, chratos::node_config (peering_port_a, logging_a), work_a)
 {
@@ -1324,7 +1564,8 @@ block_processor_thread ([this]() {
 	this->block_processor.process_blocks ();
 }),
 online_reps (*this),
-stats (config.stat_config)
+stats (config.stat_config),
+work_peers (*this)
 {
 	wallets.observer = [this](bool active) {
 		observers.wallet.notify (active);
@@ -1507,6 +1748,7 @@ stats (config.stat_config)
 		if (!store.block_exists (transaction, genesis.hash ()))
 		{
 			BOOST_LOG (log) << "Genesis block not found. Make sure the node network ID is correct.";
+			chratos::logging::flush_sinks ();
 			std::exit (1);
 		}
 
@@ -1661,7 +1903,7 @@ void chratos::gap_cache::vote (std::shared_ptr<chratos::vote> vote_a)
 							{
 								BOOST_LOG (node_l->log) << boost::str (boost::format ("Missing block %1% which has enough votes to warrant bootstrapping it") % hash.to_string ());
 							}
-							node_l->bootstrap_initiator.bootstrap ();
+							node_l->bootstrap_initiator.bootstrap_lazy (hash);
 						}
 					});
 				}
@@ -1721,6 +1963,7 @@ void chratos::node::start ()
 	ongoing_bootstrap ();
 	ongoing_store_flush ();
 	ongoing_rep_crawl ();
+	ongoing_socket_sweep ();
 	bootstrap.start ();
 	backup_wallet ();
 	search_pending ();
@@ -1745,6 +1988,9 @@ void chratos::node::stop ()
 	port_mapping.stop ();
 	vote_processor.stop ();
 	wallets.stop ();
+	work_peers.stop ();
+	// Records still queued for the asynchronous file sink would otherwise be lost if the process exits next
+	chratos::logging::flush_sinks ();
 }
 
 void chratos::node::keepalive_preconfigured (std::vector<std::string> const & peers_a)
@@ -1883,6 +2129,19 @@ void chratos::node::ongoing_store_flush ()
 	});
 }
 
+void chratos::node::ongoing_socket_sweep ()
+{
+	auto now (std::chrono::steady_clock::now ());
+	socket_sweeper.sweep (now);
+	std::weak_ptr<chratos::node> node_w (shared_from_this ());
+	alarm.add (now + chratos::socket_sweeper::interval, [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_socket_sweep ();
+		}
+	});
+}
+
 void chratos::node::backup_wallet ()
 {
 	auto transaction (store.tx_begin_read ());
@@ -1928,21 +2187,6 @@ int chratos::node::price (chratos::uint128_t const & balance_a, int amount_a)
 
 namespace
 {
-class work_request
-{
-public:
-	work_request (boost::asio::io_service & service_a, boost::asio::ip::address address_a, uint16_t port_a) :
-	address (address_a),
-	port (port_a),
-	socket (service_a)
-	{
-	}
-	boost::asio::ip::address address;
-	uint16_t port;
-	boost::beast::flat_buffer buffer;
-	boost::beast::http::response<boost::beast::http::string_body> response;
-	boost::asio::ip::tcp::socket socket;
-};
 class distributed_work : public std::enable_shared_from_this<distributed_work>
 {
 public:
@@ -1956,156 +2200,141 @@ public:
 	backoff (backoff_a),
 	node (node_a),
 	root (root_a),
-	need_resolve (node_a->config.work_peers)
+	local (false),
+	completed (false),
+	deadline ({ std::numeric_limits<uint32_t>::max (), 0 })
 	{
 		assert (node_a != nullptr);
-		completed.clear ();
 	}
 	void start ()
 	{
-		if (need_resolve.empty ())
+		auto peers (node->work_peers.select ());
+		auto race (node->work_peers.race_count (peers));
 		{
-			start_work ();
+			std::lock_guard<std::mutex> lock (mutex);
+			reserve.assign (peers.begin () + race, peers.end ());
+		}
+		if (race != 0)
+		{
+			for (auto i (peers.begin ()), n (peers.begin () + race); i != n; ++i)
+			{
+				start_peer (*i);
+			}
+			std::weak_ptr<distributed_work> this_w (shared_from_this ());
+			auto deadline_l (node->alarm.add (std::chrono::steady_clock::now () + node->work_peers.deadline, [this_w]() {
+				if (auto this_l = this_w.lock ())
+				{
+					this_l->handle_deadline ();
+				}
+			}));
+			std::lock_guard<std::mutex> lock (mutex);
+			deadline = deadline_l;
 		}
 		else
 		{
-			auto current (need_resolve.back ());
-			need_resolve.pop_back ();
-			auto this_l (shared_from_this ());
-			boost::system::error_code ec;
-			auto parsed_address (boost::asio::ip::address_v6::from_string (current.first, ec));
-			if (!ec)
+			handle_failure ();
+		}
+	}
+	void start_peer (std::shared_ptr<chratos::work_peer> peer_a)
+	{
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			outstanding.push_back (peer_a);
+		}
+		boost::property_tree::ptree request;
+		request.put ("action", "work_generate");
+		request.put ("hash", root.to_string ());
+		auto this_l (shared_from_this ());
+		auto begin (std::chrono::steady_clock::now ());
+		auto request_l (node->work_peers.request (peer_a, request, [this_l, peer_a, begin](boost::optional<std::string> const & body_a) {
+			if (body_a)
 			{
-				outstanding[parsed_address] = current.second;
-				start ();
+				this_l->success (peer_a, *body_a, std::chrono::steady_clock::now () - begin);
 			}
 			else
 			{
-				node->network.resolver.async_resolve (boost::asio::ip::udp::resolver::query (current.first, std::to_string (current.second)), [current, this_l](boost::system::error_code const & ec, boost::asio::ip::udp::resolver::iterator i_a) {
-					if (!ec)
-					{
-						for (auto i (i_a), n (boost::asio::ip::udp::resolver::iterator {}); i != n; ++i)
-						{
-							auto endpoint (i->endpoint ());
-							this_l->outstanding[endpoint.address ()] = endpoint.port ();
-						}
-					}
-					else
-					{
-						BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Error resolving work peer: %1%:%2%: %3%") % current.first % current.second % ec.message ());
-					}
-					this_l->start ();
-				});
+				this_l->failure (peer_a);
 			}
+		}));
+		std::lock_guard<std::mutex> lock (mutex);
+		requests.push_back (request_l);
+		if (completed)
+		{
+			// Work was found while this request started
+			request_l->close ();
 		}
 	}
-	void start_work ()
+	void handle_deadline ()
 	{
-		if (!outstanding.empty ())
+		if (!completed)
 		{
-			auto this_l (shared_from_this ());
-			std::lock_guard<std::mutex> lock (mutex);
-			for (auto const & i : outstanding)
+			if (node->config.logging.work_generation_time ())
 			{
-				auto host (i.first);
-				auto service (i.second);
-				node->background ([this_l, host, service]() {
-					auto connection (std::make_shared<work_request> (this_l->node->service, host, service));
-					connection->socket.async_connect (chratos::tcp_endpoint (host, service), [this_l, connection](boost::system::error_code const & ec) {
-						if (!ec)
-						{
-							std::string request_string;
-							{
-								boost::property_tree::ptree request;
-								request.put ("action", "work_generate");
-								request.put ("hash", this_l->root.to_string ());
-								std::stringstream ostream;
-								boost::property_tree::write_json (ostream, request);
-								request_string = ostream.str ();
-							}
-							auto request (std::make_shared<boost::beast::http::request<boost::beast::http::string_body>> ());
-							request->method (boost::beast::http::verb::post);
-							request->target ("/");
-							request->version (11);
-							request->body () = request_string;
-							request->prepare_payload ();
-							boost::beast::http::async_write (connection->socket, *request, [this_l, connection, request](boost::system::error_code const & ec, size_t bytes_transferred) {
-								if (!ec)
-								{
-									boost::beast::http::async_read (connection->socket, connection->buffer, connection->response, [this_l, connection](boost::system::error_code const & ec, size_t bytes_transferred) {
-										if (!ec)
-										{
-											if (connection->response.result () == boost::beast::http::status::ok)
-											{
-												this_l->success (connection->response.body (), connection->address);
-											}
-											else
-											{
-												BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Work peer responded with an error %1% %2%: %3%") % connection->address % connection->port % connection->response.result ());
-												this_l->failure (connection->address);
-											}
-										}
-										else
-										{
-											BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Unable to read from work_peer %1% %2%: %3% (%4%)") % connection->address % connection->port % ec.message () % ec.value ());
-											this_l->failure (connection->address);
-										}
-									});
-								}
-								else
-								{
-									BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Unable to write to work_peer %1% %2%: %3% (%4%)") % connection->address % connection->port % ec.message () % ec.value ());
-									this_l->failure (connection->address);
-								}
-							});
-						}
-						else
-						{
-							BOOST_LOG (this_l->node->log) << boost::str (boost::format ("Unable to connect to work_peer %1% %2%: %3% (%4%)") % connection->address % connection->port % ec.message () % ec.value ());
-							this_l->failure (connection->address);
-						}
-					});
-				});
+				BOOST_LOG (node->log) << "Work peer(s) missed the deadline for root " << root.to_string () << ", generating locally";
 			}
-		}
-		else
-		{
-			handle_failure (true);
+			// Stalled peers are penalized now rather than when their request times out, they may still answer first
+			std::vector<std::shared_ptr<chratos::work_peer>> missed;
+			{
+				std::lock_guard<std::mutex> lock (mutex);
+				for (auto & peer : outstanding)
+				{
+					if (std::find (settled.begin (), settled.end (), peer) == settled.end ())
+					{
+						settled.push_back (peer);
+						missed.push_back (peer);
+					}
+				}
+			}
+			for (auto & peer : missed)
+			{
+				node->work_peers.failure (peer);
+			}
+			generate_local ();
 		}
 	}
-	void stop ()
+	// Local generation joins the race, peers still working may yet answer first
+	void generate_local ()
 	{
-		auto this_l (shared_from_this ());
-		std::lock_guard<std::mutex> lock (mutex);
-		for (auto const & i : outstanding)
+		if (!local.exchange (true) && (node->config.work_threads != 0 || node->work.opencl))
 		{
-			auto host (i.first);
-			node->background ([this_l, host]() {
-				std::string request_string;
+			auto this_l (shared_from_this ());
+			node->work.generate (root, [this_l](boost::optional<uint64_t> const & work_a) {
+				if (work_a)
 				{
-					boost::property_tree::ptree request;
-					request.put ("action", "work_cancel");
-					request.put ("hash", this_l->root.to_string ());
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, request);
-					request_string = ostream.str ();
+					this_l->set_once (*work_a);
 				}
-				boost::beast::http::request<boost::beast::http::string_body> request;
-				request.method (boost::beast::http::verb::post);
-				request.target ("/");
-				request.version (11);
-				request.body () = request_string;
-				request.prepare_payload ();
-				auto socket (std::make_shared<boost::asio::ip::tcp::socket> (this_l->node->service));
-				boost::beast::http::async_write (*socket, request, [socket](boost::system::error_code const & ec, size_t bytes_transferred) {
-				});
 			});
 		}
-		outstanding.clear ();
 	}
-	void success (std::string const & body_a, boost::asio::ip::address const & address)
+	void cancel_outstanding ()
+	{
+		std::vector<std::shared_ptr<chratos::work_peer>> outstanding_l;
+		std::vector<std::shared_ptr<chratos::work_peer_request>> requests_l;
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			outstanding_l.swap (outstanding);
+			requests_l.swap (requests);
+			settled.insert (settled.end (), outstanding_l.begin (), outstanding_l.end ());
+			reserve.clear ();
+		}
+		for (auto & request : requests_l)
+		{
+			request->close ();
+		}
+		boost::property_tree::ptree request;
+		request.put ("action", "work_cancel");
+		request.put ("hash", root.to_string ());
+		for (auto & peer : outstanding_l)
+		{
+			node->work_peers.request (peer, request, [](boost::optional<std::string> const &) {});
+		}
+		if (local)
+		{
+			node->work.cancel (root);
+		}
+	}
+	void success (std::shared_ptr<chratos::work_peer> peer_a, std::string const & body_a, std::chrono::steady_clock::duration latency_a)
 	{
-		auto last (remove (address));
 		std::stringstream istream (body_a);
 		try
 		{
@@ -2117,78 +2346,115 @@ public:
 			{
 				if (!chratos::work_validate (root, work))
 				{
+					node->work_peers.success (peer_a, latency_a);
+					remove (peer_a);
 					set_once (work);
-					stop ();
 				}
 				else
 				{
-					BOOST_LOG (node->log) << boost::str (boost::format ("Incorrect work response from %1% for root %2%: %3%") % address % root.to_string () % work_text);
-					handle_failure (last);
+					BOOST_LOG (node->log) << boost::str (boost::format ("Incorrect work response from %1% for root %2%: %3%") % peer_a->host % root.to_string () % work_text);
+					failure (peer_a);
 				}
 			}
 			else
 			{
-				BOOST_LOG (node->log) << boost::str (boost::format ("Work response from %1% wasn't a number: %2%") % address % work_text);
-				handle_failure (last);
+				BOOST_LOG (node->log) << boost::str (boost::format ("Work response from %1% wasn't a number: %2%") % peer_a->host % work_text);
+				failure (peer_a);
 			}
 		}
 		catch (...)
 		{
-			BOOST_LOG (node->log) << boost::str (boost::format ("Work response from %1% wasn't parsable: %2%") % address % body_a);
-			handle_failure (last);
+			BOOST_LOG (node->log) << boost::str (boost::format ("Work response from %1% wasn't parsable: %2%") % peer_a->host % body_a);
+			failure (peer_a);
 		}
 	}
 	void set_once (uint64_t work_a)
 	{
-		if (!completed.test_and_set ())
+		if (!completed.exchange (true))
 		{
 			callback (work_a);
+			cancel_outstanding ();
+			std::lock_guard<std::mutex> lock (mutex);
+			node->alarm.cancel (deadline);
 		}
 	}
-	void failure (boost::asio::ip::address const & address)
+	void failure (std::shared_ptr<chratos::work_peer> peer_a)
 	{
-		auto last (remove (address));
-		handle_failure (last);
+		// Peers answering after being cancelled lost the race rather than failed, anything else counts against them even once the race is over
+		if (!was_settled (peer_a))
+		{
+			node->work_peers.failure (peer_a);
+		}
+		if (remove (peer_a))
+		{
+			std::shared_ptr<chratos::work_peer> next;
+			{
+				std::lock_guard<std::mutex> lock (mutex);
+				if (!reserve.empty ())
+				{
+					next = reserve.front ();
+					reserve.pop_front ();
+				}
+			}
+			if (next != nullptr)
+			{
+				start_peer (next);
+			}
+			else if (empty ())
+			{
+				handle_failure ();
+			}
+		}
 	}
-	void handle_failure (bool last)
+	void handle_failure ()
 	{
-		if (last)
+		if (!completed)
 		{
-			if (!completed.test_and_set ())
+			if (node->config.work_threads != 0 || node->work.opencl)
 			{
-				if (node->config.work_threads != 0 || node->work.opencl)
+				generate_local ();
+			}
+			else if (!completed.exchange (true))
+			{
+				if (backoff == 1 && node->config.logging.work_generation_time ())
 				{
-					auto callback_l (callback);
-					node->work.generate (root, [callback_l](boost::optional<uint64_t> const & work_a) {
-						callback_l (work_a.value ());
-					});
+					BOOST_LOG (node->log) << "Work peer(s) failed to generate work for root " << root.to_string () << ", retrying...";
 				}
-				else
-				{
-					if (backoff == 1 && node->config.logging.work_generation_time ())
+				auto now (std::chrono::steady_clock::now ());
+				auto root_l (root);
+				auto callback_l (callback);
+				std::weak_ptr<chratos::node> node_w (node);
+				auto next_backoff (std::min (backoff * 2, (unsigned int)60 * 5));
+				node->alarm.add (now + std::chrono::seconds (backoff), [node_w, root_l, callback_l, next_backoff] {
+					if (auto node_l = node_w.lock ())
 					{
-						BOOST_LOG (node->log) << "Work peer(s) failed to generate work for root " << root.to_string () << ", retrying...";
+						auto work_generation (std::make_shared<distributed_work> (next_backoff, node_l, root_l, callback_l));
+						work_generation->start ();
 					}
-					auto now (std::chrono::steady_clock::now ());
-					auto root_l (root);
-					auto callback_l (callback);
-					std::weak_ptr<chratos::node> node_w (node);
-					auto next_backoff (std::min (backoff * 2, (unsigned int)60 * 5));
-					node->alarm.add (now + std::chrono::seconds (backoff), [node_w, root_l, callback_l, next_backoff] {
-						if (auto node_l = node_w.lock ())
-						{
-							auto work_generation (std::make_shared<distributed_work> (next_backoff, node_l, root_l, callback_l));
-							work_generation->start ();
-						}
-					});
-				}
+				});
 			}
 		}
 	}
-	bool remove (boost::asio::ip::address const & address)
+	// Returns true if the peer was still outstanding
+	bool remove (std::shared_ptr<chratos::work_peer> peer_a)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (std::find (outstanding.begin (), outstanding.end (), peer_a));
+		auto result (existing != outstanding.end ());
+		if (result)
+		{
+			outstanding.erase (existing);
+		}
+		return result;
+	}
+	bool was_settled (std::shared_ptr<chratos::work_peer> peer_a)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		return std::find (settled.begin (), settled.end (), peer_a) != settled.end ();
+	}
+	bool empty ()
 	{
 		std::lock_guard<std::mutex> lock (mutex);
-		outstanding.erase (address);
 		return outstanding.empty ();
 	}
 	std::function<void(uint64_t)> callback;
@@ -2196,9 +2462,17 @@ public:
 	std::shared_ptr<chratos::node> node;
 	chratos::block_hash root;
 	std::mutex mutex;
-	std::map<boost::asio::ip::address, uint16_t> outstanding;
-	std::vector<std::pair<std::string, uint16_t>> need_resolve;
-	std::atomic_flag completed;
+	std::vector<std::shared_ptr<chratos::work_peer>> outstanding;
+	// Peers whose failure no longer counts, either cancelled once work was found or already penalized for missing the deadline
+	std::vector<std::shared_ptr<chratos::work_peer>> settled;
+	// Requests to raced peers, closed once work is found so their connections don't stay open
+	std::vector<std::shared_ptr<chratos::work_peer_request>> requests;
+	// Selected peers not raced at first, tried in order as raced peers fail
+	std::deque<std::shared_ptr<chratos::work_peer>> reserve;
+	std::atomic<bool> local;
+	std::atomic<bool> completed;
+	// Cancelled once work is found so finished requests don't linger in the alarm
+	chratos::timer_handle deadline;
 };
 }
 
@@ -2354,6 +2628,11 @@ void chratos::node::process_confirmed (std::shared_ptr<chratos::block> block_a)
 	}
 	if (exists)
 	{
+		auto arrival (block_arrival.arrival_time (hash));
+		if (arrival)
+		{
+			stats.latency (chratos::stat::stage::block_confirm, std::chrono::steady_clock::now () - *arrival);
+		}
 		auto dividend (block_a->dividend ());
 		auto transaction (store.tx_begin_read ());
 		confirmed_visitor visitor (transaction, *this, block_a, hash, dividend);
@@ -2406,6 +2685,18 @@ bool chratos::block_arrival::add (chratos::block_hash const & hash_a)
 	return result;
 }
 
+boost::optional<std::chrono::steady_clock::time_point> chratos::block_arrival::arrival_time (chratos::block_hash const & hash_a)
+{
+	boost::optional<std::chrono::steady_clock::time_point> result;
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (arrival.get<1> ().find (hash_a));
+	if (existing != arrival.get<1> ().end ())
+	{
+		result = existing->arrival;
+	}
+	return result;
+}
+
 bool chratos::block_arrival::recent (chratos::block_hash const & hash_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
@@ -2610,25 +2901,93 @@ bool chratos::reserved_address (chratos::endpoint const & endpoint_a, bool black
 
 void chratos::network::send_buffer (uint8_t const * data_a, size_t size_a, chratos::endpoint const & endpoint_a, std::function<void(boost::system::error_code const &, size_t)> callback_a)
 {
-	std::unique_lock<std::mutex> lock (socket_mutex);
 	if (node.config.logging.network_packet_logging ())
 	{
 		BOOST_LOG (node.log) << "Sending packet";
 	}
-	socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a](boost::system::error_code const & ec, size_t size_a) {
-		callback_a (ec, size_a);
-		this->node.stats.add (chratos::stat::type::traffic, chratos::stat::dir::out, size_a);
-		if (ec == boost::system::errc::host_unreachable)
+#if defined(__linux__)
+	// Packets queued while a flush is pending go out together, fanouts become a handful of sendmmsg calls
+	auto flush (false);
+	{
+		std::lock_guard<std::mutex> lock (send_mutex);
+		send_queue.push_back ({ data_a, size_a, endpoint_a, callback_a });
+		flush = !send_flushing;
+		send_flushing = true;
+	}
+	if (flush)
+	{
+		node.service.post ([this]() {
+			this->flush_sends ();
+		});
+	}
+#else
+	send_buffer_async (data_a, size_a, endpoint_a, callback_a);
+#endif
+}
+
+void chratos::network::flush_sends ()
+{
+#if defined(__linux__)
+	std::deque<chratos::udp_send> sends;
+	{
+		std::lock_guard<std::mutex> lock (send_mutex);
+		sends.swap (send_queue);
+		send_flushing = false;
+	}
+	while (!sends.empty ())
+	{
+		auto count (std::min (sends.size (), batch_size));
+		std::array<mmsghdr, batch_size> messages;
+		std::array<iovec, batch_size> vectors;
+		for (size_t i (0); i < count; ++i)
 		{
-			this->node.stats.inc (chratos::stat::type::error, chratos::stat::detail::unreachable_host, chratos::stat::dir::out);
+			auto & send (sends[i]);
+			vectors[i].iov_base = const_cast<uint8_t *> (send.data);
+			vectors[i].iov_len = send.size;
+			messages[i] = mmsghdr ();
+			messages[i].msg_hdr.msg_name = send.endpoint.data ();
+			messages[i].msg_hdr.msg_namelen = send.endpoint.size ();
+			messages[i].msg_hdr.msg_iov = &vectors[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
 		}
-		if (this->node.config.logging.network_packet_logging ())
+		auto sent (sendmmsg (socket.native_handle (), messages.data (), count, MSG_DONTWAIT));
+		size_t i (0);
+		for (; sent > 0 && i < static_cast<size_t> (sent); ++i)
 		{
-			BOOST_LOG (this->node.log) << "Packet send complete";
+			send_complete (sends[i].callback, boost::system::error_code (), messages[i].msg_len);
 		}
+		// Packets the kernel didn't take, because of a full socket buffer or a per-destination error, use the asynchronous path which waits and reports errors
+		for (; i < count; ++i)
+		{
+			send_buffer_async (sends[i].data, sends[i].size, sends[i].endpoint, sends[i].callback);
+		}
+		sends.erase (sends.begin (), sends.begin () + count);
+	}
+#endif
+}
+
+void chratos::network::send_buffer_async (uint8_t const * data_a, size_t size_a, chratos::endpoint const & endpoint_a, std::function<void(boost::system::error_code const &, size_t)> callback_a)
+{
+	std::unique_lock<std::mutex> lock (socket_mutex);
+	socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a](boost::system::error_code const & ec, size_t size_a) {
+		this->send_complete (callback_a, ec, size_a);
 	});
 }
 
+void chratos::network::send_complete (std::function<void(boost::system::error_code const &, size_t)> const & callback_a, boost::system::error_code const & ec, size_t size_a)
+{
+	callback_a (ec, size_a);
+	node.stats.add (chratos::stat::type::traffic, chratos::stat::dir::out, size_a);
+	if (ec == boost::system::errc::host_unreachable)
+	{
+		node.stats.inc (chratos::stat::type::error, chratos::stat::detail::unreachable_host, chratos::stat::dir::out);
+	}
+	if (node.config.logging.network_packet_logging ())
+	{
+		BOOST_LOG (node.log) << "Packet send complete";
+	}
+}
+
 std::shared_ptr<chratos::node> chratos::node::shared ()
 {
 	return shared_from_this ();
@@ -3296,8 +3655,10 @@ chratos::inactive_node::~inactive_node ()
 
 chratos::udp_buffer::udp_buffer (chratos::stat & stats, size_t size, size_t count) :
 stats (stats),
-free (count),
-full (count),
+waiting (0),
+// Slack so a slot still being vacated by a stalled consumer doesn't make a queue look full
+free (2 * count),
+full (2 * count),
 slab (size * count),
 entries (count),
 stopped (false)
@@ -3309,59 +3670,87 @@ stopped (false)
 	for (auto i (0); i < count; ++i, ++entry_data)
 	{
 		*entry_data = { slab_data + i * size, 0, chratos::endpoint () };
-		free.push_back (entry_data);
+		auto pushed (free.push (entry_data));
+		assert (pushed);
+		(void)pushed;
 	}
 }
 chratos::udp_data * chratos::udp_buffer::allocate ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && free.empty () && full.empty ())
-	{
-		stats.inc (chratos::stat::type::udp, chratos::stat::detail::blocking, chratos::stat::dir::in);
-		condition.wait (lock);
-	}
 	chratos::udp_data * result (nullptr);
-	if (!free.empty ())
+	auto done (false);
+	while (!done)
 	{
-		result = free.front ();
-		free.pop_front ();
+		if (free.pop (result))
+		{
+			done = true;
+		}
+		else if (full.pop (result))
+		{
+			stats.inc (chratos::stat::type::udp, chratos::stat::detail::overflow, chratos::stat::dir::in);
+			done = true;
+		}
+		else if (stopped)
+		{
+			done = true;
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock (mutex);
+			++waiting;
+			if (!stopped && free.empty () && full.empty ())
+			{
+				stats.inc (chratos::stat::type::udp, chratos::stat::detail::blocking, chratos::stat::dir::in);
+				condition.wait (lock);
+			}
+			--waiting;
+		}
 	}
-	if (result == nullptr)
+	return result;
+}
+chratos::udp_data * chratos::udp_buffer::try_allocate ()
+{
+	chratos::udp_data * result (nullptr);
+	if (!stopped)
 	{
-		result = full.front ();
-		full.pop_front ();
-		stats.inc (chratos::stat::type::udp, chratos::stat::detail::overflow, chratos::stat::dir::in);
+		free.pop (result);
 	}
 	return result;
 }
 void chratos::udp_buffer::enqueue (chratos::udp_data * data_a)
 {
 	assert (data_a != nullptr);
-	std::lock_guard<std::mutex> lock (mutex);
-	full.push_back (data_a);
-	condition.notify_one ();
+	push (full, data_a);
+	notify ();
 }
 chratos::udp_data * chratos::udp_buffer::dequeue ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && full.empty ())
-	{
-		condition.wait (lock);
-	}
 	chratos::udp_data * result (nullptr);
-	if (!full.empty ())
+	auto done (false);
+	while (!done)
 	{
-		result = full.front ();
-		full.pop_front ();
+		if (full.pop (result) || stopped)
+		{
+			done = true;
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock (mutex);
+			++waiting;
+			if (!stopped && full.empty ())
+			{
+				condition.wait (lock);
+			}
+			--waiting;
+		}
 	}
 	return result;
 }
 void chratos::udp_buffer::release (chratos::udp_data * data_a)
 {
 	assert (data_a != nullptr);
-	std::lock_guard<std::mutex> lock (mutex);
-	free.push_back (data_a);
-	condition.notify_one ();
+	push (free, data_a);
+	notify ();
 }
 void chratos::udp_buffer::stop ()
 {
@@ -3369,3 +3758,21 @@ void chratos::udp_buffer::stop ()
 	stopped = true;
 	condition.notify_all ();
 }
+void chratos::udp_buffer::push (chratos::mpmc_queue<chratos::udp_data *> & queue_a, chratos::udp_data * data_a)
+{
+	// There is always room for every buffer, a push can only fail transiently while a consumer is mid-pop on the same slot
+	while (!queue_a.push (data_a))
+	{
+		std::this_thread::yield ();
+	}
+}
+void chratos::udp_buffer::notify ()
+{
+	// Pairs with the waiter registering itself before rechecking the queues, either the waiter sees the new item or this sees the waiter
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	if (waiting.load () > 0)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		condition.notify_one ();
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chratos/lib/timer_wheel.hpp>
 #include <chratos/lib/work.hpp>
 #include <chratos/node/bootstrap.hpp>
 #include <chratos/node/logging.hpp>
@@ -9,6 +10,7 @@
 #include <chratos/node/stats.hpp>
 #include <chratos/node/voting.hpp>
 #include <chratos/node/wallet.hpp>
+#include <chratos/node/work_peers.hpp>
 #include <chratos/secure/ledger.hpp>
 
 #include <condition_variable>
@@ -131,24 +133,22 @@ private:
 	bool stopped;
 	boost::thread thread;
 };
-class operation
-{
-public:
-	bool operator> (chratos::operation const &) const;
-	std::chrono::steady_clock::time_point wakeup;
-	std::function<void()> function;
-};
+// Posts operations to the io_service once their time comes, due operations are collected in batches from a timer wheel
 class alarm
 {
 public:
 	alarm (boost::asio::io_service &);
 	~alarm ();
-	void add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	chratos::timer_handle add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	// Returns true if the operation already ran or was cancelled
+	bool cancel (chratos::timer_handle const &);
+	size_t size ();
 	void run ();
 	boost::asio::io_service & service;
 	std::mutex mutex;
 	std::condition_variable condition;
-	std::priority_queue<operation, std::vector<operation>, std::greater<operation>> operations;
+	chratos::timer_wheel operations;
+	bool stopped;
 	boost::thread thread;
 };
 class gap_information
@@ -198,6 +198,8 @@ public:
 	// Return `true' to indicated an error if the block has already been inserted
 	bool add (chratos::block_hash const &);
 	bool recent (chratos::block_hash const &);
+	/** When the block arrived, if it is still tracked */
+	boost::optional<std::chrono::steady_clock::time_point> arrival_time (chratos::block_hash const &);
 	boost::multi_index_container<
 	chratos::block_arrival_info,
 	boost::multi_index::indexed_by<
@@ -260,6 +262,9 @@ public:
 	// Function will block if there are no free or unserviced buffers
 	// Return nullptr if the container has stopped
 	chratos::udp_data * allocate ();
+	// Return a free buffer without blocking or dropping unserviced buffers
+	// Return nullptr if there are no free buffers
+	chratos::udp_data * try_allocate ();
 	// Queue a buffer that has been filled with UDP data and notify servicing threads
 	void enqueue (chratos::udp_data *);
 	// Return a buffer that has been filled with UDP data
@@ -272,22 +277,46 @@ public:
 	void stop ();
 
 private:
+	void push (chratos::mpmc_queue<chratos::udp_data *> &, chratos::udp_data *);
+	void notify ();
 	chratos::stat & stats;
+	// Only used to sleep when there is nothing to allocate or dequeue, the queues themselves are lock-free
 	std::mutex mutex;
 	std::condition_variable condition;
-	boost::circular_buffer<chratos::udp_data *> free;
-	boost::circular_buffer<chratos::udp_data *> full;
+	std::atomic<unsigned> waiting;
+	chratos::mpmc_queue<chratos::udp_data *> free;
+	chratos::mpmc_queue<chratos::udp_data *> full;
 	std::vector<uint8_t> slab;
 	std::vector<chratos::udp_data> entries;
-	bool stopped;
+	std::atomic<bool> stopped;
+};
+class udp_send
+{
+public:
+	uint8_t const * data;
+	size_t size;
+	chratos::endpoint endpoint;
+	std::function<void(boost::system::error_code const &, size_t)> callback;
+};
+/**
+ * A socket bound to the peering port along with the buffers datagrams received on it are queued in.
+ * With SO_REUSEPORT the kernel hashes each peer to one socket, so a flow stays on the same channel.
+ */
+class udp_channel
+{
+public:
+	udp_channel (chratos::node &, uint16_t, bool, size_t);
+	boost::asio::ip::udp::socket socket;
+	chratos::udp_buffer buffer_container;
+	std::mutex socket_mutex;
 };
 class network
 {
 public:
 	network (chratos::node &, uint16_t);
 	~network ();
-	void receive ();
-	void process_packets ();
+	void receive (chratos::udp_channel &);
+	void process_packets (chratos::udp_channel &);
 	void start ();
 	void stop ();
 	void receive_action (chratos::udp_data *);
@@ -307,15 +336,31 @@ public:
 	void send_confirm_req (chratos::endpoint const &, std::shared_ptr<chratos::block>);
 	void send_buffer (uint8_t const *, size_t, chratos::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
 	chratos::endpoint endpoint ();
-	chratos::udp_buffer buffer_container;
-	boost::asio::ip::udp::socket socket;
-	std::mutex socket_mutex;
+	std::vector<std::unique_ptr<chratos::udp_channel>> channels;
+	// The first channel's socket also carries all outbound traffic
+	boost::asio::ip::udp::socket & socket;
+	std::mutex & socket_mutex;
+	// Outbound packets waiting to be flushed in a single batch
+	std::deque<chratos::udp_send> send_queue;
+	std::mutex send_mutex;
+	bool send_flushing;
+	chratos::message_filter filter;
 	boost::asio::ip::udp::resolver resolver;
 	std::vector<boost::thread> packet_processing_threads;
 	chratos::node & node;
 	bool on;
 	static uint16_t const node_port = chratos::chratos_network == chratos::chratos_networks::chratos_live_network ? 9125 : 44000;
 	static size_t const buffer_size = 512;
+	// Maximum number of datagrams moved per batched system call
+	static size_t const batch_size = 64;
+	// Number of recently received publish and confirm_ack digests remembered
+	static size_t const filter_size = 64 * 1024;
+
+private:
+	void receive_batch (chratos::udp_channel &);
+	void flush_sends ();
+	void send_buffer_async (uint8_t const *, size_t, chratos::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
+	void send_complete (std::function<void(boost::system::error_code const &, size_t)> const &, boost::system::error_code const &, size_t);
 };
 
 class node_init
@@ -349,7 +394,7 @@ public:
 
 private:
 	void process_loop ();
-	std::deque<std::pair<std::shared_ptr<chratos::vote>, chratos::endpoint>> votes;
+	std::deque<std::tuple<std::shared_ptr<chratos::vote>, chratos::endpoint, std::chrono::steady_clock::time_point>> votes;
 	std::condition_variable condition;
 	std::mutex mutex;
 	bool started;
@@ -377,17 +422,21 @@ public:
 	void stop ();
 	void flush ();
 	bool full ();
+	size_t size ();
 	void add (std::shared_ptr<chratos::block>, std::chrono::steady_clock::time_point);
 	void force (std::shared_ptr<chratos::block>);
 	bool should_log ();
 	bool have_blocks ();
 	void process_blocks ();
 	chratos::process_return process_receive_one (chratos::transaction const &, std::shared_ptr<chratos::block>, std::chrono::steady_clock::time_point = std::chrono::steady_clock::now (), bool = false);
+	chratos::vote_generator generator;
 
 private:
 	void queue_unchecked (chratos::transaction const &, chratos::block_hash const &);
+	void unchecked_put (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block>);
 	void process_receive_many (std::unique_lock<std::mutex> &);
 	void verify_state_blocks (std::unique_lock<std::mutex> &);
+	void update_representatives (std::unique_lock<std::mutex> &);
 	bool stopped;
 	bool active;
 	std::chrono::steady_clock::time_point next_log;
@@ -395,9 +444,10 @@ private:
 	std::deque<std::pair<std::shared_ptr<chratos::block>, std::chrono::steady_clock::time_point>> state_blocks;
 	std::unordered_set<chratos::block_hash> blocks_hashes;
 	std::deque<std::shared_ptr<chratos::block>> forced;
+	// Representatives named by processed blocks, matched against wallet accounts once the write transaction is committed
+	std::unordered_set<chratos::account> representatives;
 	std::condition_variable condition;
 	chratos::node & node;
-	chratos::vote_generator generator;
 	std::mutex mutex;
 };
 class node : public std::enable_shared_from_this<chratos::node>
@@ -434,6 +484,7 @@ public:
 	void ongoing_rep_crawl ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_socket_sweep ();
 	void backup_wallet ();
 	void search_pending ();
 	int price (chratos::uint128_t const &, int);
@@ -472,6 +523,8 @@ public:
 	chratos::block_arrival block_arrival;
 	chratos::online_reps online_reps;
 	chratos::stat stats;
+	chratos::work_peer_client work_peers;
+	chratos::socket_sweeper socket_sweeper;
 	chratos::keypair node_id;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
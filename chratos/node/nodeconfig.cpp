@@ -19,13 +19,17 @@ online_weight_quorum (50),
 password_fanout (1024),
 io_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 network_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
+udp_sockets (1),
 work_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 enable_voting (true),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
 callback_port (0),
 lmdb_max_dbs (128),
-block_processor_batch_max_time (std::chrono::milliseconds (5000))
+block_processor_batch_max_time (std::chrono::milliseconds (5000)),
+unchecked_max (1024 * 1024),
+work_precache_budget (25),
+kdf_memory_budget (256)
 {
 	const char * epoch_message ("epoch v1 block");
 	strncpy ((char *)epoch_block_link.bytes.data (), epoch_message, epoch_block_link.bytes.size ());
@@ -51,7 +55,7 @@ block_processor_batch_max_time (std::chrono::milliseconds (5000))
 
 void chratos::node_config::serialize_json (boost::property_tree::ptree & tree_a) const
 {
-	tree_a.put ("version", "15");
+	tree_a.put ("version", "19");
 	tree_a.put ("peering_port", std::to_string (peering_port));
 	tree_a.put ("bootstrap_fraction_numerator", std::to_string (bootstrap_fraction_numerator));
 	tree_a.put ("receive_minimum", receive_minimum.to_string_dec ());
@@ -87,6 +91,7 @@ void chratos::node_config::serialize_json (boost::property_tree::ptree & tree_a)
 	tree_a.put ("password_fanout", std::to_string (password_fanout));
 	tree_a.put ("io_threads", std::to_string (io_threads));
 	tree_a.put ("network_threads", std::to_string (network_threads));
+	tree_a.put ("udp_sockets", std::to_string (udp_sockets));
 	tree_a.put ("work_threads", std::to_string (work_threads));
 	tree_a.put ("enable_voting", enable_voting);
 	tree_a.put ("bootstrap_connections", bootstrap_connections);
@@ -96,6 +101,9 @@ void chratos::node_config::serialize_json (boost::property_tree::ptree & tree_a)
 	tree_a.put ("callback_target", callback_target);
 	tree_a.put ("lmdb_max_dbs", lmdb_max_dbs);
 	tree_a.put ("block_processor_batch_max_time", block_processor_batch_max_time.count ());
+	tree_a.put ("unchecked_max", std::to_string (unchecked_max));
+	tree_a.put ("work_precache_budget", std::to_string (work_precache_budget));
+	tree_a.put ("kdf_memory_budget", std::to_string (kdf_memory_budget));
 }
 
 bool chratos::node_config::upgrade_json (unsigned version, boost::property_tree::ptree & tree_a)
@@ -210,6 +218,26 @@ bool chratos::node_config::upgrade_json (unsigned version, boost::property_tree:
 			tree_a.put ("version", "15");
 			result = true;
 		case 15:
+			tree_a.put ("udp_sockets", std::to_string (udp_sockets));
+			tree_a.erase ("version");
+			tree_a.put ("version", "16");
+			result = true;
+		case 16:
+			tree_a.put ("unchecked_max", std::to_string (unchecked_max));
+			tree_a.erase ("version");
+			tree_a.put ("version", "17");
+			result = true;
+		case 17:
+			tree_a.put ("work_precache_budget", std::to_string (work_precache_budget));
+			tree_a.erase ("version");
+			tree_a.put ("version", "18");
+			result = true;
+		case 18:
+			tree_a.put ("kdf_memory_budget", std::to_string (kdf_memory_budget));
+			tree_a.erase ("version");
+			tree_a.put ("version", "19");
+			result = true;
+		case 19:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -303,6 +331,10 @@ bool chratos::node_config::deserialize_json (bool & upgraded_a, boost::property_
 			password_fanout = std::stoul (password_fanout_l);
 			io_threads = std::stoul (io_threads_l);
 			network_threads = tree_a.get<unsigned> ("network_threads", network_threads);
+			udp_sockets = tree_a.get<unsigned> ("udp_sockets", udp_sockets);
+			unchecked_max = tree_a.get<unsigned> ("unchecked_max", unchecked_max);
+			work_precache_budget = tree_a.get<unsigned> ("work_precache_budget", work_precache_budget);
+			kdf_memory_budget = tree_a.get<unsigned> ("kdf_memory_budget", kdf_memory_budget);
 			work_threads = std::stoul (work_threads_l);
 			bootstrap_connections = std::stoul (bootstrap_connections_l);
 			bootstrap_connections_max = std::stoul (bootstrap_connections_max_l);
@@ -317,6 +349,10 @@ bool chratos::node_config::deserialize_json (bool & upgraded_a, boost::property_
 			result |= password_fanout < 16;
 			result |= password_fanout > 1024 * 1024;
 			result |= io_threads == 0;
+			result |= udp_sockets == 0;
+			result |= unchecked_max == 0;
+			result |= work_precache_budget > 100;
+			result |= kdf_memory_budget == 0;
 		}
 		catch (std::logic_error const &)
 		{
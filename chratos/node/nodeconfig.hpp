@@ -34,6 +34,8 @@ public:
 	unsigned password_fanout;
 	unsigned io_threads;
 	unsigned network_threads;
+	// Number of SO_REUSEPORT sockets sharing the peering port, each with its own receive loop and buffers
+	unsigned udp_sockets;
 	unsigned work_threads;
 	bool enable_voting;
 	unsigned bootstrap_connections;
@@ -46,6 +48,12 @@ public:
 	chratos::uint256_union epoch_block_link;
 	chratos::account epoch_block_signer;
 	std::chrono::milliseconds block_processor_batch_max_time;
+	// Unchecked blocks kept waiting on dependencies, oldest arrivals are evicted above this
+	unsigned unchecked_max;
+	// Percent of time wallet work precomputing may keep the work pool busy, 0 disables it
+	unsigned work_precache_budget;
+	// MiB of memory wallet key derivations may use at once, each takes wallet_store::kdf_work KiB
+	unsigned kdf_memory_budget;
 	static std::chrono::seconds constexpr keepalive_period = std::chrono::seconds (60);
 	static std::chrono::seconds constexpr keepalive_cutoff = keepalive_period * 5;
 	static std::chrono::minutes constexpr wallet_backup_interval = std::chrono::minutes (5);
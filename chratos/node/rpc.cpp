@@ -322,6 +322,20 @@ uint64_t chratos::rpc_handler::work_optional_impl ()
 	return result;
 }
 
+uint64_t chratos::rpc_handler::difficulty_optional_impl ()
+{
+	uint64_t result (chratos::work_pool::publish_threshold);
+	boost::optional<std::string> difficulty_text (request.get_optional<std::string> ("difficulty"));
+	if (!ec && difficulty_text.is_initialized ())
+	{
+		if (chratos::from_string_hex (difficulty_text.get (), result) || result < chratos::work_pool::publish_threshold)
+		{
+			ec = nano::error_common::bad_difficulty_format;
+		}
+	}
+	return result;
+}
+
 namespace
 {
 bool decode_unsigned (std::string const & text, uint64_t & number)
@@ -1413,6 +1427,55 @@ void chratos::rpc_handler::bootstrap_any ()
 	response_errors ();
 }
 
+void chratos::rpc_handler::bootstrap_lazy ()
+{
+	auto hash (hash_impl ());
+	if (!ec)
+	{
+		node.bootstrap_initiator.bootstrap_lazy (hash);
+		response_l.put ("success", "");
+	}
+	response_errors ();
+}
+
+void chratos::rpc_handler::bootstrap_status ()
+{
+	auto attempt (node.bootstrap_initiator.current_attempt ());
+	if (attempt != nullptr)
+	{
+		response_l.put ("running", "1");
+		response_l.put ("lazy", attempt->lazy_mode ? "1" : "0");
+		response_l.put ("connections", std::to_string (attempt->connections.load ()));
+		response_l.put ("pulling", std::to_string (attempt->pulling.load ()));
+		response_l.put ("total_blocks", std::to_string (attempt->total_blocks.load ()));
+		response_l.put ("block_processor_queue", std::to_string (node.block_processor.size ()));
+		boost::property_tree::ptree peers;
+		{
+			std::lock_guard<std::mutex> lock (attempt->mutex);
+			response_l.put ("pulls", std::to_string (attempt->pulls.size ()));
+			response_l.put ("idle", std::to_string (attempt->idle.size ()));
+			for (auto & i : attempt->clients)
+			{
+				if (auto client = i.lock ())
+				{
+					boost::property_tree::ptree entry;
+					entry.put ("endpoint", boost::str (boost::format ("%1%") % client->endpoint));
+					entry.put ("rate", std::to_string (client->throughput.load ()));
+					entry.put ("block_count", std::to_string (client->block_count.load ()));
+					entry.put ("pulling", client->pulling ? "1" : "0");
+					peers.push_back (std::make_pair ("", entry));
+				}
+			}
+		}
+		response_l.add_child ("peers", peers);
+	}
+	else
+	{
+		response_l.put ("running", "0");
+	}
+	response_errors ();
+}
+
 void chratos::rpc_handler::burn_account_balance ()
 {
 	auto hash (hash_impl ("dividend"));
@@ -3272,11 +3335,39 @@ void chratos::rpc_handler::stats ()
 	{
 		node.stats.log_samples (*sink);
 	}
+	else if (type == "work")
+	{
+		auto work_stats (node.work.stats ());
+		response_l.put ("queue_depth", std::to_string (work_stats.queue_depth));
+		response_l.put ("active", std::to_string (work_stats.active));
+		response_l.put ("solved", std::to_string (work_stats.solved));
+		response_l.put ("cancelled", std::to_string (work_stats.cancelled));
+		response_l.put ("solve_time_total_ms", std::to_string (work_stats.solve_time_total.count ()));
+		response_l.put ("solve_time_max_ms", std::to_string (work_stats.solve_time_max.count ()));
+	}
+	else if (type == "latency")
+	{
+		// Microseconds spent in each block and vote pipeline stage
+		for (size_t i (0); i < chratos::stat::stage_count; ++i)
+		{
+			auto stage (static_cast<chratos::stat::stage> (i));
+			auto & histogram (node.stats.histogram (stage));
+			boost::property_tree::ptree entry;
+			entry.put ("count", std::to_string (histogram.count ()));
+			entry.put ("mean", std::to_string (histogram.count () > 0 ? histogram.sum () / histogram.count () : 0));
+			entry.put ("p50", std::to_string (histogram.percentile (0.5)));
+			entry.put ("p90", std::to_string (histogram.percentile (0.9)));
+			entry.put ("p99", std::to_string (histogram.percentile (0.99)));
+			entry.put ("p999", std::to_string (histogram.percentile (0.999)));
+			entry.put ("max", std::to_string (histogram.max ()));
+			response_l.add_child (chratos::stat::stage_to_string (stage), entry);
+		}
+	}
 	else
 	{
 		ec = nano::error_rpc::invalid_missing_type;
 	}
-	if (!ec)
+	if (!ec && response_l.empty ())
 	{
 		response (*static_cast<boost::property_tree::ptree *> (sink->to_object ()));
 	}
@@ -3310,7 +3401,7 @@ void chratos::rpc_handler::unchecked ()
 		auto transaction (node.store.tx_begin_read ());
 		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
 		{
-			auto block (i->second);
+			auto block (i->second.block);
 			std::string contents;
 			block->serialize_json (contents);
 			unchecked.put (block->hash ().to_string (), contents);
@@ -3340,12 +3431,13 @@ void chratos::rpc_handler::unchecked_get ()
 		auto transaction (node.store.tx_begin_read ());
 		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n; ++i)
 		{
-			std::shared_ptr<chratos::block> block (i->second);
-			if (block->hash () == hash)
+			std::shared_ptr<chratos::block> block (i->second.block);
+			if (i->first.hash == hash)
 			{
 				std::string contents;
 				block->serialize_json (contents);
 				response_l.put ("contents", contents);
+				response_l.put ("modified_timestamp", std::to_string (i->second.modified));
 				break;
 			}
 		}
@@ -3376,11 +3468,12 @@ void chratos::rpc_handler::unchecked_keys ()
 		for (auto i (node.store.unchecked_begin (transaction, key)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
 		{
 			boost::property_tree::ptree entry;
-			auto block (i->second);
+			auto block (i->second.block);
 			std::string contents;
 			block->serialize_json (contents);
-			entry.put ("key", chratos::block_hash (i->first).to_string ());
+			entry.put ("key", i->first.key ().to_string ());
 			entry.put ("hash", block->hash ().to_string ());
+			entry.put ("modified_timestamp", std::to_string (i->second.modified));
 			entry.put ("contents", contents);
 			unchecked.push_back (std::make_pair ("", entry));
 		}
@@ -3767,9 +3860,7 @@ void chratos::rpc_handler::wallet_lock ()
 	auto wallet (wallet_impl ());
 	if (!ec)
 	{
-		chratos::raw_key empty;
-		empty.data.clear ();
-		wallet->store.password.value_set (empty);
+		wallet->lock ();
 		response_l.put ("locked", "1");
 	}
 	response_errors ();
@@ -3936,6 +4027,7 @@ void chratos::rpc_handler::work_generate ()
 {
 	rpc_control_impl ();
 	auto hash (hash_impl ());
+	auto difficulty (difficulty_optional_impl ());
 	if (!ec)
 	{
 		bool use_peers (request.get_optional<bool> ("use_peers") == true);
@@ -3954,7 +4046,7 @@ void chratos::rpc_handler::work_generate ()
 		};
 		if (!use_peers)
 		{
-			node.work.generate (hash, callback);
+			node.work.generate (hash, callback, difficulty, chratos::work_priority::interactive);
 		}
 		else
 		{
@@ -4098,11 +4190,11 @@ void chratos::rpc_connection::parse_connection ()
 	read ();
 }
 
-void chratos::rpc_connection::write_result (std::string body, unsigned version)
+void chratos::rpc_connection::write_result (std::string body, unsigned version, std::string const & content_type)
 {
 	if (!responded.test_and_set ())
 	{
-		res.set ("Content-Type", "application/json");
+		res.set ("Content-Type", content_type);
 		res.set ("Access-Control-Allow-Origin", "*");
 		res.set ("Access-Control-Allow-Headers", "Accept, Accept-Language, Content-Language, Content-Type");
 		res.set ("Connection", "close");
@@ -4147,6 +4239,13 @@ void chratos::rpc_connection::read ()
 					auto handler (std::make_shared<chratos::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), request_id, response_handler));
 					handler->process_request ();
 				}
+				else if (this_l->request.method () == boost::beast::http::verb::get && this_l->request.target () == "/metrics")
+				{
+					// Statistics for Prometheus scrapers
+					this_l->write_result (this_l->node->stats.prometheus (), version, "text/plain; version=0.0.4");
+					boost::beast::http::async_write (this_l->socket, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+					});
+				}
 				else
 				{
 					error_response (response_handler, "Can only POST requests");
@@ -4355,6 +4454,14 @@ void chratos::rpc_handler::process_request ()
 			{
 				bootstrap_any ();
 			}
+			else if (action == "bootstrap_lazy")
+			{
+				bootstrap_lazy ();
+			}
+			else if (action == "bootstrap_status")
+			{
+				bootstrap_status ();
+			}
 			else if (action == "burn_account_balance")
 			{
 				burn_account_balance ();
@@ -86,7 +86,7 @@ public:
 	virtual ~rpc_connection () = default;
 	virtual void parse_connection ();
 	virtual void read ();
-	virtual void write_result (std::string body, unsigned version);
+	virtual void write_result (std::string body, unsigned version, std::string const & content_type = "application/json");
 	std::shared_ptr<chratos::node> node;
 	chratos::rpc & rpc;
 	boost::asio::ip::tcp::socket socket;
@@ -150,6 +150,8 @@ public:
 	void block_hash ();
 	void bootstrap ();
 	void bootstrap_any ();
+	void bootstrap_lazy ();
+	void bootstrap_status ();
 	void burn_account_balance ();
 	void chain (bool = false);
 	void claimed_dividends ();
@@ -247,6 +249,7 @@ public:
 	chratos::block_hash hash_impl (std::string = "hash");
 	chratos::amount threshold_optional_impl ();
 	uint64_t work_optional_impl ();
+	uint64_t difficulty_optional_impl ();
 	uint64_t count_impl ();
 	uint64_t count_optional_impl (uint64_t = std::numeric_limits<uint64_t>::max ());
 	bool rpc_control_impl ();
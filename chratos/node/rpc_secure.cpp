@@ -179,6 +179,14 @@ void chratos::rpc_connection_secure::read ()
 					auto handler (std::make_shared<chratos::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), request_id, response_handler));
 					handler->process_request ();
 				}
+				else if (this_l->request.method () == boost::beast::http::verb::get && this_l->request.target () == "/metrics")
+				{
+					// Statistics for Prometheus scrapers
+					this_l->write_result (this_l->node->stats.prometheus (), version, "text/plain; version=0.0.4");
+					boost::beast::http::async_write (this_l->stream, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+						this_l->stream.async_shutdown (std::bind (&chratos::rpc_connection_secure::on_shutdown, this_l, std::placeholders::_1));
+					});
+				}
 				else
 				{
 					error_response (response_handler, "Can only POST requests");
@@ -0,0 +1,732 @@
+#include <chratos/node/snapshot.hpp>
+
+#include <chratos/lib/blocks.hpp>
+#include <chratos/lib/utility.hpp>
+#include <chratos/node/lmdb.hpp>
+
+#include <blake2/blake2.h>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+std::string chratos::error_snapshot_messages::message (int ev) const
+{
+	switch (static_cast<chratos::error_snapshot> (ev))
+	{
+		case chratos::error_snapshot::generic:
+			return "Unknown error";
+		case chratos::error_snapshot::file_error:
+			return "Unable to read or write snapshot file";
+		case chratos::error_snapshot::invalid_header:
+			return "Not a ledger snapshot";
+		case chratos::error_snapshot::unsupported_version:
+			return "Unsupported snapshot version";
+		case chratos::error_snapshot::wrong_network:
+			return "Snapshot is for a different network";
+		case chratos::error_snapshot::invalid_data:
+			return "Snapshot contents are malformed or inconsistent";
+		case chratos::error_snapshot::checksum_mismatch:
+			return "Snapshot checksum mismatch";
+		case chratos::error_snapshot::invalid_signature:
+			return "Snapshot contains a block with an invalid signature";
+		case chratos::error_snapshot::store_not_empty:
+			return "Snapshots can only be imported in to an empty ledger";
+	}
+
+	return "Invalid error code";
+}
+
+namespace
+{
+std::array<uint8_t, 8> const snapshot_magic = { { 'c', 'h', 'r', 's', 'n', 'a', 'p', '\0' } };
+uint8_t const snapshot_version = 2;
+size_t const snapshot_buffer_size = 64 * 1024;
+size_t const snapshot_verify_batch = 2048;
+
+enum class snapshot_entry : uint8_t
+{
+	end = 0,
+	account = 1,
+	// Values 2 to 4 and 6 carried the pending, representation, block info and checksum tables in version 1
+	dividend = 5
+};
+
+/** Buffers writes to the snapshot file, hashing everything that passes through for the trailing checksum */
+class snapshot_writer : public chratos::stream
+{
+public:
+	snapshot_writer (std::ofstream & file_a) :
+	file (file_a),
+	buffer (snapshot_buffer_size)
+	{
+		blake2b_init (&hash, sizeof (chratos::uint256_union));
+		setp (buffer.data (), buffer.data () + buffer.size ());
+	}
+	chratos::uint256_union finish ()
+	{
+		sync ();
+		chratos::uint256_union result;
+		blake2b_final (&hash, result.bytes.data (), sizeof (result.bytes));
+		return result;
+	}
+
+protected:
+	int_type overflow (int_type value_a) override
+	{
+		auto result (sync () == 0 ? traits_type::not_eof (value_a) : traits_type::eof ());
+		if (!traits_type::eq_int_type (result, traits_type::eof ()) && !traits_type::eq_int_type (value_a, traits_type::eof ()))
+		{
+			*pptr () = traits_type::to_char_type (value_a);
+			pbump (1);
+		}
+		return result;
+	}
+	int sync () override
+	{
+		auto size (pptr () - pbase ());
+		blake2b_update (&hash, pbase (), size);
+		file.write (reinterpret_cast<char const *> (pbase ()), size);
+		setp (buffer.data (), buffer.data () + buffer.size ());
+		return file ? 0 : -1;
+	}
+
+private:
+	std::ofstream & file;
+	std::vector<uint8_t> buffer;
+	blake2b_state hash;
+};
+
+/** Reads the snapshot file up to its trailing checksum, hashing everything read */
+class snapshot_reader : public chratos::stream
+{
+public:
+	snapshot_reader (std::ifstream & file_a, uint64_t size_a) :
+	file (file_a),
+	remaining (size_a),
+	buffer (snapshot_buffer_size)
+	{
+		blake2b_init (&hash, sizeof (chratos::uint256_union));
+		setg (buffer.data (), buffer.data (), buffer.data ());
+	}
+	chratos::uint256_union finish ()
+	{
+		chratos::uint256_union result;
+		blake2b_final (&hash, result.bytes.data (), sizeof (result.bytes));
+		return result;
+	}
+
+protected:
+	int_type underflow () override
+	{
+		if (gptr () == egptr () && remaining > 0)
+		{
+			auto size (static_cast<size_t> (std::min<uint64_t> (remaining, buffer.size ())));
+			file.read (reinterpret_cast<char *> (buffer.data ()), size);
+			size = file.gcount ();
+			remaining = file ? remaining - size : 0;
+			blake2b_update (&hash, buffer.data (), size);
+			setg (buffer.data (), buffer.data (), buffer.data () + size);
+		}
+		return gptr () == egptr () ? traits_type::eof () : traits_type::to_int_type (*gptr ());
+	}
+
+private:
+	std::ifstream & file;
+	uint64_t remaining;
+	std::vector<uint8_t> buffer;
+	blake2b_state hash;
+};
+
+class snapshot_block
+{
+public:
+	chratos::block_hash hash;
+	std::unique_ptr<chratos::block> block;
+	chratos::block_hash successor;
+	chratos::account account;
+	chratos::epoch epoch;
+};
+
+bool valid_epoch (uint8_t epoch_a)
+{
+	return epoch_a == static_cast<uint8_t> (chratos::epoch::epoch_0) || epoch_a == static_cast<uint8_t> (chratos::epoch::epoch_1);
+}
+
+bool key_less (chratos::uint256_union const & lhs, chratos::uint256_union const & rhs)
+{
+	// Same order as LMDB's default byte comparison
+	return std::memcmp (lhs.bytes.data (), rhs.bytes.data (), sizeof (lhs.bytes)) < 0;
+}
+
+bool key_less (chratos::pending_key const & lhs, chratos::pending_key const & rhs)
+{
+	auto result (std::memcmp (lhs.account.bytes.data (), rhs.account.bytes.data (), sizeof (lhs.account.bytes)));
+	if (result == 0)
+	{
+		result = std::memcmp (lhs.hash.bytes.data (), rhs.hash.bytes.data (), sizeof (lhs.hash.bytes));
+	}
+	return result < 0;
+}
+
+/** Sorts entries by key for appending and reports whether any key appears twice */
+template <typename T, typename F>
+bool sort_unique (std::vector<T> & entries_a, F key_a)
+{
+	std::sort (entries_a.begin (), entries_a.end (), [&key_a](T const & lhs, T const & rhs) { return key_less (key_a (lhs), key_a (rhs)); });
+	auto duplicate (std::adjacent_find (entries_a.begin (), entries_a.end (), [&key_a](T const & lhs, T const & rhs) { return !key_less (key_a (lhs), key_a (rhs)); }));
+	return duplicate != entries_a.end ();
+}
+
+/**
+ * Reads an account and its chain, checking the blocks link from the open block to the head
+ * @return true on error
+ */
+bool read_account (chratos::stream & stream_a, std::vector<std::pair<chratos::account, chratos::account_info>> & accounts_a, std::vector<snapshot_block> & blocks_a)
+{
+	chratos::account account;
+	chratos::account_info info;
+	uint8_t epoch;
+	auto error (chratos::read (stream_a, account.bytes) || info.deserialize (stream_a) || chratos::read (stream_a, epoch) || !valid_epoch (epoch));
+	if (!error)
+	{
+		info.epoch = static_cast<chratos::epoch> (epoch);
+		chratos::block_hash previous (0);
+		uint64_t count (0);
+		auto done (false);
+		while (!error && !done)
+		{
+			chratos::block_type type;
+			error = chratos::read (stream_a, type);
+			if (!error)
+			{
+				if (type != chratos::block_type::not_a_block)
+				{
+					auto block (chratos::deserialize_block (stream_a, type));
+					error = block == nullptr || chratos::read (stream_a, epoch) || !valid_epoch (epoch);
+					if (!error)
+					{
+						auto block_epoch (static_cast<chratos::epoch> (epoch));
+						error = block->previous () != previous || (type != chratos::block_type::state && block_epoch != chratos::epoch::epoch_0);
+						if (!error)
+						{
+							auto hash (block->hash ());
+							if (count > 0)
+							{
+								blocks_a.back ().successor = hash;
+							}
+							else
+							{
+								error = hash != info.open_block;
+							}
+							blocks_a.push_back (snapshot_block{ hash, std::move (block), chratos::block_hash (0), account, block_epoch });
+							previous = hash;
+							++count;
+						}
+					}
+				}
+				else
+				{
+					done = true;
+				}
+			}
+		}
+		if (!error)
+		{
+			error = count == 0 || count != info.block_count || previous != info.head;
+			accounts_a.push_back (std::make_pair (account, info));
+		}
+	}
+	return error;
+}
+
+chratos::uint128_t block_balance (chratos::block const & block_a)
+{
+	chratos::uint128_t result (0);
+	switch (block_a.type ())
+	{
+		case chratos::block_type::state:
+			result = static_cast<chratos::state_block const &> (block_a).hashables.balance.number ();
+			break;
+		case chratos::block_type::dividend:
+			result = static_cast<chratos::dividend_block const &> (block_a).hashables.balance.number ();
+			break;
+		case chratos::block_type::claim:
+			result = static_cast<chratos::claim_block const &> (block_a).hashables.balance.number ();
+			break;
+		default:
+			assert (false);
+			break;
+	}
+	return result;
+}
+
+class snapshot_dividend
+{
+public:
+	chratos::block_hash previous;
+	chratos::uint128_t amount;
+	chratos::uint128_t claimed;
+};
+
+bool pending_less (std::pair<chratos::pending_key, chratos::pending_info> const & lhs, chratos::pending_key const & rhs)
+{
+	return key_less (lhs.first, rhs);
+}
+
+bool epoch_block (chratos::block const & block_a, chratos::uint256_union const & epoch_link_a)
+{
+	return block_a.type () == chratos::block_type::state && !epoch_link_a.is_zero () && block_a.link () == epoch_link_a;
+}
+
+/**
+ * Replays every chain the way the ledger processes blocks, deriving the pending, representation, block info and
+ * dividend tables along with the checksum. Chains are stored in account order rather than the order their blocks were
+ * processed so sends and dividends are collected in a first pass. In the second every receive has to consume a send
+ * of the same amount to that account exactly once, and every claim has to follow the account's last claimed dividend
+ * with the claims on a dividend adding up to no more than was paid in to it. The exact share owed by a claim depends on
+ * ledger state at the time it was processed, which the chains alone don't give, so claims are only bounded
+ * @return true if a block or account disagrees with the replay
+ */
+bool rebuild_tables (std::vector<std::pair<chratos::account, chratos::account_info>> const & accounts_a, std::vector<snapshot_block> const & blocks_a, chratos::block_hash const & genesis_a, chratos::uint256_union const & epoch_link_a, std::vector<std::pair<chratos::pending_key, chratos::pending_info>> & pending_a, std::vector<std::pair<chratos::account, chratos::uint128_union>> & representation_a, std::vector<std::pair<chratos::block_hash, chratos::block_info>> & blocks_info_a, chratos::dividend_info & dividend_a, chratos::checksum & checksum_a)
+{
+	auto error (false);
+	std::unordered_map<chratos::block_hash, snapshot_dividend> dividends;
+	chratos::dividend_info dividend_l;
+	dividend_l.modified = dividend_a.modified;
+	// read_account stored each chain contiguously from its open block
+	auto entry (blocks_a.begin ());
+	for (auto i (accounts_a.begin ()), n (accounts_a.end ()); i != n && !error; ++i)
+	{
+		chratos::uint128_t balance (0);
+		for (uint64_t count (0); count < i->second.block_count && !error; ++count, ++entry)
+		{
+			assert (entry != blocks_a.end () && entry->account == i->first);
+			auto & block (*entry->block);
+			auto balance_l (block_balance (block));
+			if (block.type () == chratos::block_type::state && balance_l < balance && !epoch_block (block, epoch_link_a))
+			{
+				pending_a.push_back (std::make_pair (chratos::pending_key (block.link (), entry->hash), chratos::pending_info (i->first, balance - balance_l, block.dividend (), entry->epoch)));
+			}
+			else if (block.type () == chratos::block_type::dividend)
+			{
+				// Only the dividend account pays dividends, each one following the last
+				error = i->first != chratos::dividend_account || block.dividend () != dividend_l.head || balance_l >= balance || balance - balance_l <= chratos::minimum_dividend_amount;
+				if (!error)
+				{
+					dividends[entry->hash] = snapshot_dividend{ block.dividend (), balance - balance_l, 0 };
+					dividend_l = chratos::dividend_info (entry->hash, dividend_l.balance.number () + (balance - balance_l), dividend_a.modified, dividend_l.block_count + 1, chratos::epoch::epoch_0);
+				}
+			}
+			balance = balance_l;
+		}
+	}
+	if (!error)
+	{
+		// The modification time is the only part of the dividend table kept from the file
+		error = dividend_a.head != dividend_l.head || dividend_a.balance != dividend_l.balance || dividend_a.block_count != dividend_l.block_count;
+		dividend_a = dividend_l;
+	}
+	std::sort (pending_a.begin (), pending_a.end (), [](std::pair<chratos::pending_key, chratos::pending_info> const & lhs, std::pair<chratos::pending_key, chratos::pending_info> const & rhs) { return key_less (lhs.first, rhs.first); });
+	std::vector<bool> received (pending_a.size (), false);
+	std::unordered_map<chratos::account, chratos::uint128_t> weights;
+	checksum_a.clear ();
+	entry = blocks_a.begin ();
+	for (auto i (accounts_a.begin ()), n (accounts_a.end ()); i != n && !error; ++i)
+	{
+		auto & account (i->first);
+		auto & info (i->second);
+		chratos::uint128_t balance (0);
+		chratos::block_hash rep_block (0);
+		chratos::account representative (0);
+		chratos::epoch epoch (chratos::epoch::epoch_0);
+		chratos::block_hash dividend (0);
+		for (uint64_t count (1); count <= info.block_count && !error; ++count, ++entry)
+		{
+			auto & block (*entry->block);
+			auto balance_l (block_balance (block));
+			auto state (block.type () == chratos::block_type::state);
+			if (count == 1)
+			{
+				dividend = block.dividend ();
+			}
+			if (epoch_block (block, epoch_link_a))
+			{
+				// Epoch blocks keep the balance and weight where they are
+				error = balance_l != balance;
+			}
+			else
+			{
+				if (!rep_block.is_zero ())
+				{
+					weights[representative] -= balance;
+				}
+				weights[block.representative ()] += balance_l;
+				if (state && balance_l < balance)
+				{
+					// Collected in the first pass
+				}
+				else if (state && !block.link ().is_zero () && entry->hash != genesis_a)
+				{
+					chratos::pending_key key (account, block.link ());
+					auto existing (std::lower_bound (pending_a.begin (), pending_a.end (), key, pending_less));
+					auto index (existing - pending_a.begin ());
+					error = existing == pending_a.end () || !(existing->first == key) || received[index] || existing->second.amount.number () != balance_l - balance;
+					if (!error)
+					{
+						received[index] = true;
+					}
+				}
+				else if (state)
+				{
+					// Without a source only the representative can change, the genesis block is the one open without a send
+					error = balance_l != balance && entry->hash != genesis_a;
+				}
+				else if (block.type () == chratos::block_type::claim)
+				{
+					auto existing (dividends.find (block.dividend ()));
+					error = existing == dividends.end () || existing->second.previous != dividend || balance_l < balance || balance_l - balance > existing->second.amount - existing->second.claimed;
+					if (!error)
+					{
+						existing->second.claimed += balance_l - balance;
+						dividend = block.dividend ();
+					}
+				}
+			}
+			if (state)
+			{
+				rep_block = entry->hash;
+				representative = block.representative ();
+			}
+			else if (count % chratos::block_store::block_info_max == 0)
+			{
+				blocks_info_a.push_back (std::make_pair (entry->hash, chratos::block_info (account, balance_l)));
+			}
+			balance = balance_l;
+			epoch = entry->epoch;
+		}
+		checksum_a ^= info.head;
+		error = error || info.balance.number () != balance || info.rep_block != rep_block || info.epoch != epoch || info.dividend_block != dividend;
+	}
+	if (!error)
+	{
+		size_t kept (0);
+		for (size_t j (0), m (pending_a.size ()); j < m; ++j)
+		{
+			if (!received[j])
+			{
+				pending_a[kept++] = pending_a[j];
+			}
+		}
+		pending_a.erase (pending_a.begin () + kept, pending_a.end ());
+		for (auto & weight : weights)
+		{
+			if (weight.second != 0)
+			{
+				representation_a.push_back (std::make_pair (weight.first, chratos::uint128_union (weight.second)));
+			}
+		}
+	}
+	return error;
+}
+
+/**
+ * Verifies block signatures in batches shared out across threads. Blocks failing against their account are
+ * retried against the epoch signer when their link marks them as an epoch block
+ * @return true if any signature is invalid
+ */
+bool verify_signatures (std::vector<snapshot_block> const & blocks_a, chratos::uint256_union const & epoch_link_a, chratos::account const & epoch_signer_a, unsigned threads_a)
+{
+	std::atomic<size_t> next (0);
+	std::atomic<bool> invalid (false);
+	auto verify ([&blocks_a, &epoch_link_a, &epoch_signer_a, &next, &invalid]() {
+		std::vector<chratos::signature> signatures;
+		std::vector<unsigned char const *> messages;
+		std::vector<size_t> lengths;
+		std::vector<unsigned char const *> pub_keys;
+		std::vector<unsigned char const *> signature_pointers;
+		std::vector<int> verifications;
+		for (auto begin (next.fetch_add (snapshot_verify_batch)); begin < blocks_a.size () && !invalid; begin = next.fetch_add (snapshot_verify_batch))
+		{
+			auto end (std::min (begin + snapshot_verify_batch, blocks_a.size ()));
+			auto size (end - begin);
+			signatures.clear ();
+			messages.clear ();
+			pub_keys.clear ();
+			signature_pointers.clear ();
+			lengths.assign (size, sizeof (chratos::block_hash));
+			verifications.assign (size, 0);
+			for (auto i (begin); i < end; ++i)
+			{
+				signatures.push_back (blocks_a[i].block->block_signature ());
+				messages.push_back (blocks_a[i].hash.bytes.data ());
+				pub_keys.push_back (blocks_a[i].account.bytes.data ());
+			}
+			for (auto & signature : signatures)
+			{
+				signature_pointers.push_back (signature.bytes.data ());
+			}
+			chratos::validate_message_batch (messages.data (), lengths.data (), pub_keys.data (), signature_pointers.data (), size, verifications.data ());
+			for (size_t i (0); i < size && !invalid; ++i)
+			{
+				if (verifications[i] != 1)
+				{
+					auto & entry (blocks_a[begin + i]);
+					auto epoch_block (entry.block->type () == chratos::block_type::state && static_cast<chratos::state_block const &> (*entry.block).hashables.link == epoch_link_a);
+					if (!epoch_block || chratos::validate_message (epoch_signer_a, entry.hash, signatures[i]))
+					{
+						invalid = true;
+					}
+				}
+			}
+		}
+	});
+	std::vector<boost::thread> workers;
+	for (unsigned i (1); i < threads_a; ++i)
+	{
+		workers.push_back (boost::thread (verify));
+	}
+	verify ();
+	for (auto & worker : workers)
+	{
+		worker.join ();
+	}
+	return invalid;
+}
+}
+
+std::error_code chratos::snapshot_export (chratos::block_store & store_a, boost::filesystem::path const & path_a)
+{
+	std::error_code result;
+	std::ofstream file (path_a.string (), std::ios::binary | std::ios::trunc);
+	if (file)
+	{
+		snapshot_writer stream (file);
+		chratos::write (stream, snapshot_magic);
+		chratos::write (stream, snapshot_version);
+		chratos::write (stream, static_cast<uint8_t> (chratos::chratos_network));
+		auto transaction (store_a.tx_begin_read ());
+		for (auto i (store_a.latest_begin (transaction)), n (store_a.latest_end ()); i != n && !result; ++i)
+		{
+			chratos::account account (i->first);
+			chratos::account_info info (i->second);
+			chratos::write (stream, snapshot_entry::account);
+			chratos::write (stream, account.bytes);
+			info.serialize (stream);
+			chratos::write (stream, static_cast<uint8_t> (info.epoch));
+			// Walking forward from the open block puts every block after its predecessor
+			for (auto hash (info.open_block); !hash.is_zero () && !result; hash = store_a.block_successor (transaction, hash))
+			{
+				auto block (store_a.block_get (transaction, hash));
+				if (block != nullptr)
+				{
+					chratos::serialize_block (stream, *block);
+					chratos::write (stream, static_cast<uint8_t> (store_a.block_version (transaction, hash)));
+				}
+				else
+				{
+					result = chratos::error_snapshot::invalid_data;
+				}
+			}
+			chratos::write (stream, chratos::block_type::not_a_block);
+		}
+		auto dividend (store_a.dividend_get (transaction));
+		chratos::write (stream, snapshot_entry::dividend);
+		dividend.serialize (stream);
+		chratos::write (stream, snapshot_entry::end);
+		auto hash (stream.finish ());
+		file.write (reinterpret_cast<char const *> (hash.bytes.data ()), sizeof (hash.bytes));
+		file.flush ();
+		if (!result && !file)
+		{
+			result = chratos::error_snapshot::file_error;
+		}
+	}
+	else
+	{
+		result = chratos::error_snapshot::file_error;
+	}
+	return result;
+}
+
+std::error_code chratos::snapshot_import (chratos::mdb_store & store_a, boost::filesystem::path const & path_a, chratos::uint256_union const & epoch_link_a, chratos::account const & epoch_signer_a, unsigned threads_a)
+{
+	std::error_code result;
+	std::vector<std::pair<chratos::account, chratos::account_info>> accounts;
+	std::vector<snapshot_block> blocks;
+	std::vector<std::pair<chratos::pending_key, chratos::pending_info>> pending;
+	std::vector<std::pair<chratos::account, chratos::uint128_union>> representation;
+	std::vector<std::pair<chratos::block_hash, chratos::block_info>> blocks_info;
+	chratos::dividend_info dividend;
+	auto has_dividend (false);
+	chratos::checksum checksum;
+	boost::system::error_code size_error;
+	auto size (boost::filesystem::file_size (path_a, size_error));
+	std::ifstream file (path_a.string (), std::ios::binary);
+	if (!size_error && file)
+	{
+		if (size > sizeof (snapshot_magic) + sizeof (chratos::uint256_union))
+		{
+			snapshot_reader stream (file, size - sizeof (chratos::uint256_union));
+			std::array<uint8_t, 8> magic;
+			uint8_t version;
+			uint8_t network;
+			if (chratos::read (stream, magic) || magic != snapshot_magic)
+			{
+				result = chratos::error_snapshot::invalid_header;
+			}
+			else if (chratos::read (stream, version) || version != snapshot_version)
+			{
+				result = chratos::error_snapshot::unsupported_version;
+			}
+			else if (chratos::read (stream, network) || network != static_cast<uint8_t> (chratos::chratos_network))
+			{
+				result = chratos::error_snapshot::wrong_network;
+			}
+			auto done (false);
+			while (!result && !done)
+			{
+				snapshot_entry entry;
+				auto error (chratos::read (stream, entry));
+				if (!error)
+				{
+					switch (entry)
+					{
+						case snapshot_entry::account:
+							error = read_account (stream, accounts, blocks);
+							break;
+						case snapshot_entry::dividend:
+						{
+							error = has_dividend || dividend.deserialize (stream);
+							has_dividend = true;
+							break;
+						}
+						case snapshot_entry::end:
+							// Nothing may follow the end entry besides the checksum
+							error = !chratos::stream::traits_type::eq_int_type (stream.sgetc (), chratos::stream::traits_type::eof ());
+							done = true;
+							break;
+						default:
+							error = true;
+							break;
+					}
+				}
+				if (error)
+				{
+					result = chratos::error_snapshot::invalid_data;
+				}
+			}
+			if (!result)
+			{
+				chratos::uint256_union expected;
+				file.read (reinterpret_cast<char *> (expected.bytes.data ()), sizeof (expected.bytes));
+				if (!file || expected != stream.finish ())
+				{
+					result = chratos::error_snapshot::checksum_mismatch;
+				}
+			}
+		}
+		else
+		{
+			result = chratos::error_snapshot::invalid_header;
+		}
+	}
+	else
+	{
+		result = chratos::error_snapshot::file_error;
+	}
+	if (!result && verify_signatures (blocks, epoch_link_a, epoch_signer_a, std::max (1U, threads_a)))
+	{
+		result = chratos::error_snapshot::invalid_signature;
+	}
+	if (!result && rebuild_tables (accounts, blocks, chratos::genesis ().hash (), epoch_link_a, pending, representation, blocks_info, dividend, checksum))
+	{
+		result = chratos::error_snapshot::invalid_data;
+	}
+	if (!result)
+	{
+		// MDB_APPEND requires each table's keys in ascending order, a repeated key would be rejected mid-load so it's caught here
+		std::atomic<bool> duplicate (false);
+		std::vector<boost::thread> sorters;
+		sorters.push_back (boost::thread ([&blocks, &duplicate]() {
+			if (sort_unique (blocks, [](snapshot_block const & entry_a) -> chratos::uint256_union const & { return entry_a.hash; }))
+			{
+				duplicate = true;
+			}
+		}));
+		sorters.push_back (boost::thread ([&accounts, &duplicate]() {
+			if (sort_unique (accounts, [](std::pair<chratos::account, chratos::account_info> const & entry_a) -> chratos::uint256_union const & { return entry_a.first; }))
+			{
+				duplicate = true;
+			}
+		}));
+		sorters.push_back (boost::thread ([&pending, &duplicate]() {
+			if (sort_unique (pending, [](std::pair<chratos::pending_key, chratos::pending_info> const & entry_a) -> chratos::pending_key const & { return entry_a.first; }))
+			{
+				duplicate = true;
+			}
+		}));
+		sorters.push_back (boost::thread ([&representation, &duplicate]() {
+			if (sort_unique (representation, [](std::pair<chratos::account, chratos::uint128_union> const & entry_a) -> chratos::uint256_union const & { return entry_a.first; }))
+			{
+				duplicate = true;
+			}
+		}));
+		sorters.push_back (boost::thread ([&blocks_info, &duplicate]() {
+			if (sort_unique (blocks_info, [](std::pair<chratos::block_hash, chratos::block_info> const & entry_a) -> chratos::uint256_union const & { return entry_a.first; }))
+			{
+				duplicate = true;
+			}
+		}));
+		for (auto & sorter : sorters)
+		{
+			sorter.join ();
+		}
+		if (duplicate)
+		{
+			result = chratos::error_snapshot::invalid_data;
+		}
+	}
+	if (!result)
+	{
+		auto transaction (store_a.tx_begin_write ());
+		auto empty (store_a.latest_begin (transaction) == store_a.latest_end () && store_a.block_count (transaction).sum () == 0 && store_a.pending_begin (transaction) == store_a.pending_end () && store_a.representation_begin (transaction) == store_a.representation_end () && store_a.block_info_begin (transaction) == store_a.block_info_end ());
+		if (empty)
+		{
+			for (auto & entry : blocks)
+			{
+				store_a.block_append (transaction, entry.hash, *entry.block, entry.successor, entry.epoch);
+			}
+			for (auto & entry : accounts)
+			{
+				auto status (mdb_put (store_a.env.tx (transaction), entry.second.epoch == chratos::epoch::epoch_0 ? store_a.accounts_v0 : store_a.accounts_v1, chratos::mdb_val (entry.first), chratos::mdb_val (entry.second), MDB_APPEND));
+				release_assert (status == 0);
+			}
+			for (auto & entry : pending)
+			{
+				auto status (mdb_put (store_a.env.tx (transaction), entry.second.epoch == chratos::epoch::epoch_0 ? store_a.pending_v0 : store_a.pending_v1, chratos::mdb_val (entry.first), chratos::mdb_val (entry.second), MDB_APPEND));
+				release_assert (status == 0);
+			}
+			for (auto & entry : representation)
+			{
+				auto status (mdb_put (store_a.env.tx (transaction), store_a.representation, chratos::mdb_val (entry.first), chratos::mdb_val (entry.second), MDB_APPEND));
+				release_assert (status == 0);
+			}
+			for (auto & entry : blocks_info)
+			{
+				auto status (mdb_put (store_a.env.tx (transaction), store_a.blocks_info, chratos::mdb_val (entry.first), chratos::mdb_val (entry.second), MDB_APPEND));
+				release_assert (status == 0);
+			}
+			store_a.dividend_put (transaction, dividend);
+			store_a.checksum_put (transaction, 0, 0, checksum);
+		}
+		else
+		{
+			result = chratos::error_snapshot::store_not_empty;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chratos/lib/errors.hpp>
+#include <chratos/lib/numbers.hpp>
+
+#include <boost/filesystem.hpp>
+
+namespace chratos
+{
+class block_store;
+class mdb_store;
+
+/** Ledger snapshot related error codes */
+enum class error_snapshot
+{
+	generic = 1,
+	file_error,
+	invalid_header,
+	unsupported_version,
+	wrong_network,
+	invalid_data,
+	checksum_mismatch,
+	invalid_signature,
+	store_not_empty
+};
+
+/**
+ * Writes the ledger to a versioned snapshot file for provisioning nodes without a network bootstrap.
+ * After the header every account is written with its chain from the open block to the head, followed by the
+ * dividend table. Tables derived from the blocks aren't written. The file ends with a blake2b checksum of everything before it
+ */
+std::error_code snapshot_export (chratos::block_store &, boost::filesystem::path const &);
+
+/**
+ * Loads a snapshot into an empty store.
+ * The file is checked and block signatures are verified in batches across the given number of threads, then the
+ * pending, representation, block info and dividend tables and the ledger checksum are rebuilt by replaying the chains.
+ * Every receive must consume a matching send and claims are bounded by their dividend, and the replay must agree with
+ * every account's balance, representative block, dividend and epoch. Only then is each table sorted and bulk
+ * loaded in key order within a single transaction. Signatures don't show the chains are complete or confirmed so
+ * snapshots should only be imported from a trusted source
+ */
+std::error_code snapshot_import (chratos::mdb_store &, boost::filesystem::path const &, chratos::uint256_union const & epoch_link, chratos::account const & epoch_signer, unsigned threads);
+}
+
+REGISTER_ERROR_CODES (chratos, error_snapshot)
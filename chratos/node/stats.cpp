@@ -3,12 +3,28 @@
 #include <boost/asio.hpp>
 #include <boost/format.hpp>
 #include <boost/property_tree/json_parser.hpp>
+#include <cmath>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <tuple>
 
+size_t constexpr chratos::stat::type_count;
+size_t constexpr chratos::stat::detail_count;
+size_t constexpr chratos::stat::dir_count;
+size_t constexpr chratos::stat::counter_count;
+size_t constexpr chratos::stat::shard_count;
+size_t constexpr chratos::stat::shard_stride;
+size_t constexpr chratos::stat::stage_count;
+size_t constexpr chratos::stat_histogram::sub_buckets;
+size_t constexpr chratos::stat_histogram::bucket_count;
+
+namespace
+{
+std::atomic<size_t> next_shard (0);
+}
+
 bool chratos::stat_config::deserialize_json (boost::property_tree::ptree & tree_a)
 {
 	bool error = false;
@@ -38,6 +54,80 @@ bool chratos::stat_config::deserialize_json (boost::property_tree::ptree & tree_
 	return error;
 }
 
+size_t chratos::stat_histogram::bucket_of (uint64_t value_a)
+{
+	size_t result (value_a);
+	if (value_a >= sub_buckets)
+	{
+		// Position of the highest set bit picks the power of two range, the two bits below it the bucket within
+		size_t power (63 - __builtin_clzll (value_a));
+		result = (power - 1) * sub_buckets + (value_a >> (power - 2) & (sub_buckets - 1));
+	}
+	return result;
+}
+
+uint64_t chratos::stat_histogram::bucket_upper (size_t bucket_a)
+{
+	uint64_t result (bucket_a);
+	if (bucket_a >= sub_buckets)
+	{
+		auto power (bucket_a / sub_buckets + 1);
+		auto width (uint64_t (1) << (power - 2));
+		result = (sub_buckets + bucket_a % sub_buckets) * width + width - 1;
+	}
+	return result;
+}
+
+void chratos::stat_histogram::add (uint64_t value_a, uint64_t count_a)
+{
+	buckets[bucket_of (value_a)].fetch_add (count_a, std::memory_order_relaxed);
+	total.fetch_add (count_a, std::memory_order_relaxed);
+	sum_l.fetch_add (value_a * count_a, std::memory_order_relaxed);
+	auto max_current (max_l.load (std::memory_order_relaxed));
+	while (value_a > max_current && !max_l.compare_exchange_weak (max_current, value_a, std::memory_order_relaxed))
+	{
+	}
+}
+
+uint64_t chratos::stat_histogram::count () const
+{
+	return total.load (std::memory_order_relaxed);
+}
+
+uint64_t chratos::stat_histogram::sum () const
+{
+	return sum_l.load (std::memory_order_relaxed);
+}
+
+uint64_t chratos::stat_histogram::max () const
+{
+	return max_l.load (std::memory_order_relaxed);
+}
+
+uint64_t chratos::stat_histogram::percentile (double fraction_a) const
+{
+	uint64_t result (0);
+	std::array<uint64_t, bucket_count> counts;
+	uint64_t total_l (0);
+	for (size_t i (0); i < bucket_count; ++i)
+	{
+		counts[i] = buckets[i].load (std::memory_order_relaxed);
+		total_l += counts[i];
+	}
+	if (total_l > 0)
+	{
+		auto rank (std::max<uint64_t> (1, static_cast<uint64_t> (std::ceil (fraction_a * total_l))));
+		uint64_t seen (0);
+		size_t bucket (0);
+		for (; bucket < bucket_count - 1 && seen + counts[bucket] < rank; ++bucket)
+		{
+			seen += counts[bucket];
+		}
+		result = std::min (bucket_upper (bucket), max ());
+	}
+	return result;
+}
+
 std::string chratos::stat_log_sink::tm_to_string (tm & tm)
 {
 	return (boost::format ("%04d.%02d.%02d %02d:%02d:%02d") % (1900 + tm.tm_year) % (tm.tm_mon + 1) % tm.tm_mday % tm.tm_hour % tm.tm_min % tm.tm_sec).str ();
@@ -202,16 +292,20 @@ void chratos::stat::log_counters_impl (stat_log_sink & sink)
 		sink.write_header ("counters", walltime);
 	}
 
-	for (auto & it : entries)
+	// Counters are summed at writeout so they all carry its time
+	std::time_t time = std::chrono::system_clock::to_time_t (std::chrono::system_clock::now ());
+	tm local_tm = *localtime (&time);
+	for (size_t index (0); index < counter_count; ++index)
 	{
-		std::time_t time = std::chrono::system_clock::to_time_t (it.second->counter.timestamp);
-		tm local_tm = *localtime (&time);
-
-		auto key = it.first;
-		std::string type = type_to_string (key);
-		std::string detail = detail_to_string (key);
-		std::string dir = dir_to_string (key);
-		sink.write_entry (local_tm, type, detail, dir, it.second->counter.value);
+		auto key = key_of_index (index);
+		auto value (count (index));
+		if (value != 0 || entries.find (key) != entries.end ())
+		{
+			std::string type = type_to_string (key);
+			std::string detail = detail_to_string (key);
+			std::string dir = dir_to_string (key);
+			sink.write_entry (local_tm, type, detail, dir, value);
+		}
 	}
 	sink.entries ()++;
 	sink.finalize ();
@@ -255,7 +349,29 @@ void chratos::stat::log_samples_impl (stat_log_sink & sink)
 	sink.finalize ();
 }
 
+uint64_t chratos::stat::count (size_t index_a)
+{
+	uint64_t result (0);
+	for (size_t shard (0); shard < shard_count; ++shard)
+	{
+		result += counters[shard * shard_stride + index_a].load (std::memory_order_relaxed);
+	}
+	return result;
+}
+
 void chratos::stat::update (uint32_t key_a, uint64_t value)
+{
+	// Threads are spread over the shards in the order they first update a stat
+	static thread_local size_t shard (next_shard++ % shard_count);
+	auto index (index_of (key_a));
+	counters[shard * shard_stride + index].fetch_add (value, std::memory_order_relaxed);
+	if (config.sampling_enabled || config.log_interval_counters > 0 || observed[index].load (std::memory_order_relaxed))
+	{
+		update_locked (key_a, value);
+	}
+}
+
+void chratos::stat::update_locked (uint32_t key_a, uint64_t value)
 {
 	static file_writer log_count (config.log_counters_filename);
 	static file_writer log_sample (config.log_samples_filename);
@@ -266,9 +382,11 @@ void chratos::stat::update (uint32_t key_a, uint64_t value)
 	auto entry (get_entry_impl (key_a, config.interval, config.capacity));
 
 	// Counters
-	auto old (entry->counter.value);
-	entry->counter.add (value);
-	entry->count_observers.notify (old, entry->counter.value);
+	if (!entry->count_observers.observers.empty ())
+	{
+		auto current (count (index_of (key_a)));
+		entry->count_observers.notify (current - value, current);
+	}
 
 	std::chrono::duration<double, std::milli> duration = now - log_last_count_writeout;
 	if (config.log_interval_counters > 0 && duration.count () > config.log_interval_counters)
@@ -309,6 +427,44 @@ void chratos::stat::update (uint32_t key_a, uint64_t value)
 	}
 }
 
+std::string chratos::stat::prometheus ()
+{
+	std::ostringstream result;
+	result << "# TYPE chratos_stat_counter counter\n";
+	for (size_t index (0); index < counter_count; ++index)
+	{
+		auto value (count (index));
+		if (value != 0)
+		{
+			auto key (key_of_index (index));
+			result << "chratos_stat_counter{type=\"" << type_to_string (key) << "\",detail=\"" << detail_to_string (key) << "\",dir=\"" << dir_to_string (key) << "\"} " << value << "\n";
+		}
+	}
+	result << "# TYPE chratos_stat_latency_microseconds summary\n";
+	for (size_t i (0); i < stage_count; ++i)
+	{
+		auto stage (stage_to_string (static_cast<stat::stage> (i)));
+		auto & histogram (histograms[i]);
+		for (auto quantile : { 0.5, 0.9, 0.99 })
+		{
+			result << "chratos_stat_latency_microseconds{stage=\"" << stage << "\",quantile=\"" << quantile << "\"} " << histogram.percentile (quantile) << "\n";
+		}
+		result << "chratos_stat_latency_microseconds_sum{stage=\"" << stage << "\"} " << histogram.sum () << "\n";
+		result << "chratos_stat_latency_microseconds_count{stage=\"" << stage << "\"} " << histogram.count () << "\n";
+	}
+	std::unique_lock<std::mutex> lock (stat_mutex);
+	result << "# TYPE chratos_stat_sample gauge\n";
+	for (auto & it : entries)
+	{
+		if (!it.second->samples.empty ())
+		{
+			auto key (it.first);
+			result << "chratos_stat_sample{type=\"" << type_to_string (key) << "\",detail=\"" << detail_to_string (key) << "\",dir=\"" << dir_to_string (key) << "\"} " << it.second->samples.back ().value << "\n";
+		}
+	}
+	return result.str ();
+}
+
 std::string chratos::stat::type_to_string (uint32_t key)
 {
 	auto type = static_cast<stat::type> (key >> 16 & 0x000000ff);
@@ -348,6 +504,12 @@ std::string chratos::stat::type_to_string (uint32_t key)
 		case chratos::stat::type::message:
 			res = "message";
 			break;
+		case chratos::stat::type::filter:
+			res = "filter";
+			break;
+		case chratos::stat::type::unchecked:
+			res = "unchecked";
+			break;
 	}
 	return res;
 }
@@ -403,6 +565,9 @@ std::string chratos::stat::detail_to_string (uint32_t key)
 		case chratos::stat::detail::initiate:
 			res = "initiate";
 			break;
+		case chratos::stat::detail::initiate_lazy:
+			res = "initiate_lazy";
+			break;
 		case chratos::stat::detail::insufficient_work:
 			res = "insufficient_work";
 			break;
@@ -439,6 +604,9 @@ std::string chratos::stat::detail_to_string (uint32_t key)
 		case chratos::stat::detail::vote_invalid:
 			res = "vote_invalid";
 			break;
+		case chratos::stat::detail::generator_overflow:
+			res = "generator_overflow";
+			break;
 		case chratos::stat::detail::blocking:
 			res = "blocking";
 			break;
@@ -478,6 +646,48 @@ std::string chratos::stat::detail_to_string (uint32_t key)
 		case chratos::stat::detail::outdated_version:
 			res = "outdated_version";
 			break;
+		case chratos::stat::detail::hit:
+			res = "hit";
+			break;
+		case chratos::stat::detail::miss:
+			res = "miss";
+			break;
+		case chratos::stat::detail::put:
+			res = "put";
+			break;
+		case chratos::stat::detail::duplicate:
+			res = "duplicate";
+			break;
+		case chratos::stat::detail::evicted:
+			res = "evicted";
+			break;
+	}
+	return res;
+}
+
+std::string chratos::stat::stage_to_string (stat::stage stage)
+{
+	std::string res;
+	switch (stage)
+	{
+		case chratos::stat::stage::block_queue:
+			res = "block_queue";
+			break;
+		case chratos::stat::stage::block_verify:
+			res = "block_verify";
+			break;
+		case chratos::stat::stage::block_process:
+			res = "block_process";
+			break;
+		case chratos::stat::stage::block_confirm:
+			res = "block_confirm";
+			break;
+		case chratos::stat::stage::vote_queue:
+			res = "vote_queue";
+			break;
+		case chratos::stat::stage::vote_process:
+			res = "vote_process";
+			break;
 	}
 	return res;
 }
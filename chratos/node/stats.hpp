@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <boost/circular_buffer.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -94,9 +95,6 @@ public:
 	/** Value within the current sample interval */
 	stat_datapoint sample_current;
 
-	/** Counting value for this entry, including the time of last update. This is never reset and only increases. */
-	stat_datapoint counter;
-
 	/** Zero or more observers for samples. Called at the end of the sample interval. */
 	chratos::observer_set<boost::circular_buffer<stat_datapoint> &> sample_observers;
 
@@ -104,6 +102,32 @@ public:
 	chratos::observer_set<uint64_t, uint64_t> count_observers;
 };
 
+/**
+ * Latency histogram with fixed buckets, values are microseconds.
+ * Below 4 each value has its own bucket, above that every power of two range is split into 4 buckets so a
+ * reported percentile is at most 25% above the true value. Updates are relaxed atomic adds
+ */
+class stat_histogram
+{
+public:
+	void add (uint64_t value, uint64_t count = 1);
+	uint64_t count () const;
+	uint64_t sum () const;
+	uint64_t max () const;
+	/** Upper bound of the bucket holding the given fraction of values, 0 when empty */
+	uint64_t percentile (double) const;
+	static size_t bucket_of (uint64_t);
+	static uint64_t bucket_upper (size_t);
+	static size_t constexpr sub_buckets = 4;
+	static size_t constexpr bucket_count = 64 * sub_buckets;
+
+private:
+	std::array<std::atomic<uint64_t>, bucket_count> buckets {};
+	std::atomic<uint64_t> total { 0 };
+	std::atomic<uint64_t> sum_l { 0 };
+	std::atomic<uint64_t> max_l { 0 };
+};
+
 /** Log sink interface */
 class stat_log_sink
 {
@@ -168,6 +192,9 @@ protected:
  * Collects counts and samples for inbound and outbound traffic, blocks, errors, and so on.
  * Stats can be queried and observed on a type level (such as message and ledger) as well as a more
  * specific detail level (such as send blocks)
+ *
+ * Counters are sharded by thread and updated with relaxed atomic adds, shards are only summed when a count is read.
+ * The mutex is taken on update only when sampling, counter logging or an observer needs it
  */
 class stat
 {
@@ -185,7 +212,9 @@ public:
 		vote,
 		http_callback,
 		peering,
-		udp
+		udp,
+		filter,
+		unchecked
 	};
 
 	/** Optional detail type */
@@ -219,6 +248,7 @@ public:
 
 		// bootstrap, callback
 		initiate,
+		initiate_lazy,
 
 		// bootstrap specific
 		bulk_pull,
@@ -230,6 +260,7 @@ public:
 		vote_valid,
 		vote_replay,
 		vote_invalid,
+		generator_overflow,
 
 		// udp
 		blocking,
@@ -247,6 +278,15 @@ public:
 
 		// peering
 		handshake,
+
+		// duplicate message filter
+		hit,
+		miss,
+
+		// unchecked
+		put,
+		duplicate,
+		evicted,
 	};
 
 	/** Direction of the stat. If the direction is irrelevant, use in */
@@ -256,6 +296,33 @@ public:
 		out
 	};
 
+	/** Pipeline stages with latency histograms */
+	enum class stage : uint8_t
+	{
+		// From UDP arrival to being taken from the block processor queue, including signature verification
+		block_queue,
+		// Batch signature verification of state blocks, recorded once for each block in the batch
+		block_verify,
+		// ledger.process of a single block
+		block_process,
+		// From UDP arrival to confirmation
+		block_confirm,
+		// From arrival to being taken from the vote processor queue
+		vote_queue,
+		// vote_blocking of a single vote
+		vote_process
+	};
+
+	/** Number of values of each key component, these follow the last enumerator of each enum */
+	static size_t constexpr type_count = static_cast<size_t> (type::unchecked) + 1;
+	static size_t constexpr detail_count = static_cast<size_t> (detail::evicted) + 1;
+	static size_t constexpr dir_count = static_cast<size_t> (dir::out) + 1;
+	static size_t constexpr counter_count = type_count * detail_count * dir_count;
+	static size_t constexpr shard_count = 16;
+	/** Counters per shard, rounded up and padded by a cache line so neighbouring shards don't share one */
+	static size_t constexpr shard_stride = (counter_count + 7) / 8 * 8 + 8;
+	static size_t constexpr stage_count = static_cast<size_t> (stage::vote_process) + 1;
+
 	/** Constructor using the default config values */
 	stat ()
 	{
@@ -342,6 +409,7 @@ public:
 	inline void observe_sample (stat::type type, stat::detail detail, stat::dir dir, std::function<void(boost::circular_buffer<stat_datapoint> &)> observer)
 	{
 		get_entry (key_of (type, detail, dir))->sample_observers.add (observer);
+		observed[index_of (key_of (type, detail, dir))] = true;
 	}
 
 	inline void observe_sample (stat::type type, stat::dir dir, std::function<void(boost::circular_buffer<stat_datapoint> &)> observer)
@@ -357,6 +425,7 @@ public:
 	inline void observe_count (stat::type type, stat::detail detail, stat::dir dir, std::function<void(uint64_t, uint64_t)> observer)
 	{
 		get_entry (key_of (type, detail, dir))->count_observers.add (observer);
+		observed[index_of (key_of (type, detail, dir))] = true;
 	}
 
 	/** Returns a potentially empty list of the last N samples, where N is determined by the 'capacity' configuration */
@@ -365,6 +434,19 @@ public:
 		return &get_entry (key_of (type, detail, dir))->samples;
 	}
 
+	/** Records how long a block or vote spent in a pipeline stage */
+	inline void latency (stat::stage stage, std::chrono::steady_clock::duration duration, uint64_t count = 1)
+	{
+		histograms[static_cast<size_t> (stage)].add (std::chrono::duration_cast<std::chrono::microseconds> (duration).count (), count);
+	}
+
+	inline chratos::stat_histogram const & histogram (stat::stage stage) const
+	{
+		return histograms[static_cast<size_t> (stage)];
+	}
+
+	static std::string stage_to_string (stat::stage stage);
+
 	/** Returns current value for the given counter at the type level */
 	inline uint64_t count (stat::type type, stat::dir dir = stat::dir::in)
 	{
@@ -374,7 +456,7 @@ public:
 	/** Returns current value for the given counter at the detail level */
 	inline uint64_t count (stat::type type, stat::detail detail, stat::dir dir = stat::dir::in)
 	{
-		return get_entry (key_of (type, detail, dir))->counter.value;
+		return count (index_of (key_of (type, detail, dir)));
 	}
 
 	/** Log counters to the given log link */
@@ -389,6 +471,9 @@ public:
 	/** Returns a new file log sink */
 	std::unique_ptr<stat_log_sink> log_sink_file (std::string filename);
 
+	/** Returns all counters and the latest sample of each entry in the Prometheus text exposition format */
+	std::string prometheus ();
+
 private:
 	static std::string type_to_string (uint32_t key);
 	static std::string detail_to_string (uint32_t key);
@@ -400,6 +485,20 @@ private:
 		return static_cast<uint8_t> (type) << 16 | static_cast<uint8_t> (detail) << 8 | static_cast<uint8_t> (dir);
 	}
 
+	/** Position of a key's counter within a shard, ordered the same as keys */
+	static inline size_t index_of (uint32_t key)
+	{
+		return ((key >> 16 & 0xff) * detail_count + (key >> 8 & 0xff)) * dir_count + (key & 0xff);
+	}
+
+	static inline uint32_t key_of_index (size_t index)
+	{
+		return static_cast<uint32_t> (index / (detail_count * dir_count) << 16 | index / dir_count % detail_count << 8 | index % dir_count);
+	}
+
+	/** Sum of the counter at index across all shards */
+	uint64_t count (size_t index);
+
 	/** Get entry for key, creating a new entry if necessary, using interval and sample count from config */
 	std::shared_ptr<chratos::stat_entry> get_entry (uint32_t key);
 
@@ -416,6 +515,9 @@ private:
 	 */
 	void update (uint32_t key, uint64_t value);
 
+	/** Samples, logs and notifies observers for an update, under the mutex */
+	void update_locked (uint32_t key, uint64_t value);
+
 	/** Unlocked implementation of log_counters() to avoid using recursive locking */
 	void log_counters_impl (stat_log_sink & sink);
 
@@ -427,6 +529,14 @@ private:
 
 	/** Stat entries are sorted by key to simplify processing of log output */
 	std::map<uint32_t, std::shared_ptr<chratos::stat_entry>> entries;
+
+	/** Counters of all shards, shard_stride apart */
+	std::unique_ptr<std::atomic<uint64_t>[]> counters { new std::atomic<uint64_t>[shard_count * shard_stride] () };
+
+	std::array<chratos::stat_histogram, stage_count> histograms;
+
+	/** Set for counters with observers, whose updates must take the mutex */
+	std::unique_ptr<std::atomic<bool>[]> observed { new std::atomic<bool>[counter_count] () };
 	std::chrono::steady_clock::time_point log_last_count_writeout { std::chrono::steady_clock::now () };
 	std::chrono::steady_clock::time_point log_last_sample_writeout { std::chrono::steady_clock::now () };
 
@@ -2,6 +2,10 @@
 
 #include <chratos/node/node.hpp>
 
+#include <map>
+
+size_t constexpr chratos::vote_generator::max_requests;
+
 chratos::vote_generator::vote_generator (chratos::node & node_a, std::chrono::milliseconds wait_a) :
 node (node_a),
 wait (wait_a),
@@ -23,6 +27,21 @@ void chratos::vote_generator::add (chratos::block_hash const & hash_a)
 	condition.notify_all ();
 }
 
+void chratos::vote_generator::add (chratos::block_hash const & hash_a, chratos::endpoint const & endpoint_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	if (requests.size () < max_requests)
+	{
+		requests.push_back (std::make_pair (hash_a, endpoint_a));
+		condition.notify_all ();
+	}
+	else
+	{
+		lock.unlock ();
+		node.stats.inc (chratos::stat::type::vote, chratos::stat::detail::generator_overflow);
+	}
+}
+
 void chratos::vote_generator::stop ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
@@ -35,22 +54,82 @@ void chratos::vote_generator::stop ()
 	}
 }
 
+std::vector<std::shared_ptr<chratos::vote>> chratos::vote_generator::generate (std::vector<chratos::block_hash> const & hashes_a)
+{
+	std::vector<std::shared_ptr<chratos::vote>> result;
+	if (!hashes_a.empty ())
+	{
+		auto transaction (node.store.tx_begin_read ());
+		node.wallets.foreach_representative (transaction, [this, &result, &hashes_a, &transaction](chratos::public_key const & pub_a, chratos::raw_key const & prv_a) {
+			result.push_back (this->node.store.vote_generate (transaction, pub_a, prv_a, hashes_a));
+		});
+	}
+	return result;
+}
+
 void chratos::vote_generator::send (std::unique_lock<std::mutex> & lock_a)
 {
 	std::vector<chratos::block_hash> hashes_l;
-	hashes_l.reserve (12);
-	while (!hashes.empty () && hashes_l.size () < 12)
+	hashes_l.reserve (chratos::vote::max_hashes);
+	while (!hashes.empty () && hashes_l.size () < chratos::vote::max_hashes)
 	{
 		hashes_l.push_back (hashes.front ());
 		hashes.pop_front ();
 	}
 	lock_a.unlock ();
+	for (auto & vote : generate (hashes_l))
 	{
-		auto transaction (node.store.tx_begin_read ());
-		node.wallets.foreach_representative (transaction, [this, &hashes_l, &transaction](chratos::public_key const & pub_a, chratos::raw_key const & prv_a) {
-			auto vote (this->node.store.vote_generate (transaction, pub_a, prv_a, hashes_l));
-			this->node.vote_processor.vote (vote, this->node.network.endpoint ());
-		});
+		node.vote_processor.vote (vote, node.network.endpoint ());
+	}
+	lock_a.lock ();
+}
+
+void chratos::vote_generator::reply (std::unique_lock<std::mutex> & lock_a)
+{
+	std::unordered_map<chratos::endpoint, std::vector<chratos::block_hash>> requested;
+	std::deque<std::pair<chratos::block_hash, chratos::endpoint>> deferred;
+	while (!requests.empty ())
+	{
+		auto & request (requests.front ());
+		auto & hashes_l (requested[request.second]);
+		if (std::find (hashes_l.begin (), hashes_l.end (), request.first) == hashes_l.end ())
+		{
+			if (hashes_l.size () >= chratos::vote::max_hashes)
+			{
+				// This endpoint's votes are full, keep its request for the next round without holding up other endpoints
+				deferred.push_back (request);
+			}
+			else
+			{
+				hashes_l.push_back (request.first);
+			}
+		}
+		requests.pop_front ();
+	}
+	requests.swap (deferred);
+	// Requesters asking about the same hashes share votes, everyone else gets votes of their own
+	std::map<std::vector<chratos::block_hash>, std::vector<chratos::endpoint>> groups;
+	for (auto & i : requested)
+	{
+		std::sort (i.second.begin (), i.second.end ());
+		groups[i.second].push_back (i.first);
+	}
+	lock_a.unlock ();
+	for (auto & group : groups)
+	{
+		for (auto & vote : generate (group.first))
+		{
+			chratos::confirm_ack confirm (vote);
+			std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
+			{
+				chratos::vectorstream stream (*bytes);
+				confirm.serialize (stream);
+			}
+			for (auto & endpoint : group.second)
+			{
+				node.network.confirm_send (confirm, bytes, endpoint);
+			}
+		}
 	}
 	lock_a.lock ();
 }
@@ -66,25 +145,36 @@ void chratos::vote_generator::run ()
 	while (!stopped)
 	{
 		auto now (std::chrono::steady_clock::now ());
-		if (hashes.size () >= 12)
+		if (hashes.size () >= chratos::vote::max_hashes)
 		{
 			send (lock);
 		}
-		else if (cutoff == min) // && hashes.size () < 12
+		else if (requests.size () >= chratos::vote::max_hashes)
+		{
+			reply (lock);
+		}
+		else if (cutoff == min) // && hashes.size () < max_hashes
 		{
 			cutoff = now + wait;
 			condition.wait_until (lock, cutoff);
 		}
-		else if (now < cutoff) // && hashes.size () < 12
+		else if (now < cutoff) // && hashes.size () < max_hashes
 		{
 			condition.wait_until (lock, cutoff);
 		}
-		else // now >= cutoff && hashes.size () < 12
+		else // now >= cutoff && hashes.size () < max_hashes
 		{
 			cutoff = min;
-			if (!hashes.empty ())
+			if (!hashes.empty () || !requests.empty ())
 			{
-				send (lock);
+				if (!hashes.empty ())
+				{
+					send (lock);
+				}
+				if (!requests.empty ())
+				{
+					reply (lock);
+				}
 			}
 			else
 			{
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chratos/lib/numbers.hpp>
+#include <chratos/node/common.hpp>
 
 #include <boost/thread.hpp>
 
@@ -11,20 +12,31 @@
 namespace chratos
 {
 class node;
+/**
+ * Aggregates block hashes in to votes of up to vote::max_hashes hashes for every local representative.
+ * Hashes added without an endpoint are voted for and republished to the network, hashes added with an
+ * endpoint are answers to confirm_req messages and each requester is only sent votes for the hashes it asked about.
+ * Requests beyond max_requests are dropped.
+ */
 class vote_generator
 {
 public:
 	vote_generator (chratos::node &, std::chrono::milliseconds);
 	void add (chratos::block_hash const &);
+	void add (chratos::block_hash const &, chratos::endpoint const &);
 	void stop ();
+	static size_t constexpr max_requests = 4096;
 
 private:
 	void run ();
 	void send (std::unique_lock<std::mutex> &);
+	void reply (std::unique_lock<std::mutex> &);
+	std::vector<std::shared_ptr<chratos::vote>> generate (std::vector<chratos::block_hash> const &);
 	chratos::node & node;
 	std::mutex mutex;
 	std::condition_variable condition;
 	std::deque<chratos::block_hash> hashes;
+	std::deque<std::pair<chratos::block_hash, chratos::endpoint>> requests;
 	std::chrono::milliseconds wait;
 	bool stopped;
 	bool started;
@@ -6,6 +6,7 @@
 #include <chratos/node/xorshift.hpp>
 
 #include <argon2.h>
+#include <blake2/blake2.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/polymorphic_cast.hpp>
@@ -179,6 +180,7 @@ bool chratos::wallet_store::rekey (chratos::transaction const & transaction_a, s
 		wallet_enc.data = encrypted;
 		wallet_key_mem.value_set (wallet_enc);
 		entry_put_raw (transaction_a, chratos::wallet_store::wallet_key_special, chratos::wallet_value (encrypted, 0));
+		kdf.clear ();
 	}
 	else
 	{
@@ -721,12 +723,65 @@ void chratos::wallet_store::upgrade_v3_v4 (chratos::transaction const & transact
 	}
 }
 
-void chratos::kdf::phs (chratos::raw_key & result_a, std::string const & password_a, chratos::uint256_union const & salt_a)
+size_t constexpr chratos::kdf::cache_max;
+
+chratos::kdf::kdf (unsigned parallel_a) :
+parallel (std::max (1u, parallel_a)),
+active (0)
+{
+}
+
+unsigned chratos::kdf::parallel_for_budget (unsigned budget_a)
+{
+	auto fits (static_cast<uint64_t> (budget_a) * 1024 / chratos::wallet_store::kdf_work);
+	return static_cast<unsigned> (std::max<uint64_t> (1, std::min<uint64_t> (fits, std::max (1u, boost::thread::hardware_concurrency ()))));
+}
+
+void chratos::kdf::phs (chratos::raw_key & result_a, std::string const & password_a, chratos::uint256_union const & salt_a, bool cache_a)
+{
+	chratos::uint256_union cache_key;
+	blake2b_state hash;
+	blake2b_init (&hash, sizeof (cache_key.bytes));
+	blake2b_update (&hash, salt_a.bytes.data (), salt_a.bytes.size ());
+	blake2b_update (&hash, password_a.data (), password_a.size ());
+	blake2b_final (&hash, cache_key.bytes.data (), sizeof (cache_key.bytes));
+	std::unique_lock<std::mutex> lock (mutex);
+	auto existing (cache.find (cache_key));
+	if (existing != cache.end ())
+	{
+		result_a = existing->second;
+	}
+	else
+	{
+		condition.wait (lock, [this]() { return active < parallel; });
+		++active;
+		lock.unlock ();
+		// The stored wallets were derived with one lane so parallelism comes from running derivations side by side
+		auto success (argon2_hash (1, chratos::wallet_store::kdf_work, 1, password_a.data (), password_a.size (), salt_a.bytes.data (), salt_a.bytes.size (), result_a.data.bytes.data (), result_a.data.bytes.size (), NULL, 0, Argon2_d, 0x10));
+		assert (success == 0);
+		(void)success;
+		lock.lock ();
+		--active;
+		if (cache_a && cache.find (cache_key) == cache.end ())
+		{
+			if (cache_order.size () >= cache_max)
+			{
+				cache.erase (cache_order.front ());
+				cache_order.pop_front ();
+			}
+			cache[cache_key] = result_a;
+			cache_order.push_back (cache_key);
+		}
+		lock.unlock ();
+		condition.notify_one ();
+	}
+}
+
+void chratos::kdf::clear ()
 {
 	std::lock_guard<std::mutex> lock (mutex);
-	auto success (argon2_hash (1, chratos::wallet_store::kdf_work, 1, password_a.data (), password_a.size (), salt_a.bytes.data (), salt_a.bytes.size (), result_a.data.bytes.data (), result_a.data.bytes.size (), NULL, 0, Argon2_d, 0x10));
-	assert (success == 0);
-	(void)success;
+	cache.clear ();
+	cache_order.clear ();
 }
 
 chratos::dividend_claim_result::dividend_claim_result (chratos::account const & account_a, chratos::block_hash const & dividend_a, chratos::block_hash const & claim_a) :
@@ -780,6 +835,15 @@ bool chratos::wallet::enter_password (chratos::transaction const & transaction_a
 			this_l->search_pending ();
 		});
 	}
+	if (!result)
+	{
+		compute_representatives (transaction_a);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock (representatives_mutex);
+		representative_keys.clear ();
+	}
 	lock_observer (result, password_a.empty ());
 	return result;
 }
@@ -794,6 +858,11 @@ chratos::public_key chratos::wallet::deterministic_insert (chratos::transaction
 		{
 			work_ensure (key, key);
 		}
+		if (!wallets.node.ledger.weight (transaction_a, key).is_zero ())
+		{
+			std::lock_guard<std::mutex> lock (representatives_mutex);
+			representatives.insert (key);
+		}
 	}
 	return key;
 }
@@ -815,6 +884,11 @@ chratos::public_key chratos::wallet::insert_adhoc (chratos::transaction const &
 		{
 			work_ensure (key, wallets.node.ledger.latest_root (transaction_a, key));
 		}
+		if (!wallets.node.ledger.weight (transaction_a, key).is_zero ())
+		{
+			std::lock_guard<std::mutex> lock (representatives_mutex);
+			representatives.insert (key);
+		}
 	}
 	return key;
 }
@@ -858,6 +932,10 @@ bool chratos::wallet::import (std::string const & json_a, std::string const & pa
 		error = store.import (transaction, *temp);
 	}
 	temp->destroy (transaction);
+	if (!error)
+	{
+		compute_representatives (transaction);
+	}
 	return error;
 }
 
@@ -1559,6 +1637,33 @@ void chratos::wallet::init_free_accounts (chratos::transaction const & transacti
 	}
 }
 
+void chratos::wallet::lock ()
+{
+	chratos::raw_key empty;
+	empty.data.clear ();
+	store.password.value_set (empty);
+	store.kdf.clear ();
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	representative_keys.clear ();
+}
+
+void chratos::wallet::compute_representatives (chratos::transaction const & transaction_a)
+{
+	std::unordered_set<chratos::account> representatives_l;
+	for (auto i (store.begin (transaction_a)), n (store.end ()); i != n; ++i)
+	{
+		chratos::account account (i->first);
+		// Ledger weight may be served from bootstrap weights, also check the actual representation
+		if (!wallets.node.ledger.weight (transaction_a, account).is_zero () || !wallets.node.store.representation_get (transaction_a, account).is_zero ())
+		{
+			representatives_l.insert (account);
+		}
+	}
+	std::lock_guard<std::mutex> lock (representatives_mutex);
+	representatives.swap (representatives_l);
+	representative_keys.clear ();
+}
+
 chratos::public_key chratos::wallet::change_seed (chratos::transaction const & transaction_a, chratos::raw_key const & prv_a)
 {
 	store.seed_set (transaction_a, prv_a);
@@ -1618,15 +1723,156 @@ void chratos::wallet::work_cache_blocking (chratos::account const & account_a, c
 	}
 }
 
+std::chrono::seconds constexpr chratos::work_precache::rescan_interval;
+
+chratos::work_precache::work_precache (chratos::wallets & wallets_a) :
+wallets (wallets_a),
+triggered (false),
+stopped (false),
+thread ([this]() {
+	chratos::thread_role::set (chratos::thread_role::name::work_precache);
+	run ();
+})
+{
+}
+
+chratos::work_precache::~work_precache ()
+{
+	stop ();
+}
+
+void chratos::work_precache::trigger ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		triggered = true;
+	}
+	condition.notify_all ();
+}
+
+void chratos::work_precache::stop ()
+{
+	boost::optional<chratos::block_hash> current_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		current_l = current;
+	}
+	condition.notify_all ();
+	if (current_l)
+	{
+		wallets.node.work.cancel (*current_l);
+	}
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+std::vector<chratos::work_precache_entry> chratos::work_precache::scan ()
+{
+	std::vector<std::shared_ptr<chratos::wallet>> wallets_l;
+	{
+		std::lock_guard<std::mutex> lock (wallets.mutex);
+		for (auto & i : wallets.items)
+		{
+			wallets_l.push_back (i.second);
+		}
+	}
+	std::vector<chratos::work_precache_entry> result;
+	auto transaction (wallets.tx_begin_read ());
+	auto dividend_head (wallets.node.store.dividend_get (transaction).head);
+	for (auto & wallet : wallets_l)
+	{
+		for (auto i (wallet->store.begin (transaction)), n (wallet->store.end ()); i != n; ++i)
+		{
+			chratos::account account (i->first);
+			// Watch-only accounts can't sign so work for them is never used
+			if (!chratos::wallet_value (i->second).key.is_zero ())
+			{
+				auto root (wallets.node.ledger.latest_root (transaction, account));
+				uint64_t cached (0);
+				wallet->store.work_get (transaction, account, cached);
+				if (chratos::work_validate (root, cached))
+				{
+					auto pending (wallets.node.store.pending_begin (transaction, chratos::pending_key (account, 0)));
+					auto urgent (pending != wallets.node.store.pending_end () && chratos::pending_key (pending->first).account == account);
+					chratos::account_info info;
+					if (!urgent && !wallets.node.store.account_get (transaction, account, info))
+					{
+						urgent = info.dividend_block != dividend_head;
+					}
+					result.push_back (chratos::work_precache_entry{ wallet, account, root, urgent });
+				}
+			}
+		}
+	}
+	std::stable_partition (result.begin (), result.end (), [](chratos::work_precache_entry const & entry_a) {
+		return entry_a.urgent;
+	});
+	return result;
+}
+
+void chratos::work_precache::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	// Wallets triggers the first scan once it has loaded its items
+	condition.wait (lock, [this]() { return stopped || triggered; });
+	while (!stopped)
+	{
+		triggered = false;
+		auto budget (wallets.node.config.work_precache_budget);
+		if (budget != 0)
+		{
+			lock.unlock ();
+			auto entries (scan ());
+			lock.lock ();
+			for (auto i (entries.begin ()), n (entries.end ()); i != n && !stopped && !triggered; ++i)
+			{
+				auto begin (std::chrono::steady_clock::now ());
+				std::promise<boost::optional<uint64_t>> promise;
+				// Queued while holding mutex so stop always sees a root it can cancel
+				wallets.node.work.generate (i->root, [&promise](boost::optional<uint64_t> const & work_a) {
+					promise.set_value (work_a);
+				},
+				chratos::work_pool::publish_threshold, chratos::work_priority::background);
+				current = i->root;
+				lock.unlock ();
+				auto work (promise.get_future ().get ());
+				auto elapsed (std::chrono::steady_clock::now () - begin);
+				if (work)
+				{
+					auto transaction (wallets.tx_begin_write ());
+					if (i->wallet->store.exists (transaction, i->account))
+					{
+						i->wallet->work_update (transaction, i->account, i->root, *work);
+					}
+				}
+				lock.lock ();
+				current = boost::none;
+				// Idle long enough that generation stays within the budget share of wall time
+				auto idle (elapsed * (100 - budget) / budget);
+				condition.wait_for (lock, idle, [this]() { return stopped; });
+			}
+		}
+		if (!stopped && !triggered)
+		{
+			condition.wait_for (lock, rescan_interval, [this]() { return stopped || triggered; });
+		}
+	}
+}
+
 chratos::wallets::wallets (bool & error_a, chratos::node & node_a) :
 observer ([](bool) {}),
+kdf (chratos::kdf::parallel_for_budget (node_a.config.kdf_memory_budget)),
 node (node_a),
 env (boost::polymorphic_downcast<chratos::mdb_store *> (node_a.store_impl.get ())->env),
 stopped (false),
 thread ([this]() {
 	chratos::thread_role::set (chratos::thread_role::name::wallet_actions);
 	do_wallet_actions ();
-})
+}),
+precache (*this)
 {
 	if (!error_a)
 	{
@@ -1650,6 +1896,7 @@ thread ([this]() {
 			if (!error)
 			{
 				items[id] = wallet;
+				wallet->compute_representatives (transaction);
 			}
 			else
 			{
@@ -1657,10 +1904,43 @@ thread ([this]() {
 			}
 		}
 	}
+	enter_initial_passwords ();
+	precache.trigger ();
+}
+
+void chratos::wallets::enter_initial_passwords ()
+{
+	std::vector<chratos::uint256_union> salts;
+	{
+		auto transaction (tx_begin_read ());
+		for (auto & i : items)
+		{
+			salts.push_back (i.second->store.salt (transaction));
+		}
+	}
+	// Populate the kdf cache in parallel so the unlocks below, which hold a write transaction each, only look keys up.
+	// Nothing else adds to the cache and it's emptied once they're done so derived keys don't outlive startup
+	std::atomic<size_t> next (0);
+	std::vector<boost::thread> threads;
+	for (size_t i (0), n (std::min<size_t> (kdf.parallel, salts.size ())); i < n; ++i)
+	{
+		threads.emplace_back ([this, &salts, &next]() {
+			for (auto index (next++); index < salts.size (); index = next++)
+			{
+				chratos::raw_key key;
+				kdf.phs (key, "", salts[index], true);
+			}
+		});
+	}
+	for (auto & thread : threads)
+	{
+		thread.join ();
+	}
 	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
 	{
 		i->second->enter_initial_password ();
 	}
+	kdf.clear ();
 }
 
 chratos::wallets::~wallets ()
@@ -1692,6 +1972,7 @@ std::shared_ptr<chratos::wallet> chratos::wallets::create (chratos::uint256_unio
 	{
 		items[id_a] = result;
 		result->enter_initial_password ();
+		precache.trigger ();
 	}
 	return result;
 }
@@ -1806,28 +2087,80 @@ void chratos::wallets::foreach_representative (chratos::transaction const & tran
 	for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
 	{
 		auto & wallet (*i->second);
-		for (auto j (wallet.store.begin (transaction_a)), m (wallet.store.end ()); j != m; ++j)
+		std::vector<std::pair<chratos::account, chratos::raw_key>> representatives_l;
+		auto locked (false);
 		{
-			chratos::account account (j->first);
-			if (!node.ledger.weight (transaction_a, account).is_zero ())
+			// Lock order is store mutex then representatives mutex, fetching keys takes the store mutex
+			std::lock_guard<std::recursive_mutex> store_lock (wallet.store.mutex);
+			std::lock_guard<std::mutex> lock (wallet.representatives_mutex);
+			if (wallet.store.valid_password (transaction_a))
 			{
-				if (wallet.store.valid_password (transaction_a))
+				for (auto j (wallet.representatives.begin ()), m (wallet.representatives.end ()); j != m;)
 				{
-					chratos::raw_key prv;
-					auto error (wallet.store.fetch (transaction_a, chratos::uint256_union (j->first), prv));
-					assert (!error);
-					action_a (chratos::uint256_union (j->first), prv);
-				}
-				else
-				{
-					static auto last_log = std::chrono::steady_clock::time_point ();
-					if (last_log < std::chrono::steady_clock::now () - std::chrono::seconds (60))
+					if (!wallet.store.exists (transaction_a, *j))
+					{
+						wallet.representative_keys.erase (*j);
+						j = wallet.representatives.erase (j);
+					}
+					else if (node.ledger.weight (transaction_a, *j).is_zero ())
+					{
+						wallet.representative_keys.erase (*j);
+						++j;
+					}
+					else
 					{
-						last_log = std::chrono::steady_clock::now ();
-						BOOST_LOG (node.log) << boost::str (boost::format ("Representative locked inside wallet %1%") % i->first.to_string ());
+						auto existing (wallet.representative_keys.find (*j));
+						if (existing == wallet.representative_keys.end ())
+						{
+							chratos::raw_key prv;
+							auto error (wallet.store.fetch (transaction_a, *j, prv));
+							assert (!error);
+							existing = wallet.representative_keys.insert (std::make_pair (*j, prv)).first;
+						}
+						representatives_l.push_back (*existing);
+						++j;
 					}
 				}
 			}
+			else
+			{
+				wallet.representative_keys.clear ();
+				for (auto j (wallet.representatives.begin ()), m (wallet.representatives.end ()); !locked && j != m; ++j)
+				{
+					locked = !node.ledger.weight (transaction_a, *j).is_zero ();
+				}
+			}
+		}
+		if (locked)
+		{
+			static auto last_log = std::chrono::steady_clock::time_point ();
+			if (last_log < std::chrono::steady_clock::now () - std::chrono::seconds (60))
+			{
+				last_log = std::chrono::steady_clock::now ();
+				BOOST_LOG (node.log) << boost::str (boost::format ("Representative locked inside wallet %1%") % i->first.to_string ());
+			}
+		}
+		for (auto & representative : representatives_l)
+		{
+			action_a (representative.first, representative.second);
+		}
+	}
+}
+
+void chratos::wallets::representative_update (chratos::account const & representative_a)
+{
+	if (!representative_a.is_zero ())
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto transaction (tx_begin_read ());
+		for (auto i (items.begin ()), n (items.end ()); i != n; ++i)
+		{
+			auto & wallet (*i->second);
+			std::lock_guard<std::mutex> representatives_lock (wallet.representatives_mutex);
+			if (wallet.representatives.find (representative_a) == wallet.representatives.end () && wallet.store.exists (transaction, representative_a))
+			{
+				wallet.representatives.insert (representative_a);
+			}
 		}
 	}
 }
@@ -1854,6 +2187,7 @@ void chratos::wallets::stop ()
 	{
 		thread.join ();
 	}
+	precache.stop ();
 }
 
 chratos::transaction chratos::wallets::tx_begin_write ()
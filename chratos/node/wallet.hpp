@@ -7,6 +7,7 @@
 #include <chratos/secure/blockstore.hpp>
 #include <chratos/secure/common.hpp>
 
+#include <deque>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -28,11 +29,29 @@ private:
 	void value_get (chratos::raw_key &);
 };
 class node_config;
+/**
+ * Derives wallet keys from passwords with argon2.
+ * Up to parallel derivations run at once, each holding kdf_work KiB, and recent results are kept so deriving the
+ * same password and salt again is immediate
+ */
 class kdf
 {
 public:
-	void phs (chratos::raw_key &, std::string const &, chratos::uint256_union const &);
+	kdf (unsigned = 1);
+	/** Derives the key, keeping the result for later calls when asked to. Cached results are used either way */
+	void phs (chratos::raw_key &, std::string const &, chratos::uint256_union const &, bool = false);
+	/** Number of derivations that fit in a memory budget given in MiB */
+	static unsigned parallel_for_budget (unsigned);
+	/** Drops every cached derivation, called once the startup unlocks are done and when a wallet is locked or its password changes */
+	void clear ();
 	std::mutex mutex;
+	std::condition_variable condition;
+	unsigned parallel;
+	unsigned active;
+	// Keys derived ahead of the startup unlocks, indexed by a hash of the salt and password. Cleared once startup is done
+	std::unordered_map<chratos::uint256_union, chratos::raw_key> cache;
+	std::deque<chratos::uint256_union> cache_order;
+	static size_t constexpr cache_max = 1024;
 };
 class dividend_claim_result
 {
@@ -173,12 +192,53 @@ public:
 	/** Changes the wallet seed and returns the first account */
 	chratos::public_key change_seed (chratos::transaction const & transaction_a, chratos::raw_key const & prv_a);
 	bool live ();
+	void lock ();
+	void compute_representatives (chratos::transaction const &);
 	std::unordered_set<chratos::account> free_accounts;
+	/** Accounts in this wallet which hold, or have been assigned, voting weight */
+	std::unordered_set<chratos::account> representatives;
+	/** Decrypted keys of weighted representatives, only populated while the wallet is unlocked */
+	std::unordered_map<chratos::account, chratos::raw_key> representative_keys;
+	std::mutex representatives_mutex;
 	std::function<void(bool, bool)> lock_observer;
 	chratos::wallet_store store;
 	chratos::wallets & wallets;
 };
 class node;
+class work_precache_entry
+{
+public:
+	std::shared_ptr<chratos::wallet> wallet;
+	chratos::account account;
+	chratos::block_hash root;
+	// Account has blocks to receive or dividends to claim, so its next block is likely soon
+	bool urgent;
+};
+/**
+ * Keeps valid work cached for the current root of every wallet account so receives and dividend claims rarely wait
+ * on generation. Work is requested one root at a time at background priority and the thread idles between requests
+ * so precomputing uses at most work_precache_budget percent of the time
+ */
+class work_precache
+{
+public:
+	work_precache (chratos::wallets &);
+	~work_precache ();
+	/** Requests a rescan of wallet accounts, coalesced with any pending request */
+	void trigger ();
+	void stop ();
+	/** Wallet accounts whose cached work does not match their current root, urgent accounts first */
+	std::vector<chratos::work_precache_entry> scan ();
+	void run ();
+	chratos::wallets & wallets;
+	std::mutex mutex;
+	std::condition_variable condition;
+	boost::optional<chratos::block_hash> current;
+	bool triggered;
+	bool stopped;
+	boost::thread thread;
+	static std::chrono::seconds constexpr rescan_interval = (chratos::chratos_network == chratos::chratos_networks::chratos_test_network) ? std::chrono::seconds (1) : std::chrono::seconds (60);
+};
 
 /**
  * The wallets set is all the wallets a node controls.
@@ -199,9 +259,13 @@ public:
 	void do_wallet_actions ();
 	void queue_wallet_action (chratos::uint128_t const &, std::shared_ptr<chratos::wallet>, std::function<void(chratos::wallet &)> const &);
 	void foreach_representative (chratos::transaction const &, std::function<void(chratos::public_key const &, chratos::raw_key const &)> const &);
+	/** Adds the account to the representatives of any wallet holding it, opens its own read transaction */
+	void representative_update (chratos::account const &);
 	bool exists (chratos::transaction const &, chratos::public_key const &);
 	void stop ();
 	void clear_send_ids (chratos::transaction const &);
+	/** Unlocks every wallet with the empty password, deriving their keys on a thread pool first */
+	void enter_initial_passwords ();
 	std::function<void(bool)> observer;
 	std::unordered_map<chratos::uint256_union, std::shared_ptr<chratos::wallet>> items;
 	std::multimap<chratos::uint128_t, std::pair<std::shared_ptr<chratos::wallet>, std::function<void(chratos::wallet &)>>, std::greater<chratos::uint128_t>> actions;
@@ -215,6 +279,7 @@ public:
 	chratos::mdb_env & env;
 	bool stopped;
 	boost::thread thread;
+	chratos::work_precache precache;
 	static chratos::uint128_t const generate_priority;
 	static chratos::uint128_t const high_priority;
 
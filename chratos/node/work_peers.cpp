@@ -0,0 +1,372 @@
+#include <chratos/node/work_peers.hpp>
+
+#include <chratos/node/node.hpp>
+
+#include <boost/beast.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+double constexpr chratos::work_peer_client::average_weight;
+double constexpr chratos::work_peer_client::initial_failure_rate;
+double constexpr chratos::work_peer_client::race_confidence;
+size_t constexpr chratos::work_peer_client::race_max;
+size_t constexpr chratos::work_peer_client::idle_max;
+unsigned constexpr chratos::work_peer_client::failures_before_backoff;
+std::chrono::minutes constexpr chratos::work_peer_client::resolve_interval;
+std::chrono::seconds constexpr chratos::work_peer_client::backoff_max;
+
+chratos::work_peer::work_peer (std::string const & host_a, uint16_t port_a) :
+host (host_a),
+port (port_a),
+latency (0.0),
+failure_rate (chratos::work_peer_client::initial_failure_rate),
+consecutive_failures (0)
+{
+}
+
+double chratos::work_peer::score () const
+{
+	// The millisecond floor keeps unmeasured peers ordered by failure rate while still trying them before measured ones
+	return (latency + 1.0) / std::max (1.0 - failure_rate, 0.01);
+}
+
+chratos::work_peer_request::work_peer_request () :
+timeout ({ std::numeric_limits<uint32_t>::max (), 0 }),
+closed (false)
+{
+}
+
+void chratos::work_peer_request::close ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	closed = true;
+	if (socket != nullptr)
+	{
+		boost::system::error_code ignored;
+		socket->close (ignored);
+		socket = nullptr;
+	}
+}
+
+bool chratos::work_peer_request::attach (std::shared_ptr<boost::asio::ip::tcp::socket> socket_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	if (!closed)
+	{
+		socket = socket_a;
+	}
+	return closed;
+}
+
+bool chratos::work_peer_request::detach ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	socket = nullptr;
+	return closed;
+}
+
+chratos::work_peer_client::work_peer_client (chratos::node & node_a) :
+node (node_a),
+resolver (node_a.service),
+deadline (chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? std::chrono::milliseconds (5000) : std::chrono::milliseconds (15000)),
+timeout (chratos::chratos_network == chratos::chratos_networks::chratos_test_network ? std::chrono::milliseconds (10000) : std::chrono::milliseconds (60000))
+{
+}
+
+std::vector<std::shared_ptr<chratos::work_peer>> chratos::work_peer_client::select ()
+{
+	std::vector<std::shared_ptr<chratos::work_peer>> result;
+	auto now (std::chrono::steady_clock::now ());
+	std::lock_guard<std::mutex> lock (mutex);
+	decltype (peers) peers_l;
+	for (auto & i : node.config.work_peers)
+	{
+		auto existing (peers.find (i));
+		peers_l[i] = existing != peers.end () ? existing->second : std::make_shared<chratos::work_peer> (i.first, i.second);
+	}
+	peers.swap (peers_l);
+	for (auto & i : peers)
+	{
+		if (i.second->retry_after <= now)
+		{
+			result.push_back (i.second);
+		}
+	}
+	std::sort (result.begin (), result.end (), [](std::shared_ptr<chratos::work_peer> const & lhs, std::shared_ptr<chratos::work_peer> const & rhs) {
+		return lhs->score () < rhs->score ();
+	});
+	return result;
+}
+
+size_t chratos::work_peer_client::race_count (std::vector<std::shared_ptr<chratos::work_peer>> const & peers_a)
+{
+	size_t result (0);
+	auto all_fail (1.0);
+	std::lock_guard<std::mutex> lock (mutex);
+	// Add peers best first until the chance that every raced peer fails is small enough
+	while (result < peers_a.size () && result < race_max && 1.0 - all_fail < race_confidence)
+	{
+		all_fail *= peers_a[result]->failure_rate;
+		++result;
+	}
+	return result;
+}
+
+void chratos::work_peer_client::success (std::shared_ptr<chratos::work_peer> peer_a, std::chrono::steady_clock::duration latency_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto latency_l (std::chrono::duration<double, std::milli> (latency_a).count ());
+	peer_a->latency = peer_a->latency == 0.0 ? latency_l : peer_a->latency + average_weight * (latency_l - peer_a->latency);
+	peer_a->failure_rate -= average_weight * peer_a->failure_rate;
+	peer_a->consecutive_failures = 0;
+	peer_a->retry_after = std::chrono::steady_clock::time_point ();
+}
+
+void chratos::work_peer_client::failure (std::shared_ptr<chratos::work_peer> peer_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	peer_a->failure_rate += average_weight * (1.0 - peer_a->failure_rate);
+	++peer_a->consecutive_failures;
+	// Resolve again next time in case the peer moved
+	peer_a->endpoints.clear ();
+	if (peer_a->consecutive_failures >= failures_before_backoff)
+	{
+		auto backoff (std::min<std::chrono::seconds> (std::chrono::seconds (1u << std::min (peer_a->consecutive_failures - failures_before_backoff, 16u)), backoff_max));
+		peer_a->retry_after = std::chrono::steady_clock::now () + backoff;
+	}
+}
+
+void chratos::work_peer_client::stop ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	for (auto & i : peers)
+	{
+		for (auto & socket : i.second->idle)
+		{
+			boost::system::error_code ignored;
+			socket->close (ignored);
+		}
+		i.second->idle.clear ();
+	}
+}
+
+void chratos::work_peer_client::resolve (std::shared_ptr<chratos::work_peer> peer_a, std::function<void(bool)> callback_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	if (!peer_a->endpoints.empty () && std::chrono::steady_clock::now () - peer_a->resolved < resolve_interval)
+	{
+		lock.unlock ();
+		callback_a (false);
+	}
+	else
+	{
+		boost::system::error_code ec;
+		auto address (boost::asio::ip::address::from_string (peer_a->host, ec));
+		if (!ec)
+		{
+			peer_a->endpoints.assign (1, chratos::tcp_endpoint (address, peer_a->port));
+			peer_a->resolved = std::chrono::steady_clock::now ();
+			lock.unlock ();
+			callback_a (false);
+		}
+		else
+		{
+			lock.unlock ();
+			auto node_l (node.shared ());
+			resolver.async_resolve (boost::asio::ip::tcp::resolver::query (peer_a->host, std::to_string (peer_a->port)), [node_l, peer_a, callback_a](boost::system::error_code const & ec, boost::asio::ip::tcp::resolver::iterator i_a) {
+				auto error (!!ec);
+				if (!error)
+				{
+					std::lock_guard<std::mutex> lock (node_l->work_peers.mutex);
+					peer_a->endpoints.clear ();
+					for (auto i (i_a), n (boost::asio::ip::tcp::resolver::iterator{}); i != n; ++i)
+					{
+						peer_a->endpoints.push_back (i->endpoint ());
+					}
+					peer_a->resolved = std::chrono::steady_clock::now ();
+					error = peer_a->endpoints.empty ();
+				}
+				else
+				{
+					BOOST_LOG (node_l->log) << boost::str (boost::format ("Error resolving work peer: %1%:%2%: %3%") % peer_a->host % peer_a->port % ec.message ());
+				}
+				callback_a (error);
+			});
+		}
+	}
+}
+
+void chratos::work_peer_client::connect (std::shared_ptr<chratos::work_peer> peer_a, std::shared_ptr<chratos::work_peer_request> request_a, std::function<void(std::shared_ptr<boost::asio::ip::tcp::socket>, bool)> callback_a)
+{
+	std::shared_ptr<boost::asio::ip::tcp::socket> idle;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		if (!peer_a->idle.empty ())
+		{
+			idle = peer_a->idle.front ();
+			peer_a->idle.pop_front ();
+		}
+	}
+	if (idle != nullptr)
+	{
+		if (!request_a->attach (idle))
+		{
+			callback_a (idle, true);
+		}
+		else
+		{
+			{
+				std::lock_guard<std::mutex> lock (mutex);
+				peer_a->idle.push_front (idle);
+			}
+			callback_a (nullptr, false);
+		}
+	}
+	else
+	{
+		auto node_l (node.shared ());
+		resolve (peer_a, [node_l, peer_a, request_a, callback_a](bool error_a) {
+			auto socket (std::make_shared<boost::asio::ip::tcp::socket> (node_l->service));
+			if (!error_a && !request_a->attach (socket))
+			{
+				auto endpoints (std::make_shared<std::vector<chratos::tcp_endpoint>> ());
+				{
+					std::lock_guard<std::mutex> lock (node_l->work_peers.mutex);
+					*endpoints = peer_a->endpoints;
+				}
+				boost::asio::async_connect (*socket, endpoints->begin (), endpoints->end (), [node_l, peer_a, socket, endpoints, callback_a](boost::system::error_code const & ec, std::vector<chratos::tcp_endpoint>::iterator) {
+					if (!ec)
+					{
+						callback_a (socket, false);
+					}
+					else
+					{
+						BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable to connect to work_peer %1% %2%: %3% (%4%)") % peer_a->host % peer_a->port % ec.message () % ec.value ());
+						callback_a (nullptr, false);
+					}
+				});
+			}
+			else
+			{
+				callback_a (nullptr, false);
+			}
+		});
+	}
+}
+
+std::shared_ptr<chratos::work_peer_request> chratos::work_peer_client::request (std::shared_ptr<chratos::work_peer> peer_a, boost::property_tree::ptree const & request_a, std::function<void(boost::optional<std::string> const &)> callback_a)
+{
+	std::stringstream ostream;
+	boost::property_tree::write_json (ostream, request_a);
+	auto body (std::make_shared<std::string> (ostream.str ()));
+	auto node_l (node.shared ());
+	auto result (std::make_shared<chratos::work_peer_request> ());
+	std::weak_ptr<chratos::work_peer_request> request_w (result);
+	result->timeout = node.alarm.add (std::chrono::steady_clock::now () + timeout, [request_w]() {
+		if (auto request_l = request_w.lock ())
+		{
+			request_l->close ();
+		}
+	});
+	auto callback_l ([node_l, result, callback_a](boost::optional<std::string> const & body_a) {
+		node_l->alarm.cancel (result->timeout);
+		callback_a (body_a);
+	});
+	connect (peer_a, result, [node_l, peer_a, result, body, callback_l](std::shared_ptr<boost::asio::ip::tcp::socket> socket_a, bool reused_a) {
+		if (socket_a != nullptr)
+		{
+			node_l->work_peers.exchange (peer_a, result, socket_a, reused_a, body, callback_l);
+		}
+		else
+		{
+			callback_l (boost::none);
+		}
+	});
+	return result;
+}
+
+namespace
+{
+class work_peer_exchange
+{
+public:
+	boost::beast::http::request<boost::beast::http::string_body> request;
+	boost::beast::flat_buffer buffer;
+	boost::beast::http::response<boost::beast::http::string_body> response;
+};
+}
+
+void chratos::work_peer_client::exchange (std::shared_ptr<chratos::work_peer> peer_a, std::shared_ptr<chratos::work_peer_request> request_a, std::shared_ptr<boost::asio::ip::tcp::socket> socket_a, bool reused_a, std::shared_ptr<std::string> body_a, std::function<void(boost::optional<std::string> const &)> callback_a)
+{
+	auto node_l (node.shared ());
+	auto exchange_l (std::make_shared<work_peer_exchange> ());
+	exchange_l->request.method (boost::beast::http::verb::post);
+	exchange_l->request.target ("/");
+	exchange_l->request.version (11);
+	exchange_l->request.set (boost::beast::http::field::host, peer_a->host);
+	exchange_l->request.keep_alive (true);
+	exchange_l->request.body () = *body_a;
+	exchange_l->request.prepare_payload ();
+	// An idle connection may have been closed by the peer since it was pooled, that is only detected here so retry once on a fresh one
+	auto retry ([node_l, peer_a, request_a, socket_a, reused_a, body_a, callback_a]() {
+		boost::system::error_code ignored;
+		socket_a->close (ignored);
+		if (reused_a && !request_a->detach ())
+		{
+			node_l->work_peers.connect (peer_a, request_a, [node_l, peer_a, request_a, body_a, callback_a](std::shared_ptr<boost::asio::ip::tcp::socket> socket_a, bool reused_a) {
+				if (socket_a != nullptr)
+				{
+					node_l->work_peers.exchange (peer_a, request_a, socket_a, reused_a, body_a, callback_a);
+				}
+				else
+				{
+					callback_a (boost::none);
+				}
+			});
+		}
+		else
+		{
+			callback_a (boost::none);
+		}
+	});
+	boost::beast::http::async_write (*socket_a, exchange_l->request, [node_l, peer_a, request_a, socket_a, exchange_l, retry, callback_a](boost::system::error_code const & ec, size_t bytes_transferred) {
+		if (!ec)
+		{
+			boost::beast::http::async_read (*socket_a, exchange_l->buffer, exchange_l->response, [node_l, peer_a, request_a, socket_a, exchange_l, retry, callback_a](boost::system::error_code const & ec, size_t bytes_transferred) {
+				if (!ec)
+				{
+					// A request closed just as the answer arrived has had its socket closed, so it can't be pooled
+					if (!request_a->detach () && exchange_l->response.keep_alive ())
+					{
+						std::lock_guard<std::mutex> lock (node_l->work_peers.mutex);
+						if (peer_a->idle.size () < chratos::work_peer_client::idle_max)
+						{
+							peer_a->idle.push_back (socket_a);
+						}
+					}
+					if (exchange_l->response.result () == boost::beast::http::status::ok)
+					{
+						callback_a (exchange_l->response.body ());
+					}
+					else
+					{
+						BOOST_LOG (node_l->log) << boost::str (boost::format ("Work peer responded with an error %1% %2%: %3%") % peer_a->host % peer_a->port % exchange_l->response.result ());
+						callback_a (boost::none);
+					}
+				}
+				else
+				{
+					BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable to read from work_peer %1% %2%: %3% (%4%)") % peer_a->host % peer_a->port % ec.message () % ec.value ());
+					retry ();
+				}
+			});
+		}
+		else
+		{
+			BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable to write to work_peer %1% %2%: %3% (%4%)") % peer_a->host % peer_a->port % ec.message () % ec.value ());
+			retry ();
+		}
+	});
+}
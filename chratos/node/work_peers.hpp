@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chratos/node/common.hpp>
+
+#include <chratos/lib/timer_wheel.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/optional.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chratos
+{
+class node;
+/** A configured work peer with its cached resolution, idle keep-alive connections and health */
+class work_peer
+{
+public:
+	work_peer (std::string const &, uint16_t);
+	/** Expected time for this peer to answer, inflated by its failure rate. Lower is better */
+	double score () const;
+	std::string host;
+	uint16_t port;
+	std::vector<chratos::tcp_endpoint> endpoints;
+	std::chrono::steady_clock::time_point resolved;
+	std::deque<std::shared_ptr<boost::asio::ip::tcp::socket>> idle;
+	// Moving averages of work_generate latency in milliseconds and of failures, 1 for each failed request
+	double latency;
+	double failure_rate;
+	unsigned consecutive_failures;
+	// Peers failing repeatedly are skipped until this time, then probed again
+	std::chrono::steady_clock::time_point retry_after;
+};
+/** A request in flight, closing it aborts the connection in use so its callback runs with none */
+class work_peer_request
+{
+public:
+	work_peer_request ();
+	void close ();
+	/** Returns true if the request was already closed, otherwise the socket is closed along with the request */
+	bool attach (std::shared_ptr<boost::asio::ip::tcp::socket>);
+	/** Returns true if the request was already closed, otherwise the socket is left alone by a later close */
+	bool detach ();
+	// Closes the request if it is still running when the client's timeout expires
+	chratos::timer_handle timeout;
+
+private:
+	std::mutex mutex;
+	std::shared_ptr<boost::asio::ip::tcp::socket> socket;
+	bool closed;
+};
+/**
+ * Talks to config.work_peers for distributed work generation.
+ * Peer resolution is cached, connections are kept alive between requests when the peer allows it, and every
+ * work_generate answer updates the peer's latency and failure averages which decide which peers get raced
+ */
+class work_peer_client
+{
+public:
+	work_peer_client (chratos::node &);
+	/** Healthy peers best first, synchronized with config.work_peers */
+	std::vector<std::shared_ptr<chratos::work_peer>> select ();
+	/** How many of the selected peers to race so at least one likely answers */
+	size_t race_count (std::vector<std::shared_ptr<chratos::work_peer>> const &);
+	/** Posts a JSON request to the peer and calls back with the response body, or none on any error, timeout or close */
+	std::shared_ptr<chratos::work_peer_request> request (std::shared_ptr<chratos::work_peer>, boost::property_tree::ptree const &, std::function<void(boost::optional<std::string> const &)>);
+	void success (std::shared_ptr<chratos::work_peer>, std::chrono::steady_clock::duration);
+	void failure (std::shared_ptr<chratos::work_peer>);
+	void stop ();
+	chratos::node & node;
+	std::mutex mutex;
+	std::map<std::pair<std::string, uint16_t>, std::shared_ptr<chratos::work_peer>> peers;
+	boost::asio::ip::tcp::resolver resolver;
+	// Time the raced peers get before local generation joins in
+	std::chrono::milliseconds deadline;
+	// Time a request gets to connect and be answered before it is abandoned
+	std::chrono::milliseconds timeout;
+	static double constexpr average_weight = 0.2;
+	static double constexpr initial_failure_rate = 0.2;
+	static double constexpr race_confidence = 0.99;
+	static size_t constexpr race_max = 3;
+	static size_t constexpr idle_max = 4;
+	static unsigned constexpr failures_before_backoff = 3;
+	static std::chrono::minutes constexpr resolve_interval = std::chrono::minutes (5);
+	static std::chrono::seconds constexpr backoff_max = std::chrono::seconds (5 * 60);
+
+private:
+	void resolve (std::shared_ptr<chratos::work_peer>, std::function<void(bool)>);
+	void connect (std::shared_ptr<chratos::work_peer>, std::shared_ptr<chratos::work_peer_request>, std::function<void(std::shared_ptr<boost::asio::ip::tcp::socket>, bool)>);
+	void exchange (std::shared_ptr<chratos::work_peer>, std::shared_ptr<chratos::work_peer_request>, std::shared_ptr<boost::asio::ip::tcp::socket>, bool, std::shared_ptr<std::string>, std::function<void(boost::optional<std::string> const &)>);
+};
+}
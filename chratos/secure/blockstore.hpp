@@ -219,13 +219,23 @@ public:
 	virtual chratos::store_iterator<chratos::account, chratos::uint128_union> representation_end () = 0;
 
 	virtual void unchecked_clear (chratos::transaction const &) = 0;
-	virtual void unchecked_put (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block> const &) = 0;
+	// Returns true if the (dependency, block) pair was already present
+	virtual bool unchecked_put (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block> const &) = 0;
 	virtual std::vector<std::shared_ptr<chratos::block>> unchecked_get (chratos::transaction const &, chratos::block_hash const &) = 0;
 	virtual void unchecked_del (chratos::transaction const &, chratos::block_hash const &, std::shared_ptr<chratos::block>) = 0;
-	virtual chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> unchecked_begin (chratos::transaction const &) = 0;
-	virtual chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> unchecked_begin (chratos::transaction const &, chratos::block_hash const &) = 0;
-	virtual chratos::store_iterator<chratos::block_hash, std::shared_ptr<chratos::block>> unchecked_end () = 0;
+	virtual chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> unchecked_begin (chratos::transaction const &) = 0;
+	virtual chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> unchecked_begin (chratos::transaction const &, chratos::block_hash const &) = 0;
+	virtual chratos::store_iterator<chratos::unchecked_key, chratos::unchecked_info> unchecked_end () = 0;
 	virtual size_t unchecked_count (chratos::transaction const &) = 0;
+	// Evicts the oldest arrivals until at most the given number remain, returns the number evicted
+	virtual size_t unchecked_trim (chratos::transaction const &, size_t) = 0;
+
+	virtual void bootstrap_pull_put (chratos::transaction const &, chratos::block_hash const &, chratos::pull_checkpoint const &) = 0;
+	virtual void bootstrap_pull_del (chratos::transaction const &, chratos::block_hash const &) = 0;
+	virtual void bootstrap_pull_clear (chratos::transaction const &) = 0;
+	virtual size_t bootstrap_pull_count (chratos::transaction const &) = 0;
+	virtual chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> bootstrap_pull_begin (chratos::transaction const &) = 0;
+	virtual chratos::store_iterator<chratos::block_hash, chratos::pull_checkpoint> bootstrap_pull_end () = 0;
 
 	virtual void checksum_put (chratos::transaction const &, uint64_t, uint8_t, chratos::checksum const &) = 0;
 	virtual bool checksum_get (chratos::transaction const &, uint64_t, uint8_t, chratos::checksum &) = 0;
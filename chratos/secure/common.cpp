@@ -402,6 +402,75 @@ bool chratos::pending_key::operator== (chratos::pending_key const & other_a) con
 	return account == other_a.account && hash == other_a.hash;
 }
 
+chratos::unchecked_key::unchecked_key () :
+previous (0),
+hash (0)
+{
+}
+
+chratos::unchecked_key::unchecked_key (chratos::block_hash const & previous_a, chratos::block_hash const & hash_a) :
+previous (previous_a),
+hash (hash_a)
+{
+}
+
+bool chratos::unchecked_key::operator== (chratos::unchecked_key const & other_a) const
+{
+	return previous == other_a.previous && hash == other_a.hash;
+}
+
+chratos::block_hash const & chratos::unchecked_key::key () const
+{
+	return previous;
+}
+
+chratos::unchecked_info::unchecked_info () :
+modified (0)
+{
+}
+
+chratos::unchecked_info::unchecked_info (std::shared_ptr<chratos::block> block_a, uint64_t modified_a) :
+block (block_a),
+modified (modified_a)
+{
+}
+
+void chratos::unchecked_info::serialize (chratos::stream & stream_a) const
+{
+	assert (block != nullptr);
+	// The arrival time leads so eviction can read it without deserializing the block
+	chratos::write (stream_a, modified);
+	chratos::serialize_block (stream_a, *block);
+}
+
+bool chratos::unchecked_info::deserialize (chratos::stream & stream_a)
+{
+	auto error (chratos::read (stream_a, modified));
+	if (!error)
+	{
+		block = chratos::deserialize_block (stream_a);
+		error = block == nullptr;
+	}
+	return error;
+}
+
+chratos::pull_checkpoint::pull_checkpoint () :
+account (0),
+end (0)
+{
+}
+
+chratos::pull_checkpoint::pull_checkpoint (chratos::account const & account_a, chratos::block_hash const & end_a) :
+account (account_a),
+end (end_a)
+{
+}
+
+bool chratos::pull_checkpoint::operator== (chratos::pull_checkpoint const & other_a) const
+{
+	return account == other_a.account && end == other_a.end;
+}
+
 chratos::block_info::block_info () :
 account (0),
 balance (0)
@@ -570,7 +639,7 @@ sequence (sequence_a),
 account (account_a)
 {
 	assert (blocks_a.size () > 0);
-	assert (blocks_a.size () <= 12);
+	assert (blocks_a.size () <= max_hashes);
 	for (auto hash : blocks_a)
 	{
 		blocks.push_back (hash);
@@ -590,6 +659,7 @@ std::string chratos::vote::hashes_string () const
 }
 
 const std::string chratos::vote::hash_prefix = "vote ";
+size_t constexpr chratos::vote::max_hashes;
 
 chratos::uint256_union chratos::vote::hash () const
 {
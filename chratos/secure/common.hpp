@@ -154,6 +154,44 @@ public:
 	chratos::account account;
 	chratos::amount balance;
 };
+/**
+ * Key of an unchecked block, the dependency it's waiting on followed by its own hash
+ */
+class unchecked_key
+{
+public:
+	unchecked_key ();
+	unchecked_key (chratos::block_hash const &, chratos::block_hash const &);
+	bool operator== (chratos::unchecked_key const &) const;
+	chratos::block_hash const & key () const;
+	chratos::block_hash previous;
+	chratos::block_hash hash;
+};
+/**
+ * An unchecked block and when it arrived, in seconds since epoch
+ */
+class unchecked_info
+{
+public:
+	unchecked_info ();
+	unchecked_info (std::shared_ptr<chratos::block>, uint64_t);
+	void serialize (chratos::stream &) const;
+	bool deserialize (chratos::stream &);
+	std::shared_ptr<chratos::block> block;
+	uint64_t modified;
+};
+/**
+ * Outstanding bootstrap pull, keyed by its head in the store so an interrupted attempt can resume
+ */
+class pull_checkpoint
+{
+public:
+	pull_checkpoint ();
+	pull_checkpoint (chratos::account const &, chratos::block_hash const &);
+	bool operator== (chratos::pull_checkpoint const &) const;
+	chratos::account account;
+	chratos::block_hash end;
+};
 class block_counts
 {
 public:
@@ -200,6 +238,8 @@ public:
 	// Signature of sequence + block hashes
 	chratos::signature signature;
 	static const std::string hash_prefix;
+	// Maximum number of block hashes in a vote that still fits in a single UDP datagram
+	static size_t constexpr max_hashes = 12;
 };
 enum class vote_code
 {
@@ -269,3 +309,16 @@ public:
 	std::unique_ptr<chratos::state_block> open;
 };
 }
+
+namespace std
+{
+template <>
+struct hash<::chratos::unchecked_key>
+{
+	size_t operator() (::chratos::unchecked_key const & key_a) const
+	{
+		// The block hash alone is already uniformly distributed
+		return std::hash<::chratos::block_hash> () (key_a.hash);
+	}
+};
+}
@@ -1,5 +1,4 @@
 #include <boost/multiprecision/cpp_bin_float.hpp>
-#include <boost/multiprecision/cpp_dec_float.hpp>
 #include <chratos/node/common.hpp>
 #include <chratos/node/stats.hpp>
 #include <chratos/secure/blockstore.hpp>
@@ -722,14 +721,7 @@ chratos::amount chratos::ledger::amount_for_dividend (chratos::transaction const
         chratos::amount balance_at_dividend (balance (transaction_a, front->hash ()));
         chratos::amount dividend_amount (amount (transaction_a, block_l->hash ()));
         chratos::amount total_supply (genesis_supply.number () - burned_amount.number ());
-        boost::multiprecision::cpp_bin_float_100 balance_f (balance_at_dividend.number ());
-        boost::multiprecision::cpp_bin_float_100 daf (dividend_amount.number ());
-        boost::multiprecision::cpp_bin_float_100 tsf (total_supply.number ());
-        boost::multiprecision::cpp_bin_float_100 total_f (tsf - daf);
-        boost::multiprecision::cpp_bin_float_100 proportion (balance_f / total_f);
-        boost::multiprecision::cpp_bin_float_100 reward (proportion * daf);
-
-        result = chratos::amount (static_cast<uint128_t> (reward));
+        result = dividend_share (balance_at_dividend.number (), dividend_amount.number (), total_supply.number ());
       }
     }
   }
@@ -737,6 +729,34 @@ chratos::amount chratos::ledger::amount_for_dividend (chratos::transaction const
 	return result;
 }
 
+chratos::uint128_t chratos::ledger::dividend_share (chratos::uint128_t const & balance_a, chratos::uint128_t const & dividend_a, chratos::uint128_t const & supply_a)
+{
+	// Claims must match this exactly, so the result has to stay identical to balance / (supply - dividend) * dividend in cpp_bin_float_100.
+	// Its error is far below 1 / (supply - dividend) so truncating it only differs from the exact quotient when the division has no remainder
+	chratos::uint128_t result (0);
+	chratos::uint128_t outstanding (supply_a - dividend_a);
+	if (!outstanding.is_zero ())
+	{
+		chratos::uint256_t quotient;
+		chratos::uint256_t remainder;
+		boost::multiprecision::divide_qr (chratos::uint256_t (balance_a) * dividend_a, chratos::uint256_t (outstanding), quotient, remainder);
+		if (!remainder.is_zero ())
+		{
+			result = static_cast<chratos::uint128_t> (quotient);
+		}
+		else
+		{
+			boost::multiprecision::cpp_bin_float_100 balance_f (balance_a);
+			boost::multiprecision::cpp_bin_float_100 daf (dividend_a);
+			boost::multiprecision::cpp_bin_float_100 total_f (outstanding);
+			boost::multiprecision::cpp_bin_float_100 proportion (balance_f / total_f);
+			boost::multiprecision::cpp_bin_float_100 reward (proportion * daf);
+			result = static_cast<chratos::uint128_t> (reward);
+		}
+	}
+	return result;
+}
+
 std::vector<chratos::block_hash> chratos::ledger::unclaimed_for_account (chratos::transaction const & transaction_a, chratos::account const & account_a)
 {
 	std::vector<chratos::block_hash> result;
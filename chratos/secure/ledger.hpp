@@ -41,6 +41,7 @@ public:
 	bool has_outstanding_pendings_for_dividend (chratos::transaction const &, chratos::block_hash const &, chratos::account const &);
 	bool dividends_are_ordered (chratos::transaction const &, chratos::block_hash const &, chratos::block_hash const &);
 	chratos::amount amount_for_dividend (chratos::transaction const &, chratos::block_hash const &, chratos::account const &);
+	static chratos::uint128_t dividend_share (chratos::uint128_t const &, chratos::uint128_t const &, chratos::uint128_t const &);
 	std::vector<chratos::block_hash> unclaimed_for_account (chratos::transaction const &, chratos::account const &);
 	chratos::amount burn_account_balance (chratos::transaction const &, chratos::block_hash const &);
 	std::vector<std::shared_ptr<chratos::block>> dividend_claim_blocks (chratos::transaction const &, chratos::account const &);